@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "benchutil/benchutil.h"
+
+/*
+ * Measures how many events per second can be handed from a producer to a
+ * consumer task, first through os_eventq_put() and then through an event
+ * ring.  The producer posts a burst of events, then waits for the consumer
+ * to drain them.  Each case prints a benchutil line, where one operation is
+ * one event, followed by the resulting events per second.  Intended to be
+ * run on the native BSP.
+ */
+
+#define BENCH_BURST         (32)
+
+#define PROD_PRIO           (10)
+#define CONS_PRIO           (11)
+#define BENCH_STACK_SIZE    (256)
+
+static struct os_task prod_task;
+static struct os_task cons_task;
+OS_TASK_STACK_DEFINE(prod_stack, BENCH_STACK_SIZE);
+OS_TASK_STACK_DEFINE(cons_stack, BENCH_STACK_SIZE);
+
+static struct os_eventq bench_evq;
+static struct os_eventq_ring bench_ring;
+static struct os_event *bench_ring_buf[BENCH_BURST];
+static struct os_event bench_events[BENCH_BURST];
+static struct os_sem bench_done;
+static uint32_t bench_rx_cnt;
+static uint32_t bench_rx_target;
+
+static void
+bench_ev_cb(struct os_event *ev)
+{
+    bench_rx_cnt++;
+    if (bench_rx_cnt == bench_rx_target) {
+        os_sem_release(&bench_done);
+    }
+}
+
+static void
+cons_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&bench_evq);
+    }
+}
+
+/*
+ * Posts 'iters' events in bursts of up to BENCH_BURST.  The consumer runs at
+ * a lower priority, so it only drains a burst once the producer waits.
+ */
+static void
+bench_post(uint32_t iters, int use_ring)
+{
+    uint32_t burst;
+    int rc;
+    int i;
+
+    while (iters > 0) {
+        burst = min(iters, BENCH_BURST);
+        bench_rx_target = bench_rx_cnt + burst;
+        for (i = 0; i < burst; i++) {
+            if (use_ring) {
+                rc = os_eventq_ring_put(&bench_evq, &bench_events[i]);
+                assert(rc == 0);
+            } else {
+                os_eventq_put(&bench_evq, &bench_events[i]);
+            }
+        }
+        rc = os_sem_pend(&bench_done, OS_TIMEOUT_NEVER);
+        assert(rc == 0);
+        iters -= burst;
+    }
+}
+
+static void
+eventq_put(uint32_t iters, void *arg)
+{
+    bench_post(iters, 0);
+}
+
+static void
+eventq_ring_put(uint32_t iters, void *arg)
+{
+    bench_post(iters, 1);
+}
+
+static void
+bench_report(const char *name, const struct bench_result *res)
+{
+    uint64_t evps;
+
+    evps = (uint64_t)res->br_iters * 1000000;
+    evps /= res->br_usecs ? res->br_usecs : 1;
+    console_printf("eventq_bench case=%s events_per_sec=%lu\n",
+                   name, (unsigned long)evps);
+}
+
+static void
+prod_task_handler(void *arg)
+{
+    struct bench_result res;
+
+    bench_suite_start("eventq");
+
+    bench_run("eventq_put", eventq_put, NULL, &res);
+    bench_report("eventq_put", &res);
+
+    bench_run("eventq_ring_put", eventq_ring_put, NULL, &res);
+    bench_report("eventq_ring_put", &res);
+
+    bench_suite_end();
+
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    int rc;
+    int i;
+
+    sysinit();
+
+    os_eventq_init(&bench_evq);
+    rc = os_eventq_ring_init(&bench_evq, &bench_ring, bench_ring_buf,
+                             BENCH_BURST);
+    assert(rc == 0);
+
+    for (i = 0; i < BENCH_BURST; i++) {
+        bench_events[i].ev_cb = bench_ev_cb;
+    }
+    os_sem_init(&bench_done, 0);
+
+    os_task_init(&cons_task, "cons", cons_task_handler, NULL, CONS_PRIO,
+                 OS_WAIT_FOREVER, cons_stack,
+                 OS_STACK_ALIGN(BENCH_STACK_SIZE));
+    os_task_init(&prod_task, "prod", prod_task_handler, NULL, PROD_PRIO,
+                 OS_WAIT_FOREVER, prod_stack,
+                 OS_STACK_ALIGN(BENCH_STACK_SIZE));
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "benchutil/benchutil.h"
+#include "flash_map/flash_map.h"
+#include "fcb/fcb.h"
+
+/*
+ * Appends fixed size entries to an FCB one by one, and in batches with
+ * fcb_append_batch(), and reports the time per entry:
+ *
+ *     bench suite=fcb case=<case> iters=<n> usecs=<n> ns_per_op=<n>
+ *
+ * Full sectors are rotated out as needed, so both cases pay for the same
+ * number of erases per entry.  Build with FCB_BENCH_FCB2 set to 1 (and
+ * FCB_BENCH_FCB to 0) to measure fs/fcb2.  Intended to be run on the native
+ * BSP; the buffer uses the flash the BSP sets aside for NFFS.
+ */
+
+#define BENCH_ELEM_LEN      (32)
+#define BENCH_BATCH         (16)
+#define BENCH_SECTOR_CNT    (2)
+#define BENCH_SECTOR_SIZE   (0x4000)
+#define BENCH_FLASH_OFF     (0x8000)
+
+#define BENCH_PRIO          (10)
+#define BENCH_STACK_SIZE    (1024)
+
+static struct os_task bench_task;
+OS_TASK_STACK_DEFINE(bench_stack, BENCH_STACK_SIZE);
+
+static struct fcb bench_fcb;
+static uint8_t bench_data[BENCH_ELEM_LEN];
+static struct fcb_batch_elem bench_elems[BENCH_BATCH];
+
+#if MYNEWT_VAL(FCB_BENCH_FCB)
+static struct flash_area bench_sectors[BENCH_SECTOR_CNT];
+#else
+static struct flash_sector_range bench_range = {
+    .fsr_flash_area = {
+        .fa_device_id = 0,
+        .fa_off = BENCH_FLASH_OFF,
+        .fa_size = BENCH_SECTOR_CNT * BENCH_SECTOR_SIZE,
+    },
+    .fsr_range_start = 0,
+    .fsr_first_sector = 0,
+    .fsr_sector_size = BENCH_SECTOR_SIZE,
+    .fsr_sector_count = BENCH_SECTOR_CNT,
+    .fsr_align = 1,
+};
+#endif
+
+static void
+bench_fcb_init(void)
+{
+    int rc;
+    int i;
+
+#if MYNEWT_VAL(FCB_BENCH_FCB)
+    for (i = 0; i < BENCH_SECTOR_CNT; i++) {
+        bench_sectors[i].fa_device_id = 0;
+        bench_sectors[i].fa_off = BENCH_FLASH_OFF + i * BENCH_SECTOR_SIZE;
+        bench_sectors[i].fa_size = BENCH_SECTOR_SIZE;
+        rc = flash_area_erase(&bench_sectors[i], 0, BENCH_SECTOR_SIZE);
+        assert(rc == 0);
+    }
+    bench_fcb.f_sectors = bench_sectors;
+#else
+    rc = flash_area_erase(&bench_range.fsr_flash_area, 0,
+                          bench_range.fsr_flash_area.fa_size);
+    assert(rc == 0);
+    bench_fcb.f_ranges = &bench_range;
+    bench_fcb.f_range_cnt = 1;
+#endif
+    bench_fcb.f_magic = 0x62656e63;
+    bench_fcb.f_sector_cnt = BENCH_SECTOR_CNT;
+    bench_fcb.f_scratch_cnt = 0;
+
+    rc = fcb_init(&bench_fcb);
+    assert(rc == 0);
+
+    for (i = 0; i < BENCH_ELEM_LEN; i++) {
+        bench_data[i] = i;
+    }
+    for (i = 0; i < BENCH_BATCH; i++) {
+        bench_elems[i].fbe_data = bench_data;
+        bench_elems[i].fbe_len = BENCH_ELEM_LEN;
+    }
+}
+
+/* One operation is one entry appended with fcb_append()/_finish(). */
+static void
+fcb_append_single(uint32_t iters, void *arg)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    while (iters > 0) {
+        rc = fcb_append(&bench_fcb, BENCH_ELEM_LEN, &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            rc = fcb_rotate(&bench_fcb);
+            assert(rc == 0);
+            continue;
+        }
+        assert(rc == 0);
+#if MYNEWT_VAL(FCB_BENCH_FCB)
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, bench_data,
+                              BENCH_ELEM_LEN);
+        assert(rc == 0);
+        rc = fcb_append_finish(&bench_fcb, &loc);
+#else
+        rc = fcb_write(&loc, 0, bench_data, BENCH_ELEM_LEN);
+        assert(rc == 0);
+        rc = fcb_append_finish(&loc);
+#endif
+        assert(rc == 0);
+        iters--;
+    }
+}
+
+/* One operation is one entry, appended BENCH_BATCH at a time. */
+static void
+fcb_append_batched(uint32_t iters, void *arg)
+{
+    uint32_t cnt;
+    int rc;
+
+    while (iters > 0) {
+        cnt = min(iters, BENCH_BATCH);
+        rc = fcb_append_batch(&bench_fcb, bench_elems, cnt, NULL);
+        if (rc == FCB_ERR_NOSPACE) {
+            rc = fcb_rotate(&bench_fcb);
+            assert(rc == 0);
+            continue;
+        }
+        assert(rc == 0);
+        iters -= cnt;
+    }
+}
+
+static void
+bench_task_handler(void *arg)
+{
+    bench_suite_start("fcb");
+    BENCH_RUN(fcb_append_single, NULL);
+    BENCH_RUN(fcb_append_batched, NULL);
+    bench_suite_end();
+
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    bench_fcb_init();
+
+    os_task_init(&bench_task, "bench", bench_task_handler, NULL, BENCH_PRIO,
+                 OS_WAIT_FOREVER, bench_stack,
+                 OS_STACK_ALIGN(BENCH_STACK_SIZE));
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
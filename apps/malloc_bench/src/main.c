@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "benchutil/benchutil.h"
+
+/*
+ * Measures os_malloc()/os_free() throughput with benchutil, then runs a
+ * randomized allocation workload and reports how the live memory is spread
+ * over the slab pools and the heap.  Build once with OS_MALLOC_SLAB set to 1 and once
+ * with 0 to compare.  Intended to be run on the native BSP.
+ */
+
+#define BENCH_BURST         (16)
+
+#define FRAG_SLOTS          (128)
+#define FRAG_STEPS          (100000)
+#define FRAG_MAX_SIZE       (512)
+
+#define BENCH_PRIO          (10)
+#define BENCH_STACK_SIZE    (512)
+
+static struct os_task bench_task;
+OS_TASK_STACK_DEFINE(bench_stack, BENCH_STACK_SIZE);
+
+static void *bench_ptrs[FRAG_SLOTS];
+static uint16_t bench_sizes[FRAG_SLOTS];
+static uint32_t bench_rand_state = 0x1234567;
+
+static const uint16_t bench_burst_sizes[BENCH_BURST] = {
+    8, 24, 12, 60, 16, 100, 32, 200, 4, 48, 128, 20, 64, 250, 40, 96,
+};
+
+static uint32_t
+bench_rand(void)
+{
+    /* xorshift32; deterministic so runs can be compared */
+    bench_rand_state ^= bench_rand_state << 13;
+    bench_rand_state ^= bench_rand_state >> 17;
+    bench_rand_state ^= bench_rand_state << 5;
+    return bench_rand_state;
+}
+
+/* Mostly small requests with a tail of larger ones */
+static uint16_t
+bench_rand_size(void)
+{
+    uint32_t r;
+
+    r = bench_rand();
+    if ((r & 0xf) != 0) {
+        return 1 + (r >> 4) % 128;
+    }
+    return 1 + (r >> 4) % FRAG_MAX_SIZE;
+}
+
+/* One operation is an os_malloc() and the matching os_free(). */
+static void
+os_malloc_free(uint32_t iters, void *arg)
+{
+    void *ptrs[BENCH_BURST];
+    uint32_t burst;
+    int i;
+
+    while (iters > 0) {
+        burst = min(iters, BENCH_BURST);
+        for (i = 0; i < burst; i++) {
+            ptrs[i] = os_malloc(bench_burst_sizes[i]);
+            assert(ptrs[i] != NULL);
+        }
+        for (i = 0; i < burst; i++) {
+            os_free(ptrs[i]);
+        }
+        iters -= burst;
+    }
+}
+
+static void
+bench_throughput(void)
+{
+    struct bench_result res;
+    uint64_t opps;
+
+    bench_suite_start("malloc");
+    bench_run("os_malloc_free", os_malloc_free, NULL, &res);
+    bench_suite_end();
+
+    opps = (uint64_t)res.br_iters * 2 * 1000000;
+    opps /= res.br_usecs ? res.br_usecs : 1;
+    console_printf("malloc_bench slab=%d ops_per_sec=%lu\n",
+                   MYNEWT_VAL(OS_MALLOC_SLAB), (unsigned long)opps);
+}
+
+/* Returns the slab pool holding 'ptr', or NULL if it came from the heap. */
+static struct os_mempool *
+bench_slab_pool(const void *ptr)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        if (strncmp(omi.omi_name, "malloc_", 7) == 0 &&
+            os_memblock_from(mp, ptr)) {
+            return mp;
+        }
+    }
+    return NULL;
+}
+
+static void
+bench_frag(void)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    uint32_t slab_req;
+    uint32_t slab_used;
+    uint32_t heap_req;
+    int heap_cnt;
+    int live;
+    int slot;
+    int i;
+
+    for (i = 0; i < FRAG_STEPS; i++) {
+        slot = bench_rand() % FRAG_SLOTS;
+        if (bench_ptrs[slot] != NULL) {
+            os_free(bench_ptrs[slot]);
+            bench_ptrs[slot] = NULL;
+        } else {
+            bench_sizes[slot] = bench_rand_size();
+            bench_ptrs[slot] = os_malloc(bench_sizes[slot]);
+            assert(bench_ptrs[slot] != NULL);
+            memset(bench_ptrs[slot], 0xa5, bench_sizes[slot]);
+        }
+    }
+
+    live = 0;
+    slab_req = 0;
+    slab_used = 0;
+    heap_req = 0;
+    heap_cnt = 0;
+    for (i = 0; i < FRAG_SLOTS; i++) {
+        if (bench_ptrs[i] == NULL) {
+            continue;
+        }
+        live++;
+        mp = bench_slab_pool(bench_ptrs[i]);
+        if (mp != NULL) {
+            slab_req += bench_sizes[i];
+            slab_used += mp->mp_block_size;
+        } else {
+            heap_req += bench_sizes[i];
+            heap_cnt++;
+        }
+    }
+
+    console_printf("malloc_bench frag live=%d slab_bytes=%lu slab_req=%lu "
+                   "slab_waste_pct=%lu heap_allocs=%d heap_req=%lu\n",
+                   live, (unsigned long)slab_used, (unsigned long)slab_req,
+                   slab_used ?
+                       (unsigned long)(100 * (slab_used - slab_req) /
+                                       slab_used) : 0UL,
+                   heap_cnt, (unsigned long)heap_req);
+
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        if (strncmp(omi.omi_name, "malloc_", 7) != 0) {
+            continue;
+        }
+        console_printf("malloc_bench pool %s blksz=%d cnt=%d free=%d min=%d\n",
+                       omi.omi_name, omi.omi_block_size, omi.omi_num_blocks,
+                       omi.omi_num_free, omi.omi_min_free);
+    }
+
+    for (i = 0; i < FRAG_SLOTS; i++) {
+        os_free(bench_ptrs[i]);
+        bench_ptrs[i] = NULL;
+    }
+}
+
+static void
+bench_task_handler(void *arg)
+{
+    bench_throughput();
+    bench_frag();
+
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    os_task_init(&bench_task, "bench", bench_task_handler, NULL, BENCH_PRIO,
+                 OS_WAIT_FOREVER, bench_stack,
+                 OS_STACK_ALIGN(BENCH_STACK_SIZE));
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
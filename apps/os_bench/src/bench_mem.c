@@ -0,0 +1,249 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "benchutil/benchutil.h"
+#include "os_bench.h"
+
+/* Memory pool, mbuf and os_malloc() benchmarks. */
+
+#define MEMPOOL_BLOCK_SIZE  (64)
+#define MEMPOOL_BLOCK_COUNT (16)
+
+#define MBUF_BLOCK_SIZE     (160)
+#define MBUF_BLOCK_COUNT    (16)
+
+/* Length of the packets built by the mbuf cases */
+#define MBUF_PKT_LEN        (512)
+#define MBUF_CHUNK_LEN      (64)
+#define MBUF_HDR_LEN        (8)
+
+/* Bytes moved per operation of the mbuf_kb cases */
+#define MBUF_KB_LEN         (1024)
+
+static os_membuf_t bench_mempool_buf[
+    OS_MEMPOOL_SIZE(MEMPOOL_BLOCK_COUNT, MEMPOOL_BLOCK_SIZE)];
+static struct os_mempool bench_mempool;
+
+static os_membuf_t bench_mbuf_buf[
+    OS_MEMPOOL_SIZE(MBUF_BLOCK_COUNT, MBUF_BLOCK_SIZE)];
+static struct os_mempool bench_mbuf_mempool;
+static struct os_mbuf_pool bench_mbuf_pool;
+
+static uint8_t bench_data[MBUF_KB_LEN];
+static struct os_mbuf *bench_pkt;
+
+static const uint16_t bench_malloc_sizes[8] = {
+    8, 24, 12, 60, 16, 100, 32, 200,
+};
+
+static void
+mempool_get_put(uint32_t iters, void *arg)
+{
+    void *block;
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        block = os_memblock_get(&bench_mempool);
+        assert(block != NULL);
+        os_memblock_put(&bench_mempool, block);
+    }
+}
+
+/* Builds a MBUF_PKT_LEN byte packet in MBUF_CHUNK_LEN byte writes. */
+static struct os_mbuf *
+bench_pkt_build(void)
+{
+    struct os_mbuf *om;
+    int rc;
+    int off;
+
+    om = os_mbuf_get_pkthdr(&bench_mbuf_pool, 0);
+    assert(om != NULL);
+    for (off = 0; off < MBUF_PKT_LEN; off += MBUF_CHUNK_LEN) {
+        rc = os_mbuf_append(om, bench_data + off, MBUF_CHUNK_LEN);
+        assert(rc == 0);
+    }
+
+    return om;
+}
+
+static void
+mbuf_append(uint32_t iters, void *arg)
+{
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        os_mbuf_free_chain(bench_pkt_build());
+    }
+}
+
+/*
+ * Pulls a header and the start of the payload, held in separate mbufs, into
+ * the first mbuf.  Includes building the two mbuf chain.
+ */
+static void
+mbuf_pullup(uint32_t iters, void *arg)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *payload;
+    uint32_t i;
+    int rc;
+
+    for (i = 0; i < iters; i++) {
+        om = os_mbuf_get_pkthdr(&bench_mbuf_pool, 0);
+        assert(om != NULL);
+        rc = os_mbuf_append(om, bench_data, MBUF_HDR_LEN);
+        assert(rc == 0);
+
+        payload = os_mbuf_get(&bench_mbuf_pool, 0);
+        assert(payload != NULL);
+        rc = os_mbuf_append(payload, bench_data, MBUF_CHUNK_LEN);
+        assert(rc == 0);
+        os_mbuf_concat(om, payload);
+
+        om = os_mbuf_pullup(om, MBUF_HDR_LEN + MBUF_CHUNK_LEN);
+        assert(om != NULL);
+        os_mbuf_free_chain(om);
+    }
+}
+
+/*
+ * Copies 1 KB into a chain built and freed one mbuf at a time, the way
+ * callers had to before os_mbuf_get_chain().  ns_per_op is ns per KB.
+ */
+static void
+mbuf_kb_single(uint32_t iters, void *arg)
+{
+    struct os_mbuf *head;
+    struct os_mbuf *last;
+    struct os_mbuf *om;
+    struct os_mbuf *next;
+    uint32_t i;
+    int off;
+
+    for (i = 0; i < iters; i++) {
+        head = NULL;
+        last = NULL;
+        for (off = 0; off < MBUF_KB_LEN; off += om->om_len) {
+            om = os_mbuf_get(&bench_mbuf_pool, 0);
+            assert(om != NULL);
+            om->om_len = min(OS_MBUF_TRAILINGSPACE(om), MBUF_KB_LEN - off);
+            memcpy(om->om_data, bench_data + off, om->om_len);
+            if (last != NULL) {
+                SLIST_NEXT(last, om_next) = om;
+            } else {
+                head = om;
+            }
+            last = om;
+        }
+
+        for (om = head; om != NULL; om = next) {
+            next = SLIST_NEXT(om, om_next);
+            os_mbuf_free(om);
+        }
+    }
+}
+
+/*
+ * The same with os_mbuf_append(), which allocates the chain in bulk, and
+ * os_mbuf_free_chain(), which frees it in bulk.  ns_per_op is ns per KB.
+ */
+static void
+mbuf_kb_bulk(uint32_t iters, void *arg)
+{
+    struct os_mbuf *om;
+    uint32_t i;
+    int rc;
+
+    for (i = 0; i < iters; i++) {
+        om = os_mbuf_get(&bench_mbuf_pool, 0);
+        assert(om != NULL);
+        rc = os_mbuf_append(om, bench_data, MBUF_KB_LEN);
+        assert(rc == 0);
+        os_mbuf_free_chain(om);
+    }
+}
+
+static void
+mbuf_dup(uint32_t iters, void *arg)
+{
+    struct os_mbuf *om;
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        om = os_mbuf_dup(bench_pkt);
+        assert(om != NULL);
+        os_mbuf_free_chain(om);
+    }
+}
+
+static void
+os_malloc_free(uint32_t iters, void *arg)
+{
+    void *ptr;
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        ptr = os_malloc(bench_malloc_sizes[i % 8]);
+        assert(ptr != NULL);
+        os_free(ptr);
+    }
+}
+
+void
+os_bench_mem_init(void)
+{
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&bench_mempool, MEMPOOL_BLOCK_COUNT,
+                         MEMPOOL_BLOCK_SIZE, bench_mempool_buf, "bench");
+    assert(rc == 0);
+
+    rc = os_mempool_init(&bench_mbuf_mempool, MBUF_BLOCK_COUNT,
+                         MBUF_BLOCK_SIZE, bench_mbuf_buf, "bench_mbuf");
+    assert(rc == 0);
+    rc = os_mbuf_pool_init(&bench_mbuf_pool, &bench_mbuf_mempool,
+                           MBUF_BLOCK_SIZE, MBUF_BLOCK_COUNT);
+    assert(rc == 0);
+
+    for (i = 0; i < sizeof(bench_data); i++) {
+        bench_data[i] = i;
+    }
+}
+
+void
+os_bench_mem_run(void)
+{
+    BENCH_RUN(mempool_get_put, NULL);
+    BENCH_RUN(mbuf_append, NULL);
+    BENCH_RUN(mbuf_pullup, NULL);
+    BENCH_RUN(mbuf_kb_single, NULL);
+    BENCH_RUN(mbuf_kb_bulk, NULL);
+
+    bench_pkt = bench_pkt_build();
+    BENCH_RUN(mbuf_dup, NULL);
+    os_mbuf_free_chain(bench_pkt);
+    bench_pkt = NULL;
+
+    BENCH_RUN(os_malloc_free, NULL);
+}
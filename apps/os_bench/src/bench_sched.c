@@ -0,0 +1,255 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "benchutil/benchutil.h"
+#include "os_bench.h"
+
+/*
+ * Scheduler, synchronization and timer benchmarks.  Cases involving two
+ * tasks report the time of a complete round trip, i.e., two context
+ * switches.
+ */
+
+#define BENCH_CALLOUTS      (16)
+
+static struct os_sem ping_sem;
+static struct os_sem pong_sem;
+static struct os_mutex bench_mtx;
+
+static struct os_eventq req_evq;
+static struct os_eventq rsp_evq;
+static struct os_event req_ev;
+static struct os_event rsp_ev;
+
+static struct os_eventq callout_evq;
+static struct os_callout bench_callout;
+static struct os_callout bg_callouts[BENCH_CALLOUTS];
+static uint32_t callout_fired;
+
+static void
+partner_ctx_sw(uint32_t iters)
+{
+    os_sr_t sr;
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        OS_ENTER_CRITICAL(sr);
+        os_sched_sleep(os_sched_get_current_task(), OS_TIMEOUT_NEVER);
+        OS_EXIT_CRITICAL(sr);
+        os_sched(NULL);
+    }
+}
+
+/* Bare context switch: wake up the sleeping partner task. */
+static void
+ctx_sw_rtt(uint32_t iters, void *arg)
+{
+    os_sr_t sr;
+    uint32_t i;
+
+    os_bench_partner_start(partner_ctx_sw, iters);
+    for (i = 0; i < iters; i++) {
+        OS_ENTER_CRITICAL(sr);
+        os_sched_wakeup(&os_bench_partner_task);
+        OS_EXIT_CRITICAL(sr);
+        os_sched(NULL);
+    }
+    os_bench_partner_wait();
+}
+
+static void
+partner_sem(uint32_t iters)
+{
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        os_sem_pend(&ping_sem, OS_TIMEOUT_NEVER);
+        os_sem_release(&pong_sem);
+    }
+}
+
+static void
+sem_handoff(uint32_t iters, void *arg)
+{
+    uint32_t i;
+
+    os_bench_partner_start(partner_sem, iters);
+    for (i = 0; i < iters; i++) {
+        os_sem_release(&ping_sem);
+        os_sem_pend(&pong_sem, OS_TIMEOUT_NEVER);
+    }
+    os_bench_partner_wait();
+}
+
+static void
+partner_mutex(uint32_t iters)
+{
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        os_sem_pend(&ping_sem, OS_TIMEOUT_NEVER);
+        os_mutex_pend(&bench_mtx, OS_TIMEOUT_NEVER);
+        os_mutex_release(&bench_mtx);
+    }
+}
+
+/*
+ * The partner task blocks on the mutex held by the benchmark task, which
+ * then hands the mutex over by releasing it.
+ */
+static void
+mutex_handoff(uint32_t iters, void *arg)
+{
+    uint32_t i;
+
+    os_bench_partner_start(partner_mutex, iters);
+    for (i = 0; i < iters; i++) {
+        os_mutex_pend(&bench_mtx, OS_TIMEOUT_NEVER);
+        os_sem_release(&ping_sem);
+        os_mutex_release(&bench_mtx);
+    }
+    os_bench_partner_wait();
+}
+
+static void
+eventq_put_get(uint32_t iters, void *arg)
+{
+    struct os_event *ev;
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        os_eventq_put(&req_evq, &req_ev);
+        ev = os_eventq_get_no_wait(&req_evq);
+        assert(ev == &req_ev);
+    }
+}
+
+static void
+partner_eventq(uint32_t iters)
+{
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        os_eventq_get(&req_evq);
+        os_eventq_put(&rsp_evq, &rsp_ev);
+    }
+}
+
+static void
+eventq_rtt(uint32_t iters, void *arg)
+{
+    struct os_event *ev;
+    uint32_t i;
+
+    os_bench_partner_start(partner_eventq, iters);
+    for (i = 0; i < iters; i++) {
+        os_eventq_put(&req_evq, &req_ev);
+        ev = os_eventq_get(&rsp_evq);
+        assert(ev == &rsp_ev);
+    }
+    os_bench_partner_wait();
+}
+
+/*
+ * Re-arms a callout while BENCH_CALLOUTS others, with deadlines on both
+ * sides of it, are pending.
+ */
+static void
+callout_reset(uint32_t iters, void *arg)
+{
+    uint32_t i;
+    int j;
+
+    for (j = 0; j < BENCH_CALLOUTS; j++) {
+        os_callout_reset(&bg_callouts[j], OS_TICKS_PER_SEC * (j + 1));
+    }
+    for (i = 0; i < iters; i++) {
+        os_callout_reset(&bench_callout,
+                         OS_TICKS_PER_SEC * BENCH_CALLOUTS / 2);
+    }
+    os_callout_stop(&bench_callout);
+    for (j = 0; j < BENCH_CALLOUTS; j++) {
+        os_callout_stop(&bg_callouts[j]);
+    }
+}
+
+static void
+callout_cb(struct os_event *ev)
+{
+    callout_fired++;
+}
+
+/*
+ * Arms a callout for the next tick, moves OS time forward by one tick and
+ * runs the expired callout's event.  OS time runs ahead of the wall clock by
+ * one tick per iteration; durations are measured with os_cputime (or the
+ * host clock on sim), which does not follow OS time.
+ */
+static void
+callout_expiry(uint32_t iters, void *arg)
+{
+    struct os_event *ev;
+    os_sr_t sr;
+    uint32_t i;
+
+    for (i = 0; i < iters; i++) {
+        os_callout_reset(&bench_callout, 1);
+
+        OS_ENTER_CRITICAL(sr);
+        os_time_advance(1);
+        OS_EXIT_CRITICAL(sr);
+
+        ev = os_eventq_get_no_wait(&callout_evq);
+        assert(ev == &bench_callout.c_ev);
+        ev->ev_cb(ev);
+    }
+}
+
+void
+os_bench_sched_init(void)
+{
+    int j;
+
+    os_sem_init(&ping_sem, 0);
+    os_sem_init(&pong_sem, 0);
+    os_mutex_init(&bench_mtx);
+
+    os_eventq_init(&req_evq);
+    os_eventq_init(&rsp_evq);
+
+    os_eventq_init(&callout_evq);
+    os_callout_init(&bench_callout, &callout_evq, callout_cb, NULL);
+    for (j = 0; j < BENCH_CALLOUTS; j++) {
+        os_callout_init(&bg_callouts[j], &callout_evq, callout_cb, NULL);
+    }
+}
+
+void
+os_bench_sched_run(void)
+{
+    BENCH_RUN(ctx_sw_rtt, NULL);
+    BENCH_RUN(sem_handoff, NULL);
+    BENCH_RUN(mutex_handoff, NULL);
+    BENCH_RUN(eventq_put_get, NULL);
+    BENCH_RUN(eventq_rtt, NULL);
+    BENCH_RUN(callout_reset, NULL);
+    BENCH_RUN(callout_expiry, NULL);
+}
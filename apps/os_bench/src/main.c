@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "os/mynewt.h"
+#include "benchutil/benchutil.h"
+#include "os_bench.h"
+
+/*
+ * Kernel micro-benchmarks.  Every case prints one line of the form
+ *
+ *     bench suite=os case=<case> iters=<n> usecs=<n> ns_per_op=<n>
+ *
+ * on the console; see benchutil.h.  Intended to be run on the native BSP,
+ * where durations are taken from the host's monotonic clock, but runs on any
+ * target with os_cputime.
+ */
+
+#define BENCH_PRIO          (20)
+#define PARTNER_PRIO        (10)
+#define BENCH_STACK_SIZE    (512)
+
+static struct os_task bench_task;
+OS_TASK_STACK_DEFINE(bench_stack, BENCH_STACK_SIZE);
+
+struct os_task os_bench_partner_task;
+OS_TASK_STACK_DEFINE(partner_stack, BENCH_STACK_SIZE);
+
+static struct os_sem partner_start_sem;
+static struct os_sem partner_done_sem;
+static os_bench_partner_fn_t *partner_fn;
+static uint32_t partner_iters;
+
+/**
+ * Makes the partner task call 'fn' with 'iters'.  The partner task runs
+ * immediately, until it blocks.
+ */
+void
+os_bench_partner_start(os_bench_partner_fn_t *fn, uint32_t iters)
+{
+    partner_fn = fn;
+    partner_iters = iters;
+    os_sem_release(&partner_start_sem);
+}
+
+/**
+ * Waits for the function started with os_bench_partner_start() to return.
+ */
+void
+os_bench_partner_wait(void)
+{
+    int rc;
+
+    rc = os_sem_pend(&partner_done_sem, OS_TIMEOUT_NEVER);
+    assert(rc == 0);
+}
+
+static void
+partner_task_handler(void *arg)
+{
+    int rc;
+
+    while (1) {
+        rc = os_sem_pend(&partner_start_sem, OS_TIMEOUT_NEVER);
+        assert(rc == 0);
+
+        partner_fn(partner_iters);
+        os_sem_release(&partner_done_sem);
+    }
+}
+
+static void
+bench_task_handler(void *arg)
+{
+    bench_suite_start("os");
+    os_bench_sched_run();
+    os_bench_mem_run();
+    bench_suite_end();
+
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    os_sem_init(&partner_start_sem, 0);
+    os_sem_init(&partner_done_sem, 0);
+    os_bench_sched_init();
+    os_bench_mem_init();
+
+    os_task_init(&os_bench_partner_task, "partner", partner_task_handler,
+                 NULL, PARTNER_PRIO, OS_WAIT_FOREVER, partner_stack,
+                 OS_STACK_ALIGN(BENCH_STACK_SIZE));
+    os_task_init(&bench_task, "bench", bench_task_handler, NULL, BENCH_PRIO,
+                 OS_WAIT_FOREVER, bench_stack,
+                 OS_STACK_ALIGN(BENCH_STACK_SIZE));
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
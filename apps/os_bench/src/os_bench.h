@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_OS_BENCH_
+#define H_OS_BENCH_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The partner task runs at a higher priority than the benchmark task, so it
+ * preempts the benchmark task as soon as it becomes ready.
+ */
+typedef void os_bench_partner_fn_t(uint32_t iters);
+
+extern struct os_task os_bench_partner_task;
+
+void os_bench_partner_start(os_bench_partner_fn_t *fn, uint32_t iters);
+void os_bench_partner_wait(void);
+
+void os_bench_sched_init(void);
+void os_bench_sched_run(void);
+void os_bench_mem_init(void);
+void os_bench_mem_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -57,6 +57,9 @@ static volatile int g_task1_loops;
 #define TASK2_STACK_SIZE    OS_STACK_ALIGN(64)
 static struct os_task task2;
 
+/* Events dispatched per wakeup of the default event queue */
+#define DFLT_EVQ_BATCH  (8)
+
 static struct log my_log;
 
 static volatile int g_task2_loops;
@@ -283,9 +286,11 @@ main(int argc, char **argv)
 #endif
 
     /*
-     * As the last thing, process events from default event queue.
+     * As the last thing, process events from default event queue.  Shell,
+     * newtmgr and log events all arrive here, often in bursts, so dispatch
+     * what is pending in batches.
      */
     while (1) {
-        os_eventq_run(os_eventq_dflt_get());
+        os_eventq_run_batch(os_eventq_dflt_get(), DFLT_EVQ_BATCH);
     }
 }
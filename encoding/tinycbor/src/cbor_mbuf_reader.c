@@ -21,66 +21,153 @@
 #include <tinycbor/cbor_mbuf_reader.h>
 #include <tinycbor/compilersupport_p.h>
 
+/**
+ * Moves the reader's cursor to the specified offset.  The decoder reads its
+ * input mostly front to back, so the cursor usually only has to move forward
+ * from where the previous read left it instead of walking the chain from the
+ * start.
+ */
+static int
+cbor_mbuf_reader_seek(struct cbor_mbuf_reader *cb, int offset)
+{
+    int rc;
+
+    if (offset < cb->it_off) {
+        rc = os_mbuf_iter_init(&cb->it, cb->m, cb->init_off + offset);
+    } else {
+        rc = os_mbuf_iter_advance(&cb->it, offset - cb->it_off);
+    }
+
+    if (rc != 0) {
+        os_mbuf_iter_init(&cb->it, cb->m, cb->init_off);
+        cb->it_off = 0;
+        return -1;
+    }
+
+    cb->it_off = offset;
+    return 0;
+}
+
+/**
+ * Returns a pointer to "len" bytes at the specified offset.  The pointer
+ * refers to the mbuf data itself unless the bytes span two mbufs, in which
+ * case they are gathered into "buf".
+ */
+static const void *
+cbor_mbuf_reader_peek(struct cbor_mbuf_reader *cb, int offset, void *buf,
+                      int len)
+{
+    if (cbor_mbuf_reader_seek(cb, offset) != 0) {
+        return NULL;
+    }
+
+    return os_mbuf_iter_peek(&cb->it, buf, len);
+}
+
 static uint8_t
 cbor_mbuf_reader_get8(struct cbor_decoder_reader *d, int offset)
 {
     uint8_t val;
+    const uint8_t *p;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return val;
+    p = cbor_mbuf_reader_peek(cb, offset, &val, sizeof(val));
+    if (p == NULL) {
+        return 0;
+    }
+    return *p;
 }
 
 static uint16_t
 cbor_mbuf_reader_get16(struct cbor_decoder_reader *d, int offset)
 {
     uint16_t val;
+    const void *p;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return cbor_ntohs(val);
+    p = cbor_mbuf_reader_peek(cb, offset, &val, sizeof(val));
+    if (p == NULL) {
+        return 0;
+    }
+    return get_be16(p);
 }
 
 static uint32_t
 cbor_mbuf_reader_get32(struct cbor_decoder_reader *d, int offset)
 {
     uint32_t val;
+    const void *p;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return cbor_ntohl(val);
+    p = cbor_mbuf_reader_peek(cb, offset, &val, sizeof(val));
+    if (p == NULL) {
+        return 0;
+    }
+    return get_be32(p);
 }
 
 static uint64_t
 cbor_mbuf_reader_get64(struct cbor_decoder_reader *d, int offset)
 {
     uint64_t val;
+    const void *p;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
-    return cbor_ntohll(val);
+    p = cbor_mbuf_reader_peek(cb, offset, &val, sizeof(val));
+    if (p == NULL) {
+        return 0;
+    }
+    return get_be64(p);
 }
 
 static uintptr_t
 cbor_mbuf_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
                      size_t len)
 {
+    struct os_mbuf_iter it;
+    const uint8_t *data;
+    int count;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
-    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len) == 0;
+
+    if (cbor_mbuf_reader_seek(cb, offset) != 0) {
+        return false;
+    }
+
+    /* Compare in place, one mbuf at a time. */
+    it = cb->it;
+    while (len > 0) {
+        count = os_mbuf_iter_seg(&it, &data);
+        if (count == 0) {
+            return false;
+        }
+        if (count > len) {
+            count = len;
+        }
+        if (memcmp(data, buf, count) != 0) {
+            return false;
+        }
+        buf += count;
+        len -= count;
+        os_mbuf_iter_advance(&it, count);
+    }
+    return true;
 }
 
 static uintptr_t
 cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
                      size_t len)
 {
-    int rc;
+    const void *p;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    rc = os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst);
-    if (rc == 0) {
-        return true;
+    p = cbor_mbuf_reader_peek(cb, offset, dst, len);
+    if (p == NULL) {
+        return false;
+    }
+    if (p != dst) {
+        memcpy(dst, p, len);
     }
-    return false;
+    return true;
 }
 
 void
@@ -100,5 +187,7 @@ cbor_mbuf_reader_init(struct cbor_mbuf_reader *cb, struct os_mbuf *m,
     hdr = OS_MBUF_PKTHDR(m);
     cb->m = m;
     cb->init_off = initial_offset;
+    cb->it_off = 0;
+    os_mbuf_iter_init(&cb->it, m, initial_offset);
     cb->r.message_size = hdr->omp_len - initial_offset;
 }
@@ -53,6 +53,7 @@ struct fcb {
     uint8_t f_version;  	/* Current version number of the data */
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
+    uint8_t f_sum_cnt;		/* Mount summaries per sector, 0 for none */
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
 
     /* Flash circular buffer internal state */
@@ -61,6 +62,7 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+    uint8_t f_active_sum;	/* Summary slots used in active sector */
 };
 
 /**
@@ -76,6 +78,19 @@ struct fcb {
 #define FCB_ERR_MAGIC   -7
 #define FCB_ERR_VERSION -8
 
+/**
+ * Mounts the FCB.  fcb_init() has to find the end of the data in the
+ * active sector, which normally means reading every element in it.
+ *
+ * The caller must zero struct fcb before filling in its configuration
+ * fields, so that fields it does not set, such as f_sum_cnt, are 0.
+ *
+ * If f_sum_cnt is non-zero, that many summary records are reserved at the
+ * end of every sector.  As the sector fills up, append records its current
+ * write position in them, and fcb_init() only scans the elements written
+ * after the newest valid summary.  Sectors written with a different
+ * f_sum_cnt are rejected with FCB_ERR_VERSION.
+ */
 int fcb_init(struct fcb *fcb);
 
 /**
@@ -100,6 +115,30 @@ struct fcb_log {
 int fcb_append(struct fcb *, uint16_t len, struct fcb_entry *loc);
 int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
 
+/**
+ * Element to be written by fcb_append_batch().
+ */
+struct fcb_batch_elem {
+    const void *fbe_data;
+    uint16_t fbe_len;
+};
+
+/**
+ * fcb_append_batch() appends cnt complete entries to the circular buffer.
+ * The entries are placed back to back in one sector and written with as
+ * few flash writes as FCB_BATCH_BUF_SIZE allows; CRCs are computed from
+ * the caller's buffers, so there is no fcb_append_finish() step.  If locs
+ * is not NULL, it receives the location of every entry.
+ *
+ * No other append can come between the entries of a batch, but the batch
+ * is not all-or-nothing: each entry carries only its own CRC.  If writing
+ * is interrupted, the entries written before the interruption are kept
+ * and the rest are lost, so readers can see any prefix of the batch.
+ * Returns FCB_ERR_NOSPACE if the batch does not fit in a sector.
+ */
+int fcb_append_batch(struct fcb *, const struct fcb_batch_elem *elems,
+                     int cnt, struct fcb_entry *locs);
+
 /**
  * Walk over all log entries in FCB, or entries in a given flash_area.
  * cb gets called for every entry. If cb wants to stop the walk, it should
@@ -35,7 +35,8 @@ fcb_init(struct fcb *fcb)
     struct flash_area *oldest_fap = NULL, *newest_fap = NULL;
     struct fcb_disk_area fda;
 
-    if (!fcb->f_sectors || fcb->f_sector_cnt - fcb->f_scratch_cnt < 1) {
+    if (!fcb->f_sectors || fcb->f_sector_cnt - fcb->f_scratch_cnt < 1 ||
+      fcb->f_sum_cnt == FCB_SUM_NONE) {
         return FCB_ERR_ARGS;
     }
 
@@ -66,6 +67,18 @@ fcb_init(struct fcb *fcb)
             oldest_fap = fap;
         }
     }
+    fcb->f_align = max_align;
+
+    /* Summary slots must leave room for elements in every sector. */
+    for (i = 0; fcb->f_sum_cnt && i < fcb->f_sector_cnt; i++) {
+        fap = &fcb->f_sectors[i];
+        if (fcb_sector_end(fcb, fap) > fap->fa_size ||
+          fcb_sector_end(fcb, fap) <
+          sizeof(struct fcb_disk_area) + fcb->f_sum_cnt + 1) {
+            return FCB_ERR_ARGS;
+        }
+    }
+
     if (oldest < 0) {
         /*
          * No initialized areas.
@@ -77,17 +90,24 @@ fcb_init(struct fcb *fcb)
         }
         newest = oldest = 0;
     }
-    fcb->f_align = max_align;
     fcb->f_oldest = oldest_fap;
     fcb->f_active.fe_area = newest_fap;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id = newest;
+    fcb->f_active_sum = 0;
 
     /* Require alignment to be a power of two.  Some code depends on this
      * assumption.
      */
     assert((fcb->f_align & (fcb->f_align - 1)) == 0);
 
+    if (fcb->f_sum_cnt) {
+        rc = fcb_sum_load(fcb);
+        if (rc) {
+            return rc;
+        }
+    }
+
     while (1) {
         rc = fcb_getnext_in_area(fcb, &fcb->f_active);
         if (rc == FCB_ERR_NOVAR) {
@@ -170,7 +190,7 @@ fcb_sector_hdr_init(struct fcb *fcb, struct flash_area *fap, uint16_t id)
 
     fda.fd_magic = fcb->f_magic;
     fda.fd_ver = fcb->f_version;
-    fda._pad = 0xff;
+    fda.fd_sum_cnt = fcb_disk_sum_cnt(fcb);
     fda.fd_id = id;
 
     rc = flash_area_write(fap, 0, &fda, sizeof(fda));
@@ -205,7 +225,8 @@ fcb_sector_hdr_read(struct fcb *fcb, struct flash_area *fap,
     if (fdap->fd_magic != fcb->f_magic) {
         return FCB_ERR_MAGIC;
     }
-    if (fdap->fd_ver != fcb->f_version) {
+    if (fdap->fd_ver != fcb->f_version ||
+      fdap->fd_sum_cnt != fcb_disk_sum_cnt(fcb)) {
         return FCB_ERR_VERSION;
     }
     return 1;
@@ -17,6 +17,9 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
+
+#include <crc/crc8.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
@@ -63,14 +66,47 @@ fcb_append_to_scratch(struct fcb *fcb)
     fcb->f_active.fe_area = fa;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id++;
+    fcb->f_active_sum = 0;
     return FCB_OK;
 }
 
+/*
+ * Make room for len bytes in the active sector, moving to a new sector
+ * if needed.  Called with the FCB locked.
+ */
+static int
+fcb_append_reserve(struct fcb *fcb, uint32_t len)
+{
+    struct fcb_entry *active;
+    struct flash_area *fa;
+    int rc;
+
+    active = &fcb->f_active;
+    if (active->fe_elem_off + len > fcb_sector_end(fcb, active->fe_area)) {
+        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
+        if (!fa || (fcb_sector_end(fcb, fa) <
+            sizeof(struct fcb_disk_area) + len)) {
+            return FCB_ERR_NOSPACE;
+        }
+        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+        if (rc) {
+            return rc;
+        }
+        fcb->f_active.fe_area = fa;
+        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+        fcb->f_active_id++;
+        fcb->f_active_sum = 0;
+    }
+    if (fcb->f_sum_cnt) {
+        return fcb_sum_update(fcb);
+    }
+    return 0;
+}
+
 int
 fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
 {
     struct fcb_entry *active;
-    struct flash_area *fa;
     uint8_t tmp_str[2];
     int cnt;
     int rc;
@@ -87,20 +123,9 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
         return FCB_ERR_ARGS;
     }
     active = &fcb->f_active;
-    if (active->fe_elem_off + len + cnt > active->fe_area->fa_size) {
-        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
-        if (!fa || (fa->fa_size <
-            sizeof(struct fcb_disk_area) + len + cnt)) {
-            rc = FCB_ERR_NOSPACE;
-            goto err;
-        }
-        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
-        if (rc) {
-            goto err;
-        }
-        fcb->f_active.fe_area = fa;
-        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
-        fcb->f_active_id++;
+    rc = fcb_append_reserve(fcb, len + cnt);
+    if (rc) {
+        goto err;
     }
 
     rc = flash_area_write(active->fe_area, active->fe_elem_off, tmp_str, cnt);
@@ -123,6 +148,173 @@ err:
     return rc;
 }
 
+/*
+ * Staging buffer for fcb_append_batch(); flushed to flash when full.
+ */
+struct fcb_batch_buf {
+    struct flash_area *fbb_area;
+    uint32_t fbb_off;
+    int fbb_used;
+    int fbb_cap;
+    uint8_t fbb_erased;
+    uint8_t fbb_buf[MYNEWT_VAL(FCB_BATCH_BUF_SIZE)];
+};
+
+static int
+fcb_batch_flush(struct fcb_batch_buf *fbb)
+{
+    int rc;
+
+    if (fbb->fbb_used == 0) {
+        return 0;
+    }
+    rc = flash_area_write(fbb->fbb_area, fbb->fbb_off, fbb->fbb_buf,
+      fbb->fbb_used);
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    fbb->fbb_off += fbb->fbb_used;
+    fbb->fbb_used = 0;
+    return 0;
+}
+
+/*
+ * Add len bytes from data to the batch, or erased filler if data is NULL.
+ */
+static int
+fcb_batch_put(struct fcb_batch_buf *fbb, const void *data, int len)
+{
+    int blk_sz;
+    int rc;
+
+    while (len > 0) {
+        if (fbb->fbb_used == fbb->fbb_cap) {
+            rc = fcb_batch_flush(fbb);
+            if (rc) {
+                return rc;
+            }
+        }
+        blk_sz = fbb->fbb_cap - fbb->fbb_used;
+        if (blk_sz > len) {
+            blk_sz = len;
+        }
+        if (data) {
+            memcpy(&fbb->fbb_buf[fbb->fbb_used], data, blk_sz);
+            data = (const uint8_t *)data + blk_sz;
+        } else {
+            memset(&fbb->fbb_buf[fbb->fbb_used], fbb->fbb_erased, blk_sz);
+        }
+        fbb->fbb_used += blk_sz;
+        len -= blk_sz;
+    }
+    return 0;
+}
+
+static int
+fcb_batch_put_aligned(struct fcb *fcb, struct fcb_batch_buf *fbb,
+                      const void *data, int len)
+{
+    int rc;
+
+    rc = fcb_batch_put(fbb, data, len);
+    if (rc) {
+        return rc;
+    }
+    return fcb_batch_put(fbb, NULL, fcb_len_in_flash(fcb, len) - len);
+}
+
+int
+fcb_append_batch(struct fcb *fcb, const struct fcb_batch_elem *elems,
+                 int cnt, struct fcb_entry *locs)
+{
+    struct fcb_batch_buf fbb;
+    struct fcb_entry *active;
+    uint8_t tmp_str[2];
+    uint32_t total;
+    uint32_t off;
+    uint8_t crc8;
+    int len_sz;
+    int rc;
+    int i;
+
+    /*
+     * Only whole flash write units are flushed before the end of the batch.
+     */
+    fbb.fbb_cap = sizeof(fbb.fbb_buf) - sizeof(fbb.fbb_buf) % fcb->f_align;
+    if (cnt <= 0 || fbb.fbb_cap == 0) {
+        return FCB_ERR_ARGS;
+    }
+    total = 0;
+    for (i = 0; i < cnt; i++) {
+        len_sz = fcb_put_len(tmp_str, elems[i].fbe_len);
+        if (len_sz < 0) {
+            return len_sz;
+        }
+        total += fcb_len_in_flash(fcb, len_sz) +
+          fcb_len_in_flash(fcb, elems[i].fbe_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    active = &fcb->f_active;
+    rc = fcb_append_reserve(fcb, total);
+    if (rc) {
+        goto out;
+    }
+
+    /*
+     * Elements are laid out exactly as by fcb_append(), and written in
+     * order.  There is no commit record; an interrupted batch leaves
+     * the entries written so far behind.
+     */
+    fbb.fbb_area = active->fe_area;
+    fbb.fbb_off = active->fe_elem_off;
+    fbb.fbb_used = 0;
+    fbb.fbb_erased = flash_area_erased_val(active->fe_area);
+    off = active->fe_elem_off;
+    for (i = 0; i < cnt; i++) {
+        len_sz = fcb_put_len(tmp_str, elems[i].fbe_len);
+        crc8 = crc8_calc(crc8_init(), tmp_str, len_sz);
+        crc8 = crc8_calc(crc8, (void *)elems[i].fbe_data, elems[i].fbe_len);
+        if (locs) {
+            locs[i].fe_area = active->fe_area;
+            locs[i].fe_elem_off = off;
+            locs[i].fe_data_off = off + fcb_len_in_flash(fcb, len_sz);
+            locs[i].fe_data_len = elems[i].fbe_len;
+        }
+        off += fcb_len_in_flash(fcb, len_sz) +
+          fcb_len_in_flash(fcb, elems[i].fbe_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+
+        rc = fcb_batch_put_aligned(fcb, &fbb, tmp_str, len_sz);
+        if (!rc) {
+            rc = fcb_batch_put_aligned(fcb, &fbb, elems[i].fbe_data,
+              elems[i].fbe_len);
+        }
+        if (!rc) {
+            rc = fcb_batch_put_aligned(fcb, &fbb, &crc8, sizeof(crc8));
+        }
+        if (rc) {
+            break;
+        }
+    }
+    if (!rc) {
+        rc = fcb_batch_flush(&fbb);
+    }
+
+    /*
+     * Space is consumed even on failure; the partial element is skipped
+     * by readers due to CRC mismatch.
+     */
+    active->fe_elem_off += total;
+out:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
+
 int
 fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
 {
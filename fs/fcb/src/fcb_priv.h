@@ -28,13 +28,27 @@ extern "C" {
 
 #define FCB_ID_GT(a, b) (((int16_t)(a) - (int16_t)(b)) > 0)
 
+#define FCB_SUM_NONE	0xff
+
 struct fcb_disk_area {
     uint32_t fd_magic;
     uint8_t  fd_ver;
-    uint8_t  _pad;
+    uint8_t  fd_sum_cnt;	/* f_sum_cnt, or FCB_SUM_NONE */
     uint16_t fd_id;
 };
 
+/*
+ * Summary slots follow the element area at the end of a sector.  Slot n is
+ * written when the append position crosses the (n + 1)th of f_sum_cnt + 1
+ * equal parts of the element area.
+ */
+struct fcb_disk_sum {
+    uint32_t fs_elem_off;	/* append position when written */
+    uint16_t fs_id;		/* fd_id of the sector */
+    uint8_t  _pad;
+    uint8_t  fs_crc8;		/* crc8 of the fields above */
+};
+
 int fcb_put_len(uint8_t *buf, uint16_t len);
 int fcb_get_len(uint8_t *buf, uint16_t *len);
 
@@ -47,6 +61,32 @@ fcb_len_in_flash(struct fcb *fcb, uint16_t len)
     return (len + (fcb->f_align - 1)) & ~(fcb->f_align - 1);
 }
 
+static inline uint8_t
+fcb_disk_sum_cnt(struct fcb *fcb)
+{
+    return fcb->f_sum_cnt ? fcb->f_sum_cnt : FCB_SUM_NONE;
+}
+
+/*
+ * End of the element area within a sector.
+ */
+static inline uint32_t
+fcb_sector_end(struct fcb *fcb, struct flash_area *fap)
+{
+    return fap->fa_size -
+      fcb->f_sum_cnt * fcb_len_in_flash(fcb, sizeof(struct fcb_disk_sum));
+}
+
+static inline uint32_t
+fcb_sum_off(struct fcb *fcb, struct flash_area *fap, int idx)
+{
+    return fcb_sector_end(fcb, fap) +
+      idx * fcb_len_in_flash(fcb, sizeof(struct fcb_disk_sum));
+}
+
+int fcb_sum_load(struct fcb *fcb);
+int fcb_sum_update(struct fcb *fcb);
+
 int fcb_getnext_in_area(struct fcb *fcb, struct fcb_entry *loc);
 struct flash_area *fcb_getnext_area(struct fcb *fcb, struct flash_area *fap);
 int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
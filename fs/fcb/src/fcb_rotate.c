@@ -48,6 +48,7 @@ fcb_rotate(struct fcb *fcb)
         fcb->f_active.fe_area = fap;
         fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
         fcb->f_active_id++;
+        fcb->f_active_sum = 0;
     }
     fcb->f_oldest = fcb_getnext_area(fcb, fcb->f_oldest);
 out:
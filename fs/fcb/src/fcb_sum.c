@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+
+#include <crc/crc8.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+static uint8_t
+fcb_sum_crc8(struct fcb_disk_sum *fds)
+{
+    return crc8_calc(crc8_init(), (uint8_t *)fds,
+      offsetof(struct fcb_disk_sum, fs_crc8));
+}
+
+/**
+ * Moves the append position of the active sector to the newest valid
+ * summary.  Torn or foreign slots are skipped, but still count as used.
+ */
+int
+fcb_sum_load(struct fcb *fcb)
+{
+    struct fcb_entry *active;
+    struct fcb_disk_sum fds;
+    uint32_t end;
+    int rc;
+    int i;
+
+    active = &fcb->f_active;
+    end = fcb_sector_end(fcb, active->fe_area);
+    for (i = 0; i < fcb->f_sum_cnt; i++) {
+        rc = flash_area_read_is_empty(active->fe_area,
+          fcb_sum_off(fcb, active->fe_area, i), &fds, sizeof(fds));
+        if (rc < 0) {
+            return FCB_ERR_FLASH;
+        } else if (rc == 1) {
+            continue;
+        }
+        fcb->f_active_sum = i + 1;
+        if (fds.fs_crc8 != fcb_sum_crc8(&fds) ||
+          fds.fs_id != fcb->f_active_id ||
+          fds.fs_elem_off < sizeof(struct fcb_disk_area) ||
+          fds.fs_elem_off > end) {
+            continue;
+        }
+        if (fds.fs_elem_off > active->fe_elem_off) {
+            active->fe_elem_off = fds.fs_elem_off;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Writes a summary if the append position has moved into the next part
+ * of the active sector.  Called with the FCB locked, before the next
+ * element is appended.
+ */
+int
+fcb_sum_update(struct fcb *fcb)
+{
+    struct fcb_entry *active;
+    struct fcb_disk_sum fds;
+    uint32_t step;
+    int idx;
+    int rc;
+
+    active = &fcb->f_active;
+    step = (fcb_sector_end(fcb, active->fe_area) -
+      sizeof(struct fcb_disk_area)) / (fcb->f_sum_cnt + 1);
+    idx = (active->fe_elem_off - sizeof(struct fcb_disk_area)) / step;
+    if (idx > fcb->f_sum_cnt) {
+        idx = fcb->f_sum_cnt;
+    }
+    if (idx <= fcb->f_active_sum) {
+        return 0;
+    }
+
+    fds.fs_elem_off = active->fe_elem_off;
+    fds.fs_id = fcb->f_active_id;
+    fds._pad = 0xff;
+    fds.fs_crc8 = fcb_sum_crc8(&fds);
+
+    /*
+     * A slot is never written twice, even if this write fails half way.
+     */
+    fcb->f_active_sum = idx;
+    rc = flash_area_write(active->fe_area,
+      fcb_sum_off(fcb, active->fe_area, idx - 1), &fds, sizeof(fds));
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_BATCH_ELEMS    128
+#define FCB_TEST_BATCH_SZ       16
+
+static uint8_t fcb_test_batch_data[FCB_TEST_BATCH_ELEMS][FCB_TEST_BATCH_ELEMS];
+static struct fcb_batch_elem fcb_test_batch_elems[FCB_TEST_BATCH_ELEMS];
+static struct fcb_entry fcb_test_batch_locs[FCB_TEST_BATCH_ELEMS];
+
+TEST_CASE(fcb_test_append_batch)
+{
+    struct fcb single;
+    struct fcb_entry loc;
+    struct fcb_entry active;
+    struct fcb *fcb;
+    uint8_t buf1[64];
+    uint8_t buf2[64];
+    uint32_t off;
+    int var_cnt;
+    int blk_sz;
+    int rc;
+    int i;
+    int j;
+
+    fcb = &test_fcb;
+
+    memset(&single, 0, sizeof(single));
+    single.f_sector_cnt = 2;
+    single.f_sectors = &test_fcb_area[2];
+    rc = fcb_init(&single);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < FCB_TEST_BATCH_ELEMS; i++) {
+        for (j = 0; j < i; j++) {
+            fcb_test_batch_data[i][j] = fcb_test_append_data(i, j);
+        }
+        fcb_test_batch_elems[i].fbe_data = fcb_test_batch_data[i];
+        fcb_test_batch_elems[i].fbe_len = i;
+    }
+
+    rc = fcb_append_batch(fcb, fcb_test_batch_elems, 0, NULL);
+    TEST_ASSERT(rc == FCB_ERR_ARGS);
+
+    for (i = 0; i < FCB_TEST_BATCH_ELEMS; i += FCB_TEST_BATCH_SZ) {
+        rc = fcb_append_batch(fcb, &fcb_test_batch_elems[i],
+          FCB_TEST_BATCH_SZ, &fcb_test_batch_locs[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    for (i = 0; i < FCB_TEST_BATCH_ELEMS; i++) {
+        rc = fcb_append(&single, i, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off,
+          fcb_test_batch_data[i], i);
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(&single, &loc);
+        TEST_ASSERT(rc == 0);
+
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_area == &test_fcb_area[0]);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_elem_off == loc.fe_elem_off);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_data_off == loc.fe_data_off);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_data_len == i);
+    }
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == FCB_TEST_BATCH_ELEMS);
+
+    /*
+     * Batches end up on flash exactly like entries appended one by one.
+     */
+    TEST_ASSERT_FATAL(fcb->f_active.fe_elem_off ==
+      single.f_active.fe_elem_off);
+    for (off = 0; off < fcb->f_active.fe_elem_off; off += blk_sz) {
+        blk_sz = min(sizeof(buf1), fcb->f_active.fe_elem_off - off);
+        rc = flash_area_read(&test_fcb_area[0], off, buf1, blk_sz);
+        TEST_ASSERT(rc == 0);
+        rc = flash_area_read(&test_fcb_area[2], off, buf2, blk_sz);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT_FATAL(memcmp(buf1, buf2, blk_sz) == 0);
+    }
+
+    /*
+     * A batch is never split across sectors.
+     */
+    rc = fcb_append_batch(fcb, fcb_test_batch_elems, FCB_TEST_BATCH_ELEMS,
+      fcb_test_batch_locs);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < FCB_TEST_BATCH_ELEMS; i++) {
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_area == &test_fcb_area[1]);
+    }
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, &test_fcb_area[1], fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == FCB_TEST_BATCH_ELEMS);
+
+    /*
+     * A batch which does not fit is refused without side effects.
+     */
+    active = fcb->f_active;
+    rc = fcb_append_batch(fcb, fcb_test_batch_elems, FCB_TEST_BATCH_ELEMS,
+      NULL);
+    TEST_ASSERT(rc == FCB_ERR_NOSPACE);
+    TEST_ASSERT(fcb->f_active.fe_area == active.fe_area);
+    TEST_ASSERT(fcb->f_active.fe_elem_off == active.fe_elem_off);
+}
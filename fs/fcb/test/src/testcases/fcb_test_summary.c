@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_SUM_CNT        8
+#define FCB_TEST_SUM_ELEM_SZ    16
+
+static struct fcb fcb_test_plain_fcb;
+
+static int
+fcb_test_summary_init(struct fcb *fcb, struct flash_area *sectors,
+                      uint8_t sum_cnt)
+{
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 2;
+    fcb->f_sectors = sectors;
+    fcb->f_sum_cnt = sum_cnt;
+
+    return fcb_init(fcb);
+}
+
+static void
+fcb_test_summary_append(struct fcb *fcb, int cnt)
+{
+    uint8_t test_data[FCB_TEST_SUM_ELEM_SZ];
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+    for (i = 0; i < cnt; i++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+static void
+fcb_test_summary_remount(struct fcb *fcb, struct flash_area *sectors,
+                         uint8_t sum_cnt)
+{
+    struct fcb_entry active;
+    uint8_t active_sum;
+    int rc;
+
+    active = fcb->f_active;
+    active_sum = fcb->f_active_sum;
+
+    rc = fcb_test_summary_init(fcb, sectors, sum_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_active.fe_area == active.fe_area);
+    TEST_ASSERT(fcb->f_active.fe_elem_off == active.fe_elem_off);
+    TEST_ASSERT(fcb->f_active_sum == active_sum);
+}
+
+static int
+fcb_test_summary_cnt(struct fcb *fcb)
+{
+    int cnts[4] = { 0 };
+    struct append_arg aa_arg = {
+        .elem_cnts = cnts
+    };
+    int rc;
+
+    rc = fcb_walk(fcb, NULL, fcb_test_cnt_elems_cb, &aa_arg);
+    TEST_ASSERT(rc == 0);
+    return cnts[0] + cnts[1] + cnts[2] + cnts[3];
+}
+
+TEST_CASE(fcb_test_summary)
+{
+    static const int elem_cnts[] = { 150, 450, 800 };
+    struct fcb_disk_sum fds;
+    struct fcb tmp;
+    struct fcb *plain;
+    struct fcb *fcb;
+    uint32_t elem_sz;
+    uint32_t full_bytes;
+    uint32_t sum_bytes;
+    uint32_t off;
+    int total;
+    int rc;
+    int i;
+
+    fcb_test_wipe();
+    fcb = &test_fcb;
+    plain = &fcb_test_plain_fcb;
+
+    rc = fcb_test_summary_init(&tmp, &test_fcb_area[0], FCB_SUM_NONE);
+    TEST_ASSERT(rc == FCB_ERR_ARGS);
+
+    rc = fcb_test_summary_init(fcb, &test_fcb_area[0], FCB_TEST_SUM_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fcb_test_summary_init(plain, &test_fcb_area[2], 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Length byte, data and CRC of one element */
+    elem_sz = fcb_len_in_flash(plain, 1) +
+      fcb_len_in_flash(plain, FCB_TEST_SUM_ELEM_SZ) +
+      fcb_len_in_flash(plain, 1);
+
+    /*
+     * Same elements in both FCBs; the one with summaries has to resume at
+     * the same position, while scanning only the tail of the sector.
+     */
+    total = 0;
+    for (i = 0; i < sizeof(elem_cnts) / sizeof(elem_cnts[0]); i++) {
+        fcb_test_summary_append(fcb, elem_cnts[i] - total);
+        fcb_test_summary_append(plain, elem_cnts[i] - total);
+        total = elem_cnts[i];
+        TEST_ASSERT(fcb->f_active.fe_elem_off ==
+          plain->f_active.fe_elem_off);
+        TEST_ASSERT(fcb->f_active_sum > 0);
+
+        fcb_test_summary_remount(plain, &test_fcb_area[2], 0);
+        fcb_test_summary_remount(fcb, &test_fcb_area[0], FCB_TEST_SUM_CNT);
+        TEST_ASSERT(fcb_test_summary_cnt(fcb) == total);
+
+        /*
+         * Without summaries mount reads the whole sector, with them at
+         * most one of the FCB_TEST_SUM_CNT + 1 parts of it.
+         */
+        tmp = *fcb;
+        tmp.f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+        tmp.f_active_sum = 0;
+        rc = fcb_sum_load(&tmp);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(tmp.f_active_sum == fcb->f_active_sum);
+        full_bytes = plain->f_active.fe_elem_off -
+          sizeof(struct fcb_disk_area);
+        sum_bytes = fcb->f_active.fe_elem_off - tmp.f_active.fe_elem_off;
+        TEST_ASSERT(sum_bytes <= (fcb_sector_end(fcb, fcb->f_active.fe_area) -
+          sizeof(struct fcb_disk_area)) / (FCB_TEST_SUM_CNT + 1) +
+          FCB_TEST_SUM_ELEM_SZ + 2);
+        TEST_ASSERT(full_bytes == total * elem_sz);
+        TEST_ASSERT(sum_bytes < full_bytes);
+    }
+
+    /*
+     * Sectors written with a different number of summary slots are
+     * rejected.
+     */
+    rc = fcb_test_summary_init(&tmp, &test_fcb_area[0], 0);
+    TEST_ASSERT(rc == FCB_ERR_VERSION);
+    rc = fcb_test_summary_init(&tmp, &test_fcb_area[2], FCB_TEST_SUM_CNT);
+    TEST_ASSERT(rc == FCB_ERR_VERSION);
+
+    /*
+     * A torn summary is ignored, and its slot is not reused.
+     */
+    TEST_ASSERT_FATAL(fcb->f_active_sum < FCB_TEST_SUM_CNT);
+    off = fcb_sum_off(fcb, fcb->f_active.fe_area, fcb->f_active_sum);
+    memset(&fds, 0, sizeof(fds));
+    fds.fs_elem_off = fcb_sector_end(fcb, fcb->f_active.fe_area);
+    fds.fs_id = fcb->f_active_id;
+    rc = flash_area_write(fcb->f_active.fe_area, off, &fds, sizeof(fds));
+    TEST_ASSERT(rc == 0);
+
+    fcb->f_active_sum++;
+    fcb_test_summary_remount(fcb, &test_fcb_area[0], FCB_TEST_SUM_CNT);
+
+    /*
+     * Fill up the rest of the first sector, and continue in the second.
+     */
+    fcb_test_summary_append(fcb, 200);
+    total += 200;
+    TEST_ASSERT(fcb->f_active.fe_area == &test_fcb_area[1]);
+    fcb_test_summary_remount(fcb, &test_fcb_area[0], FCB_TEST_SUM_CNT);
+    TEST_ASSERT(fcb_test_summary_cnt(fcb) == total);
+}
@@ -65,6 +65,8 @@ struct fcb {
     uint8_t f_range_cnt;    /* Number of elements in range array */
     uint16_t f_sector_cnt;  /* Number of sectors used by fcb */
     struct flash_sector_range *f_ranges;
+    uint16_t *f_entry_cnts; /* Optional, f_sector_cnt elements; caches
+                               the number of entries in full sectors */
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -135,6 +137,30 @@ int fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *loc);
 int fcb_write(struct fcb_entry *loc, uint16_t off, void *buf, uint16_t len);
 int fcb_append_finish(struct fcb_entry *append_loc);
 
+/**
+ * Element to be written by fcb_append_batch().
+ */
+struct fcb_batch_elem {
+    const void *fbe_data;
+    uint16_t fbe_len;
+};
+
+/**
+ * fcb_append_batch() appends cnt complete entries to the circular buffer.
+ * The entries are placed in one sector.  Their descriptors are written
+ * first, then the data of all of them as one stream, in as few flash
+ * writes as FCB2_BATCH_BUF_SIZE allows.  CRCs are computed from the
+ * caller's buffers, so there is no fcb_append_finish() step.  If locs is
+ * not NULL, it receives the location of every entry.
+ *
+ * No other append can come between the entries of a batch, but the batch
+ * is not all-or-nothing: each entry carries only its own CRC.  If writing
+ * is interrupted, the entries whose data made it to flash are kept and the
+ * rest fail the CRC check, so readers can see any prefix of the batch.
+ */
+int fcb_append_batch(struct fcb *fcb, const struct fcb_batch_elem *elems,
+                     int cnt, struct fcb_entry *locs);
+
 /**
  * Walk over all log entries in FCB, or entries in a given flash_area.
  * cb gets called for every entry. If cb wants to stop the walk, it should
@@ -147,6 +173,37 @@ int fcb_walk(struct fcb *, int sector, fcb_walk_cb cb, void *cb_arg);
 int fcb_getnext(struct fcb *fcb, struct fcb_entry *loc);
 int fcb_read(struct fcb_entry *loc, uint16_t off, void *buf, uint16_t len);
 
+/**
+ * Return the entry preceding loc.  If loc->fe_range is NULL, the last entry
+ * in FCB is returned.
+ *
+ * Entries within a sector are located through the entry table at the end
+ * of the sector, so this does not read the data of the skipped entries.
+ * Stepping into a full sector needs the number of entries in it; this is
+ * found by reading its entry table, and kept in f_entry_cnts if set.
+ *
+ * @return 0 on success, FCB_ERR_NOVAR if loc was the first entry.
+ */
+int fcb_getprev(struct fcb *fcb, struct fcb_entry *loc);
+
+/**
+ * Sequence number of an entry.  It is the id of the entry's sector in the
+ * upper 16 bits and the entry number within the sector in the lower 16
+ * bits, so it grows with every append and stays the same across reboots.
+ * Compare sequence numbers with (int32_t)(a - b), as they wrap around.
+ */
+uint32_t fcb_entry_seq(struct fcb *fcb, const struct fcb_entry *loc);
+
+/**
+ * Find the first entry with sequence number seq or higher, e.g. to resume
+ * reading after a given entry.  If the entries with seq have been rotated
+ * out already, the oldest entry is returned.  The sector is found without
+ * reading flash, so the cost does not depend on the number of entries.
+ *
+ * @return 0 on success, FCB_ERR_NOVAR if there are no entries past seq.
+ */
+int fcb_seek_seq(struct fcb *fcb, uint32_t seq, struct fcb_entry *loc);
+
 /**
  * Erases the data from oldest sector.
  */
@@ -37,6 +37,10 @@ fcb_init(struct fcb *fcb)
     if (!fcb->f_ranges || fcb->f_sector_cnt - fcb->f_scratch_cnt < 1) {
         return FCB_ERR_ARGS;
     }
+    if (fcb->f_entry_cnts) {
+        memset(fcb->f_entry_cnts, 0xff,
+            fcb->f_sector_cnt * sizeof(fcb->f_entry_cnts[0]));
+    }
 
     /* Fill last used, first used */
     for (i = 0; i < fcb->f_sector_cnt; i++) {
@@ -168,6 +172,10 @@ fcb_sector_hdr_init(struct fcb *fcb, int sector, uint16_t id)
     fda._pad = 0xff;
     fda.fd_id = id;
 
+    if (fcb->f_entry_cnts) {
+        fcb->f_entry_cnts[sector] = FCB_ENTRY_CNT_UNKNOWN;
+    }
+
     assert(sector_in_range >= 0 && sector_in_range < range->fsr_sector_count);
     rc = flash_area_write(&range->fsr_flash_area,
         sector_in_range * range->fsr_sector_size, &fda, sizeof(fda));
@@ -228,17 +236,13 @@ fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
         entries = 1;
     }
 
-    i = 0;
+    /* Step back from the end, stopping at the first entry */
     memset(&loc, 0, sizeof(loc));
-    while (!fcb_getnext(fcb, &loc)) {
-        if (i == 0) {
-            /* Start from the beginning of fcb entries */
-            *last_n_entry = loc;
-        } else if (i > (entries - 1)) {
-            /* Update last_n_entry after n entries and keep updating */
-            fcb_getnext(fcb, last_n_entry);
+    for (i = 0; i < entries; i++) {
+        if (fcb_getprev(fcb, &loc)) {
+            break;
         }
-        i++;
+        *last_n_entry = loc;
     }
 
     return (i == 0) ? OS_ENOENT : 0;
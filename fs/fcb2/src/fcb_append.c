@@ -17,10 +17,12 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
 #include "crc/crc8.h"
+#include "crc/crc16.h"
 
 int
 fcb_new_sector(struct fcb *fcb, int cnt)
@@ -155,13 +157,82 @@ fcb_element_length_in_flash(const struct fcb_entry *loc, int len)
         fcb_len_in_flash(loc->fe_range, FCB_CRC_LEN);
 }
 
+/*
+ * Make room for entry_cnt entries taking len bytes of data and CRC in the
+ * active sector, moving to a new sector if needed.  Called with the FCB
+ * locked.
+ */
+static int
+fcb_append_reserve(struct fcb *fcb, int len, int entry_cnt)
+{
+    struct flash_sector_range *range;
+    int entry_sz;
+    int sector;
+    int rc;
+
+    entry_sz = fcb_len_in_flash(fcb->f_active.fe_range, FCB_ENTRY_SIZE);
+    if (fcb_active_sector_free_space(fcb) >= len + (entry_cnt - 1) * entry_sz) {
+        return 0;
+    }
+    sector = fcb_new_sector(fcb, fcb->f_scratch_cnt);
+    if (sector < 0) {
+        return FCB_ERR_NOSPACE;
+    }
+    range = fcb_get_sector_range(fcb, sector);
+    if (range->fsr_sector_size <
+        fcb_len_in_flash(range, sizeof(struct fcb_disk_area)) + len +
+        entry_cnt * fcb_len_in_flash(range, FCB_ENTRY_SIZE)) {
+        return FCB_ERR_NOSPACE;
+    }
+    rc = fcb_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
+    if (rc) {
+        return rc;
+    }
+    fcb->f_active.fe_range = range;
+    fcb->f_active.fe_sector = sector;
+    /* Start with offset just after sector header */
+    fcb->f_active.fe_data_off =
+        fcb_len_in_flash(range, sizeof(struct fcb_disk_area));
+    /* No entries as yet */
+    fcb->f_active.fe_entry_num = 1;
+    fcb->f_active.fe_data_len = 0;
+    fcb->f_active_id++;
+    return 0;
+}
+
+/*
+ * Write the descriptor of a len byte entry at the active position.
+ */
+static int
+fcb_append_entry(struct fcb *fcb, uint32_t data_off, uint16_t len)
+{
+    struct fcb_entry *active;
+    uint8_t flash_entry[FCB_ENTRY_SIZE];
+    int rc;
+
+    active = &fcb->f_active;
+
+    flash_entry[0] = (uint8_t)(data_off >> 16);
+    flash_entry[1] = (uint8_t)(data_off >> 8);
+    flash_entry[2] = (uint8_t)(data_off >> 0);
+    flash_entry[3] = (uint8_t)(len >> 8);
+    flash_entry[4] = (uint8_t)(len >> 0);
+    flash_entry[5] = crc8_calc(crc8_init(), flash_entry, FCB_ENTRY_SIZE - 1);
+
+    rc = fcb_write_to_sector(active,
+        active->fe_entry_num *
+        -fcb_len_in_flash(active->fe_range, FCB_ENTRY_SIZE),
+        flash_entry, FCB_ENTRY_SIZE);
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    return 0;
+}
+
 int
 fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
 {
     struct fcb_entry *active;
-    struct flash_sector_range *range;
-    uint8_t flash_entry[FCB_ENTRY_SIZE];
-    int sector;
     int rc;
 
     if (len == 0 || len >= FCB_MAX_LEN) {
@@ -173,48 +244,14 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
         return FCB_ERR_ARGS;
     }
     active = &fcb->f_active;
-    if (fcb_active_sector_free_space(fcb) < fcb_element_length_in_flash(active, len)) {
-        sector = fcb_new_sector(fcb, fcb->f_scratch_cnt);
-        if (sector >= 0) {
-            range = fcb_get_sector_range(fcb, sector);
-        }
-        if (sector < 0 || (range->fsr_sector_size <
-            fcb_len_in_flash(range, sizeof(struct fcb_disk_area)) +
-            fcb_len_in_flash(range, len) +
-            fcb_len_in_flash(range, FCB_CRC_LEN))) {
-            rc = FCB_ERR_NOSPACE;
-            goto err;
-        }
-        rc = fcb_sector_hdr_init(fcb, sector, fcb->f_active_id + 1);
-        if (rc) {
-            goto err;
-        }
-        fcb->f_active.fe_range = range;
-        fcb->f_active.fe_sector = sector;
-        /* Start with offset just after sector header */
-        fcb->f_active.fe_data_off =
-            fcb_len_in_flash(range, sizeof(struct fcb_disk_area));
-        /* No entries as yet */
-        fcb->f_active.fe_entry_num = 1;
-        fcb->f_active.fe_data_len = 0;
-        fcb->f_active_id++;
-    } else {
-        range = active->fe_range;
+    rc = fcb_append_reserve(fcb, fcb_element_length_in_flash(active, len), 1);
+    if (rc) {
+        goto err;
     }
 
     /* Write new entry at the end of the sector */
-    flash_entry[0] = (uint8_t)(fcb->f_active.fe_data_off >> 16);
-    flash_entry[1] = (uint8_t)(fcb->f_active.fe_data_off >> 8);
-    flash_entry[2] = (uint8_t)(fcb->f_active.fe_data_off >> 0);
-    flash_entry[3] = (uint8_t)(len >> 8);
-    flash_entry[4] = (uint8_t)(len >> 0);
-    flash_entry[5] = crc8_calc(crc8_init(), flash_entry, FCB_ENTRY_SIZE - 1);
-
-    rc = fcb_write_to_sector(active,
-        active->fe_entry_num * -fcb_len_in_flash(range, FCB_ENTRY_SIZE),
-        flash_entry, FCB_ENTRY_SIZE);
+    rc = fcb_append_entry(fcb, active->fe_data_off, len);
     if (rc) {
-        rc = FCB_ERR_FLASH;
         goto err;
     }
     *append_loc = *active;
@@ -233,6 +270,171 @@ err:
     return rc;
 }
 
+/*
+ * Staging buffer for fcb_append_batch(); flushed to flash when full.
+ */
+struct fcb_batch_buf {
+    struct fcb_entry *fbb_loc;
+    int fbb_off;
+    int fbb_used;
+    int fbb_cap;
+    uint8_t fbb_erased;
+    uint8_t fbb_buf[MYNEWT_VAL(FCB2_BATCH_BUF_SIZE)];
+};
+
+static int
+fcb_batch_flush(struct fcb_batch_buf *fbb)
+{
+    int rc;
+
+    if (fbb->fbb_used == 0) {
+        return 0;
+    }
+    rc = fcb_write_to_sector(fbb->fbb_loc, fbb->fbb_off, fbb->fbb_buf,
+        fbb->fbb_used);
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    fbb->fbb_off += fbb->fbb_used;
+    fbb->fbb_used = 0;
+    return 0;
+}
+
+/*
+ * Add len bytes from data to the batch, or erased filler if data is NULL.
+ */
+static int
+fcb_batch_put(struct fcb_batch_buf *fbb, const void *data, int len)
+{
+    int blk_sz;
+    int rc;
+
+    while (len > 0) {
+        if (fbb->fbb_used == fbb->fbb_cap) {
+            rc = fcb_batch_flush(fbb);
+            if (rc) {
+                return rc;
+            }
+        }
+        blk_sz = fbb->fbb_cap - fbb->fbb_used;
+        if (blk_sz > len) {
+            blk_sz = len;
+        }
+        if (data) {
+            memcpy(&fbb->fbb_buf[fbb->fbb_used], data, blk_sz);
+            data = (const uint8_t *)data + blk_sz;
+        } else {
+            memset(&fbb->fbb_buf[fbb->fbb_used], fbb->fbb_erased, blk_sz);
+        }
+        fbb->fbb_used += blk_sz;
+        len -= blk_sz;
+    }
+    return 0;
+}
+
+static int
+fcb_batch_put_aligned(struct fcb_batch_buf *fbb, const void *data, int len)
+{
+    int rc;
+
+    rc = fcb_batch_put(fbb, data, len);
+    if (rc) {
+        return rc;
+    }
+    return fcb_batch_put(fbb, NULL,
+        fcb_len_in_flash(fbb->fbb_loc->fe_range, len) - len);
+}
+
+int
+fcb_append_batch(struct fcb *fcb, const struct fcb_batch_elem *elems,
+                 int cnt, struct fcb_entry *locs)
+{
+    struct fcb_batch_buf fbb;
+    struct fcb_entry *active;
+    uint8_t fl_crc[FCB_CRC_LEN];
+    uint32_t data_off;
+    int total;
+    int align;
+    int rc;
+    int i;
+
+    if (cnt <= 0) {
+        return FCB_ERR_ARGS;
+    }
+    total = 0;
+    for (i = 0; i < cnt; i++) {
+        if (elems[i].fbe_len == 0 || elems[i].fbe_len >= FCB_MAX_LEN) {
+            return FCB_ERR_ARGS;
+        }
+        total += fcb_element_length_in_flash(&fcb->f_active, elems[i].fbe_len);
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    active = &fcb->f_active;
+    rc = fcb_append_reserve(fcb, total, cnt);
+    if (rc) {
+        goto err;
+    }
+    data_off = active->fe_data_off;
+
+    /*
+     * Only whole flash write units are flushed before the end of the batch.
+     */
+    align = active->fe_range->fsr_align ? active->fe_range->fsr_align : 1;
+    fbb.fbb_loc = active;
+    fbb.fbb_off = active->fe_data_off;
+    fbb.fbb_used = 0;
+    fbb.fbb_cap = sizeof(fbb.fbb_buf) - sizeof(fbb.fbb_buf) % align;
+    fbb.fbb_erased = flash_area_erased_val(&active->fe_range->fsr_flash_area);
+    if (fbb.fbb_cap == 0) {
+        rc = FCB_ERR_ARGS;
+        goto out;
+    }
+
+    /*
+     * Entry descriptors go first, one by one in entry order, so that the
+     * descriptor table never has holes.  If the data does not make it to
+     * flash, the entries are there but fail the CRC check.
+     */
+    for (i = 0; i < cnt; i++) {
+        rc = fcb_append_entry(fcb, data_off, elems[i].fbe_len);
+        if (rc) {
+            goto out;
+        }
+        if (locs) {
+            locs[i] = *active;
+            locs[i].fe_data_off = data_off;
+            locs[i].fe_data_len = elems[i].fbe_len;
+        }
+        data_off += fcb_element_length_in_flash(active, elems[i].fbe_len);
+        active->fe_entry_num++;
+    }
+
+    for (i = 0; i < cnt; i++) {
+        put_be16(fl_crc, crc16_ccitt(0xFFFF, elems[i].fbe_data,
+            elems[i].fbe_len));
+        rc = fcb_batch_put_aligned(&fbb, elems[i].fbe_data, elems[i].fbe_len);
+        if (!rc) {
+            rc = fcb_batch_put_aligned(&fbb, fl_crc, sizeof(fl_crc));
+        }
+        if (rc) {
+            break;
+        }
+    }
+    if (!rc) {
+        rc = fcb_batch_flush(&fbb);
+    }
+out:
+    /* Data space of every descriptor written is consumed */
+    active->fe_data_off = data_off;
+err:
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
+
 int
 fcb_append_finish(struct fcb_entry *loc)
 {
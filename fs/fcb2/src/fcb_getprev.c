@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+/*
+ * Count the entries in a sector by walking its entry table.  Only the
+ * table is read, not the entry data.  The count of the active sector is
+ * known; the counts of full sectors don't change, and are cached in
+ * f_entry_cnts.
+ */
+int
+fcb_sector_entry_cnt(struct fcb *fcb, int sector)
+{
+    struct fcb_entry loc;
+    uint32_t sector_off;
+    uint32_t data_end;
+    int rc;
+    int cnt;
+
+    if (sector == fcb->f_active.fe_sector) {
+        return fcb->f_active.fe_entry_num - 1;
+    }
+    if (fcb->f_entry_cnts &&
+        fcb->f_entry_cnts[sector] != FCB_ENTRY_CNT_UNKNOWN) {
+        return fcb->f_entry_cnts[sector];
+    }
+
+    loc.fe_sector = sector;
+    loc.fe_range = fcb_get_sector_range(fcb, sector);
+    sector_off = (sector - loc.fe_range->fsr_first_sector) *
+        loc.fe_range->fsr_sector_size;
+    data_end = fcb_len_in_flash(loc.fe_range, sizeof(struct fcb_disk_area));
+    for (cnt = 0; ; cnt++) {
+        loc.fe_entry_num = cnt + 1;
+        /* Table is full when it reaches the data of the entries */
+        if (fcb_entry_location_in_range(&loc) < sector_off + data_end) {
+            break;
+        }
+        rc = fcb_read_entry(&loc);
+        if (rc == FCB_ERR_NOVAR) {
+            break;
+        } else if (rc == 0) {
+            data_end = loc.fe_data_off +
+                fcb_len_in_flash(loc.fe_range, loc.fe_data_len) +
+                fcb_len_in_flash(loc.fe_range, FCB_CRC_LEN);
+        } else if (rc != FCB_ERR_CRC) {
+            return rc;
+        }
+    }
+
+    if (fcb->f_entry_cnts) {
+        fcb->f_entry_cnts[sector] = cnt;
+    }
+    return cnt;
+}
+
+int
+fcb_getprev(struct fcb *fcb, struct fcb_entry *loc)
+{
+    int rc;
+    int cnt;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    if (loc->fe_range == NULL) {
+        /*
+         * Start after the last one we have in flash.
+         */
+        loc->fe_sector = fcb->f_active.fe_sector;
+        loc->fe_range = fcb->f_active.fe_range;
+        loc->fe_entry_num = fcb->f_active.fe_entry_num;
+    }
+    while (1) {
+        if (loc->fe_entry_num > 1) {
+            loc->fe_entry_num--;
+            rc = fcb_elem_info(loc);
+            if (rc == 0 || (rc != FCB_ERR_CRC && rc != FCB_ERR_NOVAR)) {
+                break;
+            }
+            continue;
+        }
+
+        /*
+         * Moving to previous sector.
+         */
+        if (loc->fe_sector == fcb->f_oldest_sec) {
+            rc = FCB_ERR_NOVAR;
+            break;
+        }
+        loc->fe_sector = fcb_getprev_sector(fcb, loc->fe_sector);
+        loc->fe_range = fcb_get_sector_range(fcb, loc->fe_sector);
+        cnt = fcb_sector_entry_cnt(fcb, loc->fe_sector);
+        if (cnt < 0) {
+            rc = cnt;
+            break;
+        }
+        loc->fe_entry_num = cnt + 1;
+    }
+    os_mutex_release(&fcb->f_mtx);
+
+    return rc;
+}
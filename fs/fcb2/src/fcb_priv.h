@@ -27,6 +27,8 @@ extern "C" {
 
 #define FCB_ID_GT(a, b) (((int16_t)(a) - (int16_t)(b)) > 0)
 
+#define FCB_ENTRY_CNT_UNKNOWN   UINT16_MAX
+
 struct fcb_disk_area {
     uint32_t fd_magic;
     uint8_t  fd_ver;
@@ -55,9 +57,32 @@ fcb_getnext_sector(struct fcb *fcb, int sector)
     return sector;
 }
 
+static inline int
+fcb_getprev_sector(struct fcb *fcb, int sector)
+{
+    if (--sector < 0) {
+        sector = fcb->f_sector_cnt - 1;
+    }
+    return sector;
+}
+
+/*
+ * Number of sectors from sector 'from' forward to sector 'to'.
+ */
+static inline int
+fcb_sector_dist(struct fcb *fcb, int from, int to)
+{
+    if (to < from) {
+        to += fcb->f_sector_cnt;
+    }
+    return to - from;
+}
+
 int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
+int fcb_sector_entry_cnt(struct fcb *fcb, int sector);
 
 int fcb_elem_info(struct fcb_entry *loc);
+int fcb_read_entry(struct fcb_entry *loc);
 int fcb_elem_crc8(struct fcb_entry *loc, uint8_t *crc8p);
 int fcb_elem_crc16(struct fcb_entry *loc, uint16_t *c16p);
 int fcb_sector_hdr_init(struct fcb *fcb, int sector, uint16_t id);
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+uint32_t
+fcb_entry_seq(struct fcb *fcb, const struct fcb_entry *loc)
+{
+    uint16_t id;
+
+    id = fcb->f_active_id -
+        fcb_sector_dist(fcb, loc->fe_sector, fcb->f_active.fe_sector);
+    return ((uint32_t)id << 16) | loc->fe_entry_num;
+}
+
+int
+fcb_seek_seq(struct fcb *fcb, uint32_t seq, struct fcb_entry *loc)
+{
+    int16_t back;
+    int sector;
+    int num;
+    int cnt;
+    int rc;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+
+    /*
+     * Sector ids grow by one from the oldest sector to the active one.
+     */
+    back = fcb->f_active_id - (uint16_t)(seq >> 16);
+    num = seq & 0xffff;
+    if (back < 0) {
+        rc = FCB_ERR_NOVAR;
+        goto out;
+    }
+    if (back > fcb_sector_dist(fcb, fcb->f_oldest_sec,
+                               fcb->f_active.fe_sector)) {
+        sector = fcb->f_oldest_sec;
+        num = 1;
+    } else {
+        sector = fcb->f_active.fe_sector - back;
+        if (sector < 0) {
+            sector += fcb->f_sector_cnt;
+        }
+        if (num == 0) {
+            num = 1;
+        }
+    }
+
+    loc->fe_sector = sector;
+    loc->fe_range = fcb_get_sector_range(fcb, sector);
+    cnt = fcb_sector_entry_cnt(fcb, sector);
+    while (1) {
+        if (cnt < 0) {
+            rc = cnt;
+            break;
+        }
+        if (num > cnt) {
+            /*
+             * Moving to next sector.
+             */
+            if (loc->fe_sector == fcb->f_active.fe_sector) {
+                rc = FCB_ERR_NOVAR;
+                break;
+            }
+            loc->fe_sector = fcb_getnext_sector(fcb, loc->fe_sector);
+            loc->fe_range = fcb_get_sector_range(fcb, loc->fe_sector);
+            cnt = fcb_sector_entry_cnt(fcb, loc->fe_sector);
+            num = 1;
+            continue;
+        }
+        loc->fe_entry_num = num;
+        rc = fcb_elem_info(loc);
+        if (rc == 0 || (rc != FCB_ERR_CRC && rc != FCB_ERR_NOVAR)) {
+            break;
+        }
+        num++;
+    }
+out:
+    os_mutex_release(&fcb->f_mtx);
+
+    return rc;
+}
@@ -152,6 +152,8 @@ TEST_CASE_DECL(fcb_test_rotate)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
 TEST_CASE_DECL(fcb_test_area_info)
+TEST_CASE_DECL(fcb_test_getprev)
+TEST_CASE_DECL(fcb_test_append_batch)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -187,6 +189,12 @@ TEST_SUITE(fcb_test_all)
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
     fcb_test_area_info();
 
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
+    fcb_test_getprev();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_append_batch();
+
 }
 
 #if MYNEWT_VAL(SELFTEST)
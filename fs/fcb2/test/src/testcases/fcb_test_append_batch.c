@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_BATCH_ELEMS    128
+#define FCB_TEST_BATCH_SZ       16
+
+static uint8_t fcb_test_batch_data[FCB_TEST_BATCH_ELEMS][FCB_TEST_BATCH_ELEMS];
+static struct fcb_batch_elem fcb_test_batch_elems[FCB_TEST_BATCH_ELEMS];
+static struct fcb_entry fcb_test_batch_locs[FCB_TEST_BATCH_ELEMS];
+
+static struct flash_sector_range fcb_test_batch_range = {
+    .fsr_flash_area = {
+        .fa_device_id = 0,
+        .fa_off = 0x8000,
+        .fa_size = 0x8000,
+    },
+    .fsr_range_start = 0,
+    .fsr_first_sector = 0,
+    .fsr_sector_size = 0x4000,
+    .fsr_sector_count = 2,
+    .fsr_align = 1,
+};
+
+TEST_CASE(fcb_test_append_batch)
+{
+    struct fcb single;
+    struct fcb_entry loc;
+    struct fcb_entry active;
+    struct fcb *fcb;
+    uint8_t buf1[64];
+    uint8_t buf2[64];
+    uint32_t off;
+    int var_cnt;
+    int blk_sz;
+    int cnt;
+    int rc;
+    int i;
+    int j;
+
+    fcb = &test_fcb;
+
+    rc = flash_area_erase(&fcb_test_batch_range.fsr_flash_area, 0,
+      fcb_test_batch_range.fsr_flash_area.fa_size);
+    TEST_ASSERT_FATAL(rc == 0);
+    memset(&single, 0, sizeof(single));
+    single.f_sector_cnt = 2;
+    single.f_ranges = &fcb_test_batch_range;
+    single.f_range_cnt = 1;
+    rc = fcb_init(&single);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 1; i < FCB_TEST_BATCH_ELEMS; i++) {
+        for (j = 0; j < i; j++) {
+            fcb_test_batch_data[i][j] = fcb_test_append_data(i, j);
+        }
+        fcb_test_batch_elems[i].fbe_data = fcb_test_batch_data[i];
+        fcb_test_batch_elems[i].fbe_len = i;
+    }
+
+    /* Empty entries are not allowed */
+    rc = fcb_append_batch(fcb, fcb_test_batch_elems, 2, NULL);
+    TEST_ASSERT(rc == FCB_ERR_ARGS);
+    rc = fcb_append_batch(fcb, &fcb_test_batch_elems[1], 0, NULL);
+    TEST_ASSERT(rc == FCB_ERR_ARGS);
+
+    for (i = 1; i < FCB_TEST_BATCH_ELEMS; i += cnt) {
+        cnt = min(FCB_TEST_BATCH_SZ, FCB_TEST_BATCH_ELEMS - i);
+        rc = fcb_append_batch(fcb, &fcb_test_batch_elems[i], cnt,
+          &fcb_test_batch_locs[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    for (i = 1; i < FCB_TEST_BATCH_ELEMS; i++) {
+        rc = fcb_append(&single, i, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb_write(&loc, 0, fcb_test_batch_data[i], i);
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(&loc);
+        TEST_ASSERT(rc == 0);
+
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_sector == 0);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_entry_num == loc.fe_entry_num);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_data_off == loc.fe_data_off);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_data_len == i);
+    }
+
+    var_cnt = 1;
+    rc = fcb_walk(fcb, FCB_SECTOR_OLDEST, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == FCB_TEST_BATCH_ELEMS);
+
+    /*
+     * Batches end up on flash exactly like entries appended one by one.
+     */
+    TEST_ASSERT_FATAL(fcb->f_active.fe_entry_num ==
+      single.f_active.fe_entry_num);
+    TEST_ASSERT_FATAL(fcb->f_active.fe_data_off ==
+      single.f_active.fe_data_off);
+    for (off = 0; off < fcb_test_batch_range.fsr_sector_size; off += blk_sz) {
+        blk_sz = sizeof(buf1);
+        rc = flash_area_read(&test_fcb_ranges[0].fsr_flash_area, off, buf1,
+          blk_sz);
+        TEST_ASSERT(rc == 0);
+        rc = flash_area_read(&fcb_test_batch_range.fsr_flash_area, off, buf2,
+          blk_sz);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT_FATAL(memcmp(buf1, buf2, blk_sz) == 0);
+    }
+
+    /*
+     * A batch is never split across sectors.
+     */
+    rc = fcb_append_batch(fcb, &fcb_test_batch_elems[1],
+      FCB_TEST_BATCH_ELEMS - 1, &fcb_test_batch_locs[1]);
+    TEST_ASSERT(rc == 0);
+    for (i = 1; i < FCB_TEST_BATCH_ELEMS; i++) {
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_sector == 1);
+        TEST_ASSERT(fcb_test_batch_locs[i].fe_entry_num == i);
+    }
+
+    var_cnt = 1;
+    rc = fcb_walk(fcb, 1, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == FCB_TEST_BATCH_ELEMS);
+
+    /*
+     * A batch which does not fit is refused without side effects.
+     */
+    active = fcb->f_active;
+    rc = fcb_append_batch(fcb, &fcb_test_batch_elems[1],
+      FCB_TEST_BATCH_ELEMS - 1, NULL);
+    TEST_ASSERT(rc == FCB_ERR_NOSPACE);
+    TEST_ASSERT(fcb->f_active.fe_sector == active.fe_sector);
+    TEST_ASSERT(fcb->f_active.fe_entry_num == active.fe_entry_num);
+    TEST_ASSERT(fcb->f_active.fe_data_off == active.fe_data_off);
+}
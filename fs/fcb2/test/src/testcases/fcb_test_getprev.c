@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_GETPREV_CNT    400
+
+static struct fcb_entry fcb_test_getprev_locs[FCB_TEST_GETPREV_CNT];
+static uint32_t fcb_test_getprev_seqs[FCB_TEST_GETPREV_CNT];
+
+static void
+fcb_test_getprev_check(struct fcb *fcb, int first, int last)
+{
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    memset(&loc, 0, sizeof(loc));
+    for (i = last; i >= first; i--) {
+        if (i % 7 == 3) {
+            /* Never finished */
+            continue;
+        }
+        rc = fcb_getprev(fcb, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(loc.fe_sector == fcb_test_getprev_locs[i].fe_sector);
+        TEST_ASSERT(loc.fe_data_off == fcb_test_getprev_locs[i].fe_data_off);
+        TEST_ASSERT(loc.fe_data_len == fcb_test_getprev_locs[i].fe_data_len);
+        TEST_ASSERT(fcb_entry_seq(fcb, &loc) == fcb_test_getprev_seqs[i]);
+    }
+    rc = fcb_getprev(fcb, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+}
+
+TEST_CASE(fcb_test_getprev)
+{
+    uint16_t entry_cnts[4];
+    uint8_t test_data[128];
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    int first;
+    int rc;
+    int i;
+
+    fcb = &test_fcb;
+
+    /* Nothing to return when empty */
+    memset(&loc, 0, sizeof(loc));
+    rc = fcb_getprev(fcb, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+    rc = fcb_seek_seq(fcb, 0, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    for (i = 0; i < FCB_TEST_GETPREV_CNT; i++) {
+        rc = fcb_append(fcb, 64 + i % 64, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        memset(test_data, i, sizeof(test_data));
+        rc = fcb_write(&loc, 0, test_data, loc.fe_data_len);
+        TEST_ASSERT(rc == 0);
+
+        if (i % 7 != 3) {
+            rc = fcb_append_finish(&loc);
+            TEST_ASSERT(rc == 0);
+        }
+        fcb_test_getprev_locs[i] = loc;
+        fcb_test_getprev_seqs[i] = fcb_entry_seq(fcb, &loc);
+        if (i > 0) {
+            TEST_ASSERT((int32_t)(fcb_test_getprev_seqs[i] -
+              fcb_test_getprev_seqs[i - 1]) > 0);
+        }
+    }
+    TEST_ASSERT(fcb_test_getprev_locs[FCB_TEST_GETPREV_CNT - 1].fe_sector >=
+      2);
+
+    fcb_test_getprev_check(fcb, 0, FCB_TEST_GETPREV_CNT - 1);
+
+    /*
+     * Same after a reboot, with the entry counts cached.
+     */
+    fcb->f_entry_cnts = entry_cnts;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(entry_cnts[i] == 0xffff);
+    }
+    fcb_test_getprev_check(fcb, 0, FCB_TEST_GETPREV_CNT - 1);
+    TEST_ASSERT(entry_cnts[0] + entry_cnts[1] + fcb->f_active.fe_entry_num - 1
+      == FCB_TEST_GETPREV_CNT);
+    fcb_test_getprev_check(fcb, 0, FCB_TEST_GETPREV_CNT - 1);
+
+    /*
+     * Seek to every entry; unfinished ones resolve to the entry after.
+     */
+    for (i = 0; i < FCB_TEST_GETPREV_CNT; i++) {
+        rc = fcb_seek_seq(fcb, fcb_test_getprev_seqs[i], &loc);
+        if (i == FCB_TEST_GETPREV_CNT - 1 && i % 7 == 3) {
+            TEST_ASSERT(rc == FCB_ERR_NOVAR);
+            continue;
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        if (i % 7 == 3) {
+            TEST_ASSERT(fcb_entry_seq(fcb, &loc) ==
+              fcb_test_getprev_seqs[i + 1]);
+        } else {
+            TEST_ASSERT(loc.fe_sector == fcb_test_getprev_locs[i].fe_sector);
+            TEST_ASSERT(loc.fe_data_off ==
+              fcb_test_getprev_locs[i].fe_data_off);
+        }
+
+        /* Resume after entry i */
+        rc = fcb_seek_seq(fcb, fcb_test_getprev_seqs[i] + 1, &loc);
+        if (i == FCB_TEST_GETPREV_CNT - 1) {
+            TEST_ASSERT(rc == FCB_ERR_NOVAR);
+        } else {
+            TEST_ASSERT(rc == 0);
+            TEST_ASSERT((int32_t)(fcb_entry_seq(fcb, &loc) -
+              fcb_test_getprev_seqs[i]) > 0);
+        }
+    }
+
+    /*
+     * Sequence numbers of rotated out entries seek to the oldest one.
+     */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    for (first = 0; fcb_test_getprev_locs[first].fe_sector == 0; first++);
+    rc = fcb_seek_seq(fcb, fcb_test_getprev_seqs[0], &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_entry_seq(fcb, &loc) == fcb_test_getprev_seqs[first]);
+    fcb_test_getprev_check(fcb, first, FCB_TEST_GETPREV_CNT - 1);
+
+    rc = fcb_offset_last_n(fcb, 10, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_entry_seq(fcb, &loc) ==
+      fcb_test_getprev_seqs[FCB_TEST_GETPREV_CNT - 11]);
+}
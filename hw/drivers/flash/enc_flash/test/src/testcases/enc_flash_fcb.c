@@ -17,12 +17,15 @@
  * under the License.
  */
 
+#include <string.h>
+
 #include <fcb/fcb.h>
 #include "enc_flash_test.h"
 
 static void
 enc_flash_test_fcb_init(struct fcb *fcb)
 {
+    memset(fcb, 0, sizeof(*fcb));
     fcb->f_magic = 0xdeadbeef;
     fcb->f_sector_cnt = ENC_TEST_FLASH_AREA_CNT;
     fcb->f_scratch_cnt = 0;
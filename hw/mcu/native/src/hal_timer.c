@@ -40,6 +40,24 @@ struct native_timer {
     TAILQ_HEAD(hal_timer_qhead, hal_timer) timers;
 } native_timers[1];
 
+/**
+ * Returns the number of OS ticks until the timer counter reaches 'tick',
+ * rounded up so that the callout never fires before the timer expires.
+ * Otherwise the timer task would keep rescheduling itself for the current OS
+ * tick, which never ends when OS time only advances in idle.
+ */
+static os_time_t
+native_timer_osticks(struct native_timer *nt, uint32_t tick)
+{
+    int32_t delta;
+
+    delta = (int32_t)(tick - hal_timer_read(nt->num));
+    if (delta <= 0) {
+        return 0;
+    }
+    return (delta + nt->ticks_per_ostick - 1) / nt->ticks_per_ostick;
+}
+
 /**
  * This is the function called when the timer fires.
  *
@@ -66,8 +84,7 @@ native_timer_cb(struct os_event *ev)
     }
     ht = TAILQ_FIRST(&nt->timers);
     if (ht) {
-        os_callout_reset(&nt->callout,
-          (ht->expiry - hal_timer_read(nt->num)) / nt->ticks_per_ostick);
+        os_callout_reset(&nt->callout, native_timer_osticks(nt, ht->expiry));
     }
     OS_EXIT_CRITICAL(sr);
 }
@@ -201,6 +218,9 @@ int
 hal_timer_delay(int num, uint32_t ticks)
 {
     uint32_t until;
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    os_sr_t sr;
+#endif
 
     if (num != 0) {
         return -1;
@@ -208,7 +228,12 @@ hal_timer_delay(int num, uint32_t ticks)
 
     until = hal_timer_read(0) + ticks;
     while ((int32_t)(hal_timer_read(0) - until) <= 0) {
-        ;
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+        /* Nothing else moves virtual time forward while we spin. */
+        OS_ENTER_CRITICAL(sr);
+        os_time_advance(1);
+        OS_EXIT_CRITICAL(sr);
+#endif
     }
     return 0;
 }
@@ -278,7 +303,6 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
     struct native_timer *nt;
     struct hal_timer *ht;
     uint32_t curtime;
-    uint32_t osticks;
     os_sr_t sr;
 
     nt = (struct native_timer *)timer->bsp_timer;
@@ -309,8 +333,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
         os_callout_reset(&nt->callout, 0);
     } else {
         if (timer == TAILQ_FIRST(&nt->timers)) {
-            osticks = (tick - curtime) / nt->ticks_per_ostick;
-            os_callout_reset(&nt->callout, osticks);
+            os_callout_reset(&nt->callout, native_timer_osticks(nt, tick));
         }
     }
     OS_EXIT_CRITICAL(sr);
@@ -350,8 +373,7 @@ hal_timer_stop(struct hal_timer *timer)
         if (reset_ocmp) {
             if (ht) {
                 os_callout_reset(&nt->callout,
-                  (ht->expiry - hal_timer_read(nt->num)) /
-                    nt->ticks_per_ostick);
+                                 native_timer_osticks(nt, ht->expiry));
             } else {
                 os_callout_stop(&nt->callout);
             }
@@ -122,6 +122,7 @@ void os_system_reset(void);
 #include "os/os_callout.h"
 #include "os/os_cfg.h"
 #include "os/os_cputime.h"
+#include "os/os_crit_trace.h"
 #include "os/os_dev.h"
 #include "os/os_error.h"
 #include "os/os_eventq.h"
@@ -130,6 +131,7 @@ void os_system_reset(void);
 #include "os/os_mbuf.h"
 #include "os/os_mempool.h"
 #include "os/os_mutex.h"
+#include "os/os_rwlock.h"
 #include "os/os_sanity.h"
 #include "os/os_sched.h"
 #include "os/os_sem.h"
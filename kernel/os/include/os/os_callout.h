@@ -45,6 +45,10 @@ struct os_callout {
     struct os_eventq *c_evq;
     /** Number of ticks in the future to expire the callout */
     os_time_t c_ticks;
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+    /** Number of ticks the callout may expire late */
+    os_time_t c_slack;
+#endif
 
 
     TAILQ_ENTRY(os_callout) c_next;
@@ -99,6 +103,18 @@ void os_callout_stop(struct os_callout *);
  */
 int os_callout_reset(struct os_callout *, os_time_t);
 
+/**
+ * Allow the callout to expire up to 'slack' ticks after the time given to
+ * os_callout_reset().  Callouts whose windows overlap are expired together,
+ * which lets the system sleep longer between wakeups.  The slack is kept
+ * across resets until it is changed again.  It is ignored unless
+ * OS_TIMER_SLACK is enabled.
+ *
+ * @param c The callout to configure; must have been initialized
+ * @param slack The number of ticks the callout may be late
+ */
+void os_callout_set_slack(struct os_callout *c, os_time_t slack);
+
 /**
  * Returns the number of ticks which remains to callout.
  *
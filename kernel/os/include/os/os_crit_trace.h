@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+ /**
+  * @addtogroup OSKernel
+  * @{
+  *   @defgroup OSCritTrace Critical Section Tracing
+  *   @{
+  */
+
+#ifndef H_OS_CRIT_TRACE_
+#define H_OS_CRIT_TRACE_
+
+#include <stdint.h>
+#include "syscfg/syscfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+
+/**
+ * One of the longest critical sections seen, returned by
+ * os_crit_trace_get().
+ */
+struct os_crit_info {
+    /** Return address of the caller that disabled interrupts */
+    uintptr_t oci_ra;
+    /** Longest time, in os_cputime ticks, it kept interrupts disabled */
+    uint32_t oci_ticks;
+};
+
+/** @cond INTERNAL_HIDDEN */
+/*
+ * Called by the architecture port when the outermost critical section is
+ * entered (after disabling interrupts) and left (before enabling them).
+ */
+void os_crit_trace_enter(void *ra);
+void os_crit_trace_exit(void);
+/** @endcond */
+
+/**
+ * Copy the table of longest critical sections, longest first.  Every
+ * caller appears at most once.
+ *
+ * @param info  Array to fill out
+ * @param max   Number of elements in info
+ *
+ * @return The number of entries filled out
+ */
+int os_crit_trace_get(struct os_crit_info *info, int max);
+
+/**
+ * Clear the table of longest critical sections.
+ */
+void os_crit_trace_reset(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_OS_CRIT_TRACE_ */
+
+/**
+ *   @} OSCritTrace
+ * @} OSKernel
+ */
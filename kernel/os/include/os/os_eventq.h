@@ -46,6 +46,14 @@ typedef void os_event_fn(struct os_event *ev);
 struct os_event {
     /** Whether this OS event is queued on an event queue. */
     uint8_t ev_queued;
+    /** Event flags, OS_EVENT_F_* */
+    uint8_t ev_flags;
+    /**
+     * For OS_EVENT_F_COALESCE events, the number of times the event was
+     * posted again while already queued.  Reset when the event is queued,
+     * so the callback sees the number of posts merged into this delivery.
+     */
+    uint16_t ev_coalesced;
     /**
      * Callback to call when the event is taken off of an event queue.
      * APIs, except for os_eventq_run(), assume this callback will be called by
@@ -59,9 +67,32 @@ struct os_event {
     STAILQ_ENTRY(os_event) ev_next;
 };
 
+/**
+ * Count posts of an already queued event in ev_coalesced instead of
+ * dropping them silently.
+ */
+#define OS_EVENT_F_COALESCE     (0x01)
+
 /** Return whether or not the given event is queued. */
 #define OS_EVENT_QUEUED(__ev) ((__ev)->ev_queued)
 
+/**
+ * Fixed-capacity single-producer/single-consumer ring of event pointers.
+ * A ring is attached to an event queue with os_eventq_ring_init(); its
+ * events are then returned by the regular get, poll and run functions of
+ * that queue.
+ */
+struct os_eventq_ring {
+    /** Storage for er_size event pointers */
+    struct os_event **er_events;
+    /** Number of slots; a power of two */
+    uint16_t er_size;
+    /** Free running index of the next slot to fill (producer) */
+    volatile uint16_t er_head;
+    /** Free running index of the next slot to drain (consumer) */
+    volatile uint16_t er_tail;
+};
+
 struct os_eventq {
     /** Pointer to task that "owns" this event queue. */
     struct os_task *evq_owner;
@@ -71,6 +102,10 @@ struct os_eventq {
      */
     struct os_task *evq_task;
 
+#if MYNEWT_VAL(OS_EVENTQ_RING)
+    /** Ring of events attached to this queue, or NULL */
+    struct os_eventq_ring *evq_ring;
+#endif
 
     STAILQ_HEAD(, os_event) evq_list;
 };
@@ -98,6 +133,39 @@ int os_eventq_inited(const struct os_eventq *evq);
  */
 void os_eventq_put(struct os_eventq *, struct os_event *);
 
+#if MYNEWT_VAL(OS_EVENTQ_RING)
+/**
+ * Attach a ring to an event queue.  The queue must have been initialized
+ * with os_eventq_init().
+ *
+ * @param evq The event queue to attach the ring to
+ * @param ring The ring to initialize
+ * @param events Storage for the ring, an array of size event pointers
+ * @param size Number of slots in the ring; must be a power of two no
+ *             larger than 32768
+ *
+ * @return 0 on success, OS_EINVAL if size is invalid
+ */
+int os_eventq_ring_init(struct os_eventq *evq, struct os_eventq_ring *ring,
+                        struct os_event **events, uint16_t size);
+
+/**
+ * Push an event on the ring attached to an event queue.  Unlike
+ * os_eventq_put(), interrupts are only disabled if the consumer task is
+ * sleeping on the queue and needs to be woken up.
+ *
+ * There must be a single producer (typically one interrupt handler) per
+ * ring, and the queue must only be read by its owner task.  The event is
+ * not marked as queued; pushing the same event twice delivers it twice.
+ *
+ * @param evq The event queue whose ring to push to
+ * @param ev The event to push
+ *
+ * @return 0 on success, OS_ENOMEM if the ring is full
+ */
+int os_eventq_ring_put(struct os_eventq *evq, struct os_event *ev);
+#endif
+
 /**
  * Poll an event from the event queue and return it immediately.
  * If no event is available, don't block, just return NULL.
@@ -124,6 +192,23 @@ struct os_event *os_eventq_get(struct os_eventq *);
  */
 void os_eventq_run(struct os_eventq *evq);
 
+/**
+ * Pull up to max items off the event queue and call their event callbacks.
+ * Blocks until at least one event is available, then dispatches further
+ * pending events, up to the limit, without blocking again.
+ *
+ * Pending events are taken off the queue several at a time with interrupts
+ * disabled once.  Callbacks may still remove, reinitialize or requeue any
+ * other event: one removed before its turn is not dispatched, and one
+ * requeued after that runs once, from the queue.
+ *
+ * @param evq The event queue to pull the items off.
+ * @param max The maximum number of events to dispatch; must be positive.
+ *
+ * @return The number of events dispatched.
+ */
+int os_eventq_run_batch(struct os_eventq *evq, int max);
+
 
 /**
  * Poll the list of event queues specified by the evq parameter
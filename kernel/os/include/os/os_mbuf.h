@@ -102,6 +102,19 @@ struct os_mbuf {
 
     SLIST_ENTRY(os_mbuf) om_next;
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    /**
+     * The mbuf whose data buffer holds this mbuf's data, or NULL if the data
+     * is in this mbuf's own buffer.  See os_mbuf_clone().
+     */
+    struct os_mbuf *om_shared;
+    /**
+     * Number of references to this mbuf's block: one while the mbuf itself
+     * is allocated, plus one per mbuf using its data buffer.
+     */
+    uint16_t om_refcnt;
+#endif
+
     /**
      * Pointer to the beginning of the data, after this buffer
      */
@@ -117,6 +130,28 @@ struct os_mqueue {
     struct os_event mq_ev;
 };
 
+/**
+ * Cursor over the data of an mbuf chain.  Lets a reader walk a chain, and
+ * peek at values that straddle two mbufs, without copying the chain or
+ * seeking from its head for every access.
+ */
+struct os_mbuf_iter {
+    /** Mbuf containing the cursor; NULL if the chain was empty */
+    const struct os_mbuf *omi_om;
+    /** Offset of the cursor within omi_om */
+    uint16_t omi_off;
+};
+
+/**
+ * One contiguous region of an mbuf chain, as filled in by os_mbuf_to_iovec().
+ */
+struct os_iovec {
+    /** Start of the region */
+    void *iov_base;
+    /** Length of the region, in bytes */
+    size_t iov_len;
+};
+
 /*
  * Given a flag number, provide the mask for it
  *
@@ -175,6 +210,18 @@ struct os_mqueue {
 
 /** @cond INTERNAL_HIDDEN */
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+/*
+ * Whether the data buffer of an mbuf is shared with other mbufs.  Shared
+ * data can't grow in place.
+ */
+static inline int
+_os_mbuf_is_shared(const struct os_mbuf *om)
+{
+    return om->om_shared != NULL || om->om_refcnt > 1;
+}
+#endif
+
 /*
  * Called by OS_MBUF_LEADINGSPACE() macro
  */
@@ -184,6 +231,12 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    if (_os_mbuf_is_shared(om)) {
+        return 0;
+    }
+#endif
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -218,6 +271,12 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    if (_os_mbuf_is_shared(om)) {
+        return 0;
+    }
+#endif
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -298,7 +357,9 @@ int os_msys_register(struct os_mbuf_pool *);
 
 /**
  * Allocate a mbuf from msys.  Based upon the data size requested,
- * os_msys_get() will choose the mbuf pool that has the best fit.
+ * os_msys_get() will choose the mbuf pool that has the best fit.  If that
+ * pool is empty, MSYS_FALLBACK_LARGER and MSYS_FALLBACK_SMALLER control
+ * whether another pool is tried.
  *
  * @param dsize The estimated size of the data being stored in the mbuf
  * @param leadingspace The amount of leadingspace to allocate in the mbuf
@@ -362,6 +423,20 @@ int os_mbuf_pool_init(struct os_mbuf_pool *, struct os_mempool *mp,
  */
 struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t);
 
+/**
+ * Allocate a chain of empty mbufs, with enough room to hold total_len bytes
+ * of data, out of the os_mbuf_pool.  The blocks are taken from the memory
+ * pool in batches, so building the chain is cheaper than calling
+ * os_mbuf_get() for every buffer.  Either the whole chain is allocated or
+ * nothing is.
+ *
+ * @param omp The mbuf pool to allocate out of
+ * @param total_len The number of data bytes the chain must be able to hold
+ *
+ * @return The first mbuf of the chain on success, NULL on failure.
+ */
+struct os_mbuf *os_mbuf_get_chain(struct os_mbuf_pool *omp, int total_len);
+
 /**
  * Allocate a new packet header mbuf out of the os_mbuf_pool.
  *
@@ -383,6 +458,26 @@ struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
  */
 struct os_mbuf *os_mbuf_dup(struct os_mbuf *m);
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+/**
+ * Clone a chain of mbufs without copying its data.  Every mbuf of the clone
+ * refers to the data buffer of the corresponding mbuf in the original chain,
+ * which is returned to its pool once the last mbuf using it is freed.  The
+ * packet header, if any, is copied.
+ *
+ * Shared data has no leading or trailing space, so prepending and appending
+ * allocate new mbufs.  os_mbuf_copyinto() gives an mbuf a private copy of its
+ * data before modifying it; data of a cloned chain must not be modified
+ * through om_data directly.
+ *
+ * @param om The mbuf chain to clone
+ *
+ * @return A pointer to the new chain of mbufs, NULL if the mbufs could not
+ *         be allocated.
+ */
+struct os_mbuf *os_mbuf_clone(struct os_mbuf *om);
+#endif
+
 /**
  * Locates the specified absolute offset within an mbuf chain.  The offset
  * can be one past than the total length of the chain, but no greater.
@@ -414,6 +509,86 @@ struct os_mbuf *os_mbuf_off(const struct os_mbuf *om, int off,
  */
 int os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst);
 
+/**
+ * Positions an iterator at the specified absolute offset within an mbuf
+ * chain.  The offset can be equal to the length of the chain, in which case
+ * the iterator is positioned at the end.
+ *
+ * @param it                    The iterator to initialize.
+ * @param om                    The start of the mbuf chain to walk.
+ * @param off                   The absolute offset to start at.
+ *
+ * @return                      0 on success;
+ *                              -1 if the offset is out of bounds.
+ */
+int os_mbuf_iter_init(struct os_mbuf_iter *it, const struct os_mbuf *om,
+                      int off);
+
+/**
+ * Retrieves the contiguous run of bytes that starts at the iterator's
+ * position.  The iterator is not moved.
+ *
+ * @param it                    The iterator to query.
+ * @param out_data              On success, points to the first byte of the
+ *                                  run.
+ *
+ * @return                      The number of contiguous bytes available;
+ *                              0 if the iterator is at the end of the chain.
+ */
+int os_mbuf_iter_seg(const struct os_mbuf_iter *it, const uint8_t **out_data);
+
+/**
+ * Provides access to the next "len" bytes of an mbuf chain without moving the
+ * iterator.  If the bytes are contiguous, a pointer into the mbuf is returned
+ * and nothing is copied.  Otherwise the bytes are gathered into the supplied
+ * buffer.
+ *
+ * @param it                    The iterator to peek through.
+ * @param buf                   Buffer of at least "len" bytes to use when the
+ *                                  requested bytes span several mbufs.  May
+ *                                  be NULL, in which case only contiguous
+ *                                  requests can succeed.
+ * @param len                   The number of bytes to peek at.
+ *
+ * @return                      A pointer to the requested bytes on success;
+ *                              NULL if the chain does not contain enough
+ *                                  data, or if the bytes are not contiguous
+ *                                  and no buffer was supplied.
+ */
+const void *os_mbuf_iter_peek(const struct os_mbuf_iter *it, void *buf,
+                              int len);
+
+/**
+ * Moves an iterator forward by the specified number of bytes, crossing mbuf
+ * boundaries as necessary.
+ *
+ * @param it                    The iterator to move.
+ * @param len                   The number of bytes to skip.
+ *
+ * @return                      0 on success;
+ *                              -1 if the chain does not contain enough data.
+ *                                  The iterator is left at the end of the
+ *                                  chain.
+ */
+int os_mbuf_iter_advance(struct os_mbuf_iter *it, int len);
+
+/**
+ * Describes a range of an mbuf chain as a list of contiguous regions, without
+ * copying any data.  Empty mbufs are skipped.
+ *
+ * @param om                    The start of the mbuf chain to describe.
+ * @param off                   The absolute offset of the start of the range.
+ * @param len                   The length of the range, in bytes.
+ * @param iov                   The array of regions to fill in.
+ * @param iov_cnt               The number of entries in the iov array.
+ *
+ * @return                      The number of regions filled in on success;
+ *                              -1 if the chain does not contain the range or
+ *                                  the range spans more than iov_cnt regions.
+ */
+int os_mbuf_to_iovec(const struct os_mbuf *om, int off, int len,
+                     struct os_iovec *iov, int iov_cnt);
+
 /**
  * @brief Calculates the length of an mbuf chain.
  *
@@ -468,7 +643,8 @@ int os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
 int os_mbuf_free(struct os_mbuf *mb);
 
 /**
- * Free a chain of mbufs
+ * Free a chain of mbufs.  Consecutive mbufs from the same pool are returned
+ * to their memory pool in batches.
  *
  * @param omp The mbuf pool to free the chain of mbufs into
  * @param om  The starting mbuf of the chain to free back into the pool
@@ -562,7 +738,9 @@ struct os_mbuf *os_mbuf_prepend_pullup(struct os_mbuf *om, uint16_t len);
  * Copies the contents of a flat buffer into an mbuf chain, starting at the
  * specified destination offset.  If the mbuf is too small for the source data,
  * it is extended as necessary.  If the destination mbuf contains a packet
- * header, the header length is updated.
+ * header, the header length is updated.  Mbufs whose data is shared with a
+ * clone (see os_mbuf_clone()) get a private copy of their data before it is
+ * overwritten.
  *
  * @param omp                   The mbuf pool to allocate from.
  * @param om                    The mbuf chain to copy into.
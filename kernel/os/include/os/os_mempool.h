@@ -45,6 +45,26 @@ struct os_memblock {
     SLIST_ENTRY(os_memblock) mb_next;
 };
 
+/** @cond INTERNAL_HIDDEN */
+/*
+ * Lock-free free list flavor, if OS_MEMPOOL_LOCKFREE is enabled and the
+ * architecture supports one:
+ * - LLSC: ARMv7-M load/store exclusive on the list head.  The exclusive
+ *   monitor is cleared on exception entry and return, so a store-exclusive
+ *   fails whenever an interrupt or context switch happened in between,
+ *   which rules out ABA.
+ * - TAGGED: the head is paired with a generation count and both are swapped
+ *   with one 64-bit compare-and-swap (simulator).
+ */
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define OS_MEMPOOL_LOCKFREE_LLSC        (1)
+#elif MYNEWT_VAL(BSP_SIMULATED)
+#define OS_MEMPOOL_LOCKFREE_TAGGED      (1)
+#endif
+#endif
+/** @endcond */
+
 /* XXX: Change this structure so that we keep the first address in the pool? */
 /* XXX: add memory debug structure and associated code */
 /* XXX: Change how I coded the SLIST_HEAD here. It should be named:
@@ -67,7 +87,18 @@ struct os_mempool {
     /** Address of memory buffer used by pool */
     uint32_t mp_membuf_addr;
     STAILQ_ENTRY(os_mempool) mp_list;
+#ifdef OS_MEMPOOL_LOCKFREE_TAGGED
+    /** Free list head and its generation count, swapped as one word */
+    union {
+        struct {
+            SLIST_HEAD(,os_memblock);
+            uint32_t mp_free_gen;
+        };
+        uint64_t mp_free_word;
+    } __attribute__((aligned(8)));
+#else
     SLIST_HEAD(,os_memblock);
+#endif
     /** Name for memory block */
     char *name;
 };
@@ -141,6 +172,63 @@ struct os_mempool_info {
 struct os_mempool *os_mempool_info_get_next(struct os_mempool *,
         struct os_mempool_info *);
 
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+/**
+ * Allocation record kept behind every memory block when OS_MEMPOOL_TRACK is
+ * enabled.
+ */
+struct os_memblock_track {
+    /** Address the block was allocated from; 0 while the block is free */
+    uintptr_t mbt_site;
+    /** OS time at which the block was allocated */
+    os_time_t mbt_time;
+};
+
+/** @cond INTERNAL_HIDDEN */
+#define OS_MEMPOOL_TRACK_SZ     (sizeof(struct os_memblock_track))
+/** @endcond */
+
+/**
+ * Live blocks of a memory pool allocated from the same address.
+ */
+struct os_mempool_site {
+    /** Address the blocks were allocated from */
+    uintptr_t oms_site;
+    /** Number of blocks */
+    uint16_t oms_count;
+    /** Allocation time of the oldest block */
+    os_time_t oms_oldest;
+};
+
+/**
+ * Groups the allocated blocks of a memory pool by allocation site.  Sites
+ * beyond the first max ones found are not reported.
+ *
+ * @param mp                    The mempool to inspect.
+ * @param sites                 Array receiving one entry per site.
+ * @param max                   Number of entries in the array.
+ *
+ * @return                      The number of entries filled in.
+ */
+int os_mempool_track_sites(const struct os_mempool *mp,
+                           struct os_mempool_site *sites, int max);
+
+/**
+ * Attributes an allocated block to another allocation site.  Allocators
+ * built on top of memory pools call this with their own caller, so that
+ * blocks are not all reported as allocated by the allocator.
+ *
+ * @param mp                    The mempool the block belongs to.
+ * @param block                 The block.
+ * @param site                  The new allocation site.
+ */
+void os_memblock_track_site(const struct os_mempool *mp, void *block,
+                            const void *site);
+#else
+#define OS_MEMPOOL_TRACK_SZ     (0)
+#define os_memblock_track_site(mp, block, site)
+#endif
+
 /*
  * To calculate size of the memory buffer needed for the pool. NOTE: This size
  * is NOT in bytes! The size is the number of os_membuf_t elements required for
@@ -150,9 +238,10 @@ struct os_mempool *os_mempool_info_get_next(struct os_mempool *,
 /*
  * Leave extra 4 bytes of guard area at the end.
  */
-#define OS_MEMPOOL_BLOCK_SZ(sz) ((sz) + sizeof(os_membuf_t))
+#define OS_MEMPOOL_BLOCK_SZ(sz) \
+    ((sz) + sizeof(os_membuf_t) + OS_MEMPOOL_TRACK_SZ)
 #else
-#define OS_MEMPOOL_BLOCK_SZ(sz) (sz)
+#define OS_MEMPOOL_BLOCK_SZ(sz) ((sz) + OS_MEMPOOL_TRACK_SZ)
 #endif
 #if (OS_CFG_ALIGNMENT == OS_CFG_ALIGN_4)
 #define OS_MEMPOOL_SIZE(n, blksize)                                     \
@@ -272,6 +361,35 @@ os_error_t os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr);
  */
 os_error_t os_memblock_put(struct os_mempool *mp, void *block_addr);
 
+/**
+ * Gets several memory blocks from a memory pool at once.  Either all the
+ * requested blocks are allocated or none is.  The free list is only locked
+ * once for the whole batch.
+ *
+ * @param mp Pointer to the memory pool
+ * @param blocks Array which receives the block pointers
+ * @param cnt Number of blocks to get
+ *
+ * @return OS_OK on success;
+ *         OS_ENOMEM if fewer than cnt blocks are free;
+ *         OS_INVALID_PARM on bad arguments
+ */
+os_error_t os_memblock_get_n(struct os_mempool *mp, void **blocks, int cnt);
+
+/**
+ * Puts several memory blocks back into a pool at once.  Same as calling
+ * os_memblock_put() for each block, but the free list is only locked once
+ * for the whole batch.  Extended pools with a put callback still get one
+ * callback per block.
+ *
+ * @param mp Pointer to the memory pool
+ * @param blocks Array of the blocks to free
+ * @param cnt Number of blocks in the array
+ *
+ * @return os_error_t
+ */
+os_error_t os_memblock_put_n(struct os_mempool *mp, void **blocks, int cnt);
+
 #ifdef __cplusplus
 }
 #endif
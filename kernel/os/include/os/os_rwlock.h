@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSRwlock Reader-writer locks
+ *   @{
+ */
+
+#ifndef _OS_RWLOCK_H_
+#define _OS_RWLOCK_H_
+
+#include "os/os.h"
+#include "os/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @cond INTERNAL_HIDDEN */
+/* rw_state: number of readers holding the lock, plus these flags */
+#define OS_RWLOCK_READERS_MASK  (0x0000ffffU)
+#define OS_RWLOCK_WRITER        (0x00010000U)
+#define OS_RWLOCK_WAITERS       (0x00020000U)
+
+struct os_rwlock_reader {
+    struct os_task *rr_task;
+    /** Priority of the reader when it took the lock */
+    uint8_t rr_prio;
+};
+/** @endcond */
+
+/**
+ * OS reader-writer lock.
+ *
+ * Any number of readers or a single writer hold the lock.  Once a writer
+ * waits, new readers queue behind it, so writers are never starved.  Waiting
+ * tasks lend their priority to the writer holding the lock and to up to
+ * OS_RWLOCK_MAX_READERS readers, the same way os_mutex does for its owner.
+ *
+ * While nobody waits, taking and releasing the lock is a compare-and-swap on
+ * rw_state (ARMv7-M and the simulator) instead of a critical section.
+ *
+ * The lock is not recursive; neither readers nor the writer may take it
+ * again while holding it.
+ */
+struct os_rwlock {
+    SLIST_HEAD(, os_task) rw_head;
+    /** Reader count and writer / waiters flags */
+    uint32_t rw_state;
+    /** Task holding the write lock */
+    struct os_task *rw_writer;
+    /** Priority of the writer when it took the lock */
+    uint8_t rw_writer_prio;
+    /** Number of writers in rw_head */
+    uint8_t rw_wr_waiting;
+    /** Number of readers holding the lock that do not fit in rw_readers */
+    uint16_t rw_rd_untracked;
+    struct os_rwlock_reader rw_readers[MYNEWT_VAL(OS_RWLOCK_MAX_READERS)];
+
+    /** Number of times a reader found the lock taken */
+    uint32_t rw_rd_blocked;
+    /** Number of times a writer found the lock taken */
+    uint32_t rw_wr_blocked;
+    /** Number of waits that timed out */
+    uint32_t rw_timeouts;
+};
+
+/**
+ * Initialize a reader-writer lock.
+ *
+ * @param rw Pointer to the rwlock
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     rwlock passed in was NULL.
+ *      OS_OK               no error.
+ */
+os_error_t os_rwlock_init(struct os_rwlock *rw);
+
+/**
+ * Take the lock for reading.
+ *
+ * @param rw Pointer to the rwlock
+ * @param timeout Timeout, in os ticks.
+ *                A timeout of 0 means do not wait if not available.
+ *                A timeout of OS_TIMEOUT_NEVER means wait forever.
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     rwlock passed in was NULL.
+ *      OS_NOT_STARTED      OS is not started.
+ *      OS_TIMEOUT          A writer held or was waiting for the lock.
+ *      OS_OK               no error.
+ */
+os_error_t os_rwlock_read_pend(struct os_rwlock *rw, os_time_t timeout);
+
+/**
+ * Release a read lock.
+ *
+ * @param rw Pointer to the rwlock
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     rwlock passed in was NULL.
+ *      OS_NOT_STARTED      OS is not started.
+ *      OS_BAD_MUTEX        The lock was not held for reading by this
+ *                          task.  Beyond OS_RWLOCK_MAX_READERS readers,
+ *                          readers are only counted, so a non-owner is
+ *                          caught only while all readers are tracked.
+ *      OS_OK               no error.
+ */
+os_error_t os_rwlock_read_release(struct os_rwlock *rw);
+
+/**
+ * Take the lock for writing.
+ *
+ * @param rw Pointer to the rwlock
+ * @param timeout Timeout, in os ticks.
+ *                A timeout of 0 means do not wait if not available.
+ *                A timeout of OS_TIMEOUT_NEVER means wait forever.
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     rwlock passed in was NULL.
+ *      OS_NOT_STARTED      OS is not started.
+ *      OS_TIMEOUT          The lock was held by readers or another writer.
+ *      OS_OK               no error.
+ */
+os_error_t os_rwlock_write_pend(struct os_rwlock *rw, os_time_t timeout);
+
+/**
+ * Release a write lock.
+ *
+ * @param rw Pointer to the rwlock
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     rwlock passed in was NULL.
+ *      OS_NOT_STARTED      OS is not started.
+ *      OS_BAD_MUTEX        The lock was not write-locked by this task.
+ *      OS_OK               no error.
+ */
+os_error_t os_rwlock_write_release(struct os_rwlock *rw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _OS_RWLOCK_H_ */
+
+/**
+ *   @} OSRwlock
+ * @} OSKernel
+ */
@@ -75,11 +75,42 @@ typedef enum os_task_state {
 #define OS_TASK_FLAG_MUTEX_WAIT     (0x04U)
 /** Task waiting on a event queue */
 #define OS_TASK_FLAG_EVQ_WAIT       (0x08U)
+/** Task waiting to read-lock an rwlock */
+#define OS_TASK_FLAG_RWLOCK_RD_WAIT (0x10U)
+/** Task waiting to write-lock an rwlock */
+#define OS_TASK_FLAG_RWLOCK_WR_WAIT (0x20U)
 
 typedef void (*os_task_func_t)(void *);
 
 #define OS_TASK_MAX_NAME_LEN (32)
 
+#if MYNEWT_VAL(OS_TASK_PROF)
+/**
+ * High resolution task profile, maintained by the scheduler at every
+ * context switch.  All times are in os_cputime ticks.
+ */
+struct os_task_prof {
+    /** Total time the task has been running */
+    uint64_t tp_run_time;
+    /** Longest time the task ran without being switched out */
+    uint32_t tp_slice_max;
+    /** Longest time the task was ready before it got the CPU */
+    uint32_t tp_lat_max;
+    /** os_cputime when the task last became ready to run */
+    uint32_t tp_ready_at;
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+    /** Longest time interrupts were disabled while the task was running */
+    uint32_t tp_crit_max;
+#endif
+    /**
+     * Ready-to-run latency histogram.  Bucket 0 counts latencies below
+     * 2^OS_TASK_PROF_HIST_SHIFT ticks, each following bucket doubles the
+     * upper bound and the last one counts everything longer.
+     */
+    uint32_t tp_lat_hist[MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS)];
+};
+#endif
+
 /**
  * Structure containing information about a running task
  */
@@ -99,7 +130,12 @@ struct os_task {
     /** Task flags, bitmask */
     uint8_t t_flags;
     uint8_t t_lockcnt;
-    uint8_t t_pad;
+    /** Priority level the task is queued at in the run list */
+    uint8_t t_run_prio;
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+    /** Deepest stack usage seen by the idle task, in os_stack_t units */
+    uint16_t t_stack_hwm;
+#endif
 
     /** Task name */
     const char *t_name;
@@ -108,7 +144,10 @@ struct os_task {
     /** Argument to pass to task function when called */
     void *t_arg;
 
-    /** Current object task is waiting on, either a semaphore or mutex */
+    /**
+     * Current object task is waiting on, either a semaphore, mutex, event
+     * queue or rwlock
+     */
     void *t_obj;
 
     /** Default sanity check for this task */
@@ -116,6 +155,10 @@ struct os_task {
 
     /** Next scheduled wakeup if this task is sleeping */
     os_time_t t_next_wakeup;
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+    /** Number of ticks the wakeup may be late */
+    os_time_t t_slack;
+#endif
     /** Total task run time */
     os_time_t t_run_time;
     /**
@@ -127,6 +170,20 @@ struct os_task {
     STAILQ_ENTRY(os_task) t_os_task_list;
     TAILQ_ENTRY(os_task) t_os_list;
     SLIST_ENTRY(os_task) t_obj_list;
+
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    /** Sleep heap linkage: first child, next sibling and previous
+     *  sibling (or parent, for a first child).
+     */
+    struct os_task *t_sleep_child;
+    struct os_task *t_sleep_next;
+    struct os_task *t_sleep_prev;
+#endif
+
+#if MYNEWT_VAL(OS_TASK_PROF)
+    /** Context switch profile of this task */
+    struct os_task_prof t_prof;
+#endif
 };
 
 /** @cond INTERNAL_HIDDEN */
@@ -187,6 +244,10 @@ struct os_task_info {
     uint16_t oti_stkusage;
     /** Task stack size */
     uint16_t oti_stksize;
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+    /** Task stack high-water mark, maintained by the idle task */
+    uint16_t oti_stkhwm;
+#endif
     /** Task context switch count */
     uint32_t oti_cswcnt;
     /** Task runtime */
@@ -232,6 +293,21 @@ struct os_task_info {
 struct os_task *os_task_info_get_next(const struct os_task *,
         struct os_task_info *);
 
+#if MYNEWT_VAL(OS_TASK_PROF)
+/**
+ * Take a consistent snapshot of a task's context switch profile.
+ *
+ * @param t  The task to read the profile of
+ * @param tp The profile structure to fill out
+ */
+void os_task_prof_get(const struct os_task *t, struct os_task_prof *tp);
+
+/**
+ * Clear the context switch profile of every task.
+ */
+void os_task_prof_reset(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -108,6 +108,17 @@ void os_time_advance(int ticks);
  */
 void os_time_delay(os_time_t osticks);
 
+/**
+ * Puts the current task to sleep for at least the specified number of os
+ * ticks, and at most 'slack' ticks more.  Allowing some slack lets the
+ * wakeup be merged with other timers that expire around the same time.
+ * Behaves like os_time_delay() unless OS_TIMER_SLACK is enabled.
+ *
+ * @param osticks Number of ticks to delay (0 means no delay).
+ * @param slack Number of ticks the wakeup may be late.
+ */
+void os_time_delay_slack(os_time_t osticks, os_time_t slack);
+
 #define OS_TIME_TICK_LT(__t1, __t2) ((os_stime_t) ((__t1) - (__t2)) < 0)
 #define OS_TIME_TICK_GT(__t1, __t2) ((os_stime_t) ((__t1) - (__t2)) > 0)
 #define OS_TIME_TICK_GEQ(__t1, __t2) ((os_stime_t) ((__t1) - (__t2)) >= 0)
@@ -130,6 +130,11 @@ os_arch_save_sr(void)
 
     isr_ctx = __get_PRIMASK();
     __disable_irq();
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+    if (!(isr_ctx & 1)) {
+        os_crit_trace_enter(__builtin_return_address(0));
+    }
+#endif
     return (isr_ctx & 1);
 }
 
@@ -137,6 +142,9 @@ void
 os_arch_restore_sr(os_sr_t isr_ctx)
 {
     if (!isr_ctx) {
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+        os_crit_trace_exit();
+#endif
         __enable_irq();
     }
 }
@@ -66,12 +66,27 @@ os_arch_ctx_sw(struct os_task *next_t)
 os_sr_t
 os_arch_save_sr(void)
 {
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+    os_sr_t osr;
+
+    osr = sim_save_sr();
+    if (!osr) {
+        os_crit_trace_enter(__builtin_return_address(0));
+    }
+    return osr;
+#else
     return sim_save_sr();
+#endif
 }
 
 void
 os_arch_restore_sr(os_sr_t osr)
 {
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+    if (!osr) {
+        os_crit_trace_exit();
+    }
+#endif
     sim_restore_sr(osr);
 }
 
@@ -116,6 +116,10 @@ os_idle_task(void *arg)
             sanity_last = now;
         }
 
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+        os_task_stack_scan();
+#endif
+
         OS_ENTER_CRITICAL(sr);
         now = os_time_get();
         sticks = os_sched_wakeup_ticks(now);
@@ -137,6 +141,9 @@ os_idle_task(void *arg)
          * for 'n' ticks.
          */
 
+#if MYNEWT_VAL(OS_SCHED_STATS)
+        os_sched_stats_idle(now);
+#endif
         os_trace_idle();
         os_tick_idle(iticks);
         OS_EXIT_CRITICAL(sr);
@@ -217,7 +224,13 @@ os_init(int (*main_fn)(int argc, char **arg))
 #endif
 
     TAILQ_INIT(&g_callout_list);
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    os_callout_wheel_init();
+#endif
     STAILQ_INIT(&g_os_task_list);
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    os_malloc_slab_init();
+#endif
     os_eventq_init(os_eventq_dflt_get());
 
     /* Initialize device list. */
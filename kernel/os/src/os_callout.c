@@ -28,6 +28,277 @@
 
 struct os_callout_list g_callout_list;
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+/*
+ * Hashed timing wheel.
+ *
+ * Armed callouts are kept, unsorted, in the wheel slot selected by the low
+ * bits of their expiry time, so arming and disarming a callout is constant
+ * time.  os_callout_tick() only visits the slots for the ticks which have
+ * elapsed since it last ran and moves every due callout to g_callout_list,
+ * which in this mode holds expired callouts waiting to be posted.
+ *
+ * Every callout still in the wheel expires after os_callout_wheel_last,
+ * every callout on g_callout_list expires at or before it; that is how
+ * os_callout_stop() finds the list a callout is linked on.
+ */
+#define OS_CALLOUT_WHEEL_SLOTS  MYNEWT_VAL(OS_CALLOUT_WHEEL_SLOTS)
+#define OS_CALLOUT_WHEEL_MASK   (OS_CALLOUT_WHEEL_SLOTS - 1)
+
+#if OS_CALLOUT_WHEEL_SLOTS & OS_CALLOUT_WHEEL_MASK
+#error "OS_CALLOUT_WHEEL_SLOTS must be a power of two"
+#endif
+
+static struct os_callout_list os_callout_wheel[OS_CALLOUT_WHEEL_SLOTS];
+/* Last tick processed by os_callout_tick() */
+static os_time_t os_callout_wheel_last;
+/* Number of callouts in the wheel */
+static int os_callout_wheel_cnt;
+/* Cached earliest expiry in the wheel, valid if os_callout_wheel_next_ok */
+static os_time_t os_callout_wheel_next;
+static int os_callout_wheel_next_ok;
+
+void
+os_callout_wheel_init(void)
+{
+    int i;
+
+    for (i = 0; i < OS_CALLOUT_WHEEL_SLOTS; i++) {
+        TAILQ_INIT(&os_callout_wheel[i]);
+    }
+    os_callout_wheel_last = os_time_get();
+    os_callout_wheel_cnt = 0;
+    os_callout_wheel_next_ok = 0;
+}
+
+static struct os_callout_list *
+os_callout_head(struct os_callout *c)
+{
+    if (OS_TIME_TICK_GT(c->c_ticks, os_callout_wheel_last)) {
+        return &os_callout_wheel[c->c_ticks & OS_CALLOUT_WHEEL_MASK];
+    } else {
+        return &g_callout_list;
+    }
+}
+
+static void
+os_callout_link(struct os_callout *c)
+{
+    TAILQ_INSERT_TAIL(os_callout_head(c), c, c_next);
+
+    if (os_callout_wheel_cnt == 0) {
+        os_callout_wheel_next = c->c_ticks;
+        os_callout_wheel_next_ok = 1;
+    } else if (os_callout_wheel_next_ok &&
+               OS_TIME_TICK_LT(c->c_ticks, os_callout_wheel_next)) {
+        os_callout_wheel_next = c->c_ticks;
+    }
+    os_callout_wheel_cnt++;
+}
+
+static void
+os_callout_unlink(struct os_callout *c)
+{
+    struct os_callout_list *head;
+
+    head = os_callout_head(c);
+    TAILQ_REMOVE(head, c, c_next);
+    c->c_next.tqe_prev = NULL;
+
+    if (head != &g_callout_list) {
+        os_callout_wheel_cnt--;
+        if (c->c_ticks == os_callout_wheel_next) {
+            os_callout_wheel_next_ok = 0;
+        }
+    }
+}
+
+/*
+ * Moves all callouts which expire in (os_callout_wheel_last, now] from the
+ * wheel to g_callout_list.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static void
+os_callout_wheel_expire(os_time_t now)
+{
+    struct os_callout_list *slot;
+    struct os_callout *c;
+    struct os_callout *next;
+    os_time_t tick;
+    os_time_t n;
+
+    n = now - os_callout_wheel_last;
+    if ((os_stime_t)n <= 0) {
+        return;
+    }
+    if (n > OS_CALLOUT_WHEEL_SLOTS) {
+        /* Fell behind by more than one revolution; visit every slot once */
+        n = OS_CALLOUT_WHEEL_SLOTS;
+    }
+
+    tick = os_callout_wheel_last;
+    while (n-- > 0) {
+        tick++;
+        slot = &os_callout_wheel[tick & OS_CALLOUT_WHEEL_MASK];
+        c = TAILQ_FIRST(slot);
+        while (c != NULL) {
+            next = TAILQ_NEXT(c, c_next);
+            if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
+                TAILQ_REMOVE(slot, c, c_next);
+                TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
+                os_callout_wheel_cnt--;
+                os_callout_wheel_next_ok = 0;
+            }
+            c = next;
+        }
+    }
+    os_callout_wheel_last = now;
+}
+
+/*
+ * Returns the earliest expiry time of the callouts in the wheel.  The wheel
+ * must not be empty.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static os_time_t
+os_callout_wheel_first(void)
+{
+    struct os_callout *c;
+    os_time_t tick;
+    os_time_t first;
+    int found;
+    int i;
+
+    if (os_callout_wheel_next_ok) {
+        return os_callout_wheel_next;
+    }
+
+    /* Look for a callout due within one revolution, in tick order */
+    tick = os_callout_wheel_last;
+    for (i = 0; i < OS_CALLOUT_WHEEL_SLOTS; i++) {
+        tick++;
+        TAILQ_FOREACH(c, &os_callout_wheel[tick & OS_CALLOUT_WHEEL_MASK],
+                      c_next) {
+            if (c->c_ticks == tick) {
+                goto done;
+            }
+        }
+    }
+
+    /* Everything is further away; take the minimum over all of them */
+    found = 0;
+    first = 0;
+    for (i = 0; i < OS_CALLOUT_WHEEL_SLOTS; i++) {
+        TAILQ_FOREACH(c, &os_callout_wheel[i], c_next) {
+            if (!found || OS_TIME_TICK_LT(c->c_ticks, first)) {
+                first = c->c_ticks;
+                found = 1;
+            }
+        }
+    }
+    assert(found);
+    tick = first;
+
+done:
+    os_callout_wheel_next = tick;
+    os_callout_wheel_next_ok = 1;
+    return tick;
+}
+
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+/*
+ * Returns the earliest deadline (expiry plus slack) of the callouts which
+ * expire before it, starting from the earliest expiry in the wheel.  Only
+ * one revolution is searched; the result is capped accordingly, which can
+ * only make the wakeup early.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static os_time_t
+os_callout_wheel_deadline(os_time_t first)
+{
+    struct os_callout *c;
+    os_time_t deadline;
+    os_time_t tick;
+    int i;
+
+    deadline = first + OS_CALLOUT_WHEEL_SLOTS - 1;
+    tick = first;
+    for (i = 0; i < OS_CALLOUT_WHEEL_SLOTS; i++) {
+        if (OS_TIME_TICK_GT(tick, deadline)) {
+            break;
+        }
+        TAILQ_FOREACH(c, &os_callout_wheel[tick & OS_CALLOUT_WHEEL_MASK],
+                      c_next) {
+            if (c->c_ticks == tick &&
+                OS_TIME_TICK_LT(c->c_ticks + c->c_slack, deadline)) {
+                deadline = c->c_ticks + c->c_slack;
+            }
+        }
+        tick++;
+    }
+
+    return deadline;
+}
+#endif
+
+#else
+
+static void
+os_callout_link(struct os_callout *c)
+{
+    struct os_callout *entry;
+
+    entry = NULL;
+    TAILQ_FOREACH(entry, &g_callout_list, c_next) {
+        if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
+            break;
+        }
+    }
+
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, c, c_next);
+    } else {
+        TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
+    }
+}
+
+static void
+os_callout_unlink(struct os_callout *c)
+{
+    TAILQ_REMOVE(&g_callout_list, c, c_next);
+    c->c_next.tqe_prev = NULL;
+}
+
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+/*
+ * Returns the earliest deadline (expiry plus slack) of the callouts which
+ * expire before it.  Sleeping until then delays no callout past its
+ * deadline, and every callout due by then is expired by the same wakeup.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static os_time_t
+os_callout_list_deadline(struct os_callout *c)
+{
+    os_time_t deadline;
+
+    deadline = c->c_ticks + c->c_slack;
+    while ((c = TAILQ_NEXT(c, c_next)) != NULL &&
+           OS_TIME_TICK_LT(c->c_ticks, deadline)) {
+        if (OS_TIME_TICK_LT(c->c_ticks + c->c_slack, deadline)) {
+            deadline = c->c_ticks + c->c_slack;
+        }
+    }
+
+    return deadline;
+}
+#endif
+
+#endif
+
 void os_callout_init(struct os_callout *c, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
 {
@@ -41,6 +312,14 @@ void os_callout_init(struct os_callout *c, struct os_eventq *evq,
     os_trace_api_ret(OS_TRACE_ID_CALLOUT_INIT);
 }
 
+void
+os_callout_set_slack(struct os_callout *c, os_time_t slack)
+{
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+    c->c_slack = slack;
+#endif
+}
+
 void
 os_callout_stop(struct os_callout *c)
 {
@@ -51,8 +330,7 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
-        TAILQ_REMOVE(&g_callout_list, c, c_next);
-        c->c_next.tqe_prev = NULL;
+        os_callout_unlink(c);
     }
 
     if (c->c_evq) {
@@ -67,7 +345,6 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, os_time_t ticks)
 {
-    struct os_callout *entry;
     os_sr_t sr;
     int ret;
 
@@ -90,19 +367,7 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     }
 
     c->c_ticks = os_time_get() + ticks;
-
-    entry = NULL;
-    TAILQ_FOREACH(entry, &g_callout_list, c_next) {
-        if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
-            break;
-        }
-    }
-
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, c, c_next);
-    } else {
-        TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
-    }
+    os_callout_link(c);
 
     OS_EXIT_CRITICAL(sr);
 
@@ -131,13 +396,18 @@ os_callout_tick(void)
 
     now = os_time_get();
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    OS_ENTER_CRITICAL(sr);
+    os_callout_wheel_expire(now);
+    OS_EXIT_CRITICAL(sr);
+#endif
+
     while (1) {
         OS_ENTER_CRITICAL(sr);
         c = TAILQ_FIRST(&g_callout_list);
         if (c) {
             if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
-                TAILQ_REMOVE(&g_callout_list, c, c_next);
-                c->c_next.tqe_prev = NULL;
+                os_callout_unlink(c);
             } else {
                 c = NULL;
             }
@@ -160,7 +430,9 @@ os_callout_tick(void)
 
 /*
  * Returns the number of ticks to the first pending callout. If there are no
- * pending callouts then return OS_TIMEOUT_NEVER instead.
+ * pending callouts then return OS_TIMEOUT_NEVER instead.  With OS_TIMER_SLACK
+ * this is the latest wakeup which does not make any callout miss its
+ * deadline.
  *
  * @param now The time now
  *
@@ -170,20 +442,47 @@ os_time_t
 os_callout_wakeup_ticks(os_time_t now)
 {
     os_time_t rt;
+    os_time_t first;
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
     struct os_callout *c;
+#endif
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    if (!TAILQ_EMPTY(&g_callout_list)) {
+        /* Expired callouts still waiting to be posted */
+        return 0;
+    }
+    if (os_callout_wheel_cnt == 0) {
+        return OS_TIMEOUT_NEVER;
+    }
+    first = os_callout_wheel_first();
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+    first = os_callout_wheel_deadline(first);
+#endif
+    if (OS_TIME_TICK_GEQ(first, now)) {
+        rt = first - now;
+    } else {
+        rt = 0;     /* callout time is in the past */
+    }
+#else
     c = TAILQ_FIRST(&g_callout_list);
     if (c != NULL) {
-        if (OS_TIME_TICK_GEQ(c->c_ticks, now)) {
-            rt = c->c_ticks - now;
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+        first = os_callout_list_deadline(c);
+#else
+        first = c->c_ticks;
+#endif
+        if (OS_TIME_TICK_GEQ(first, now)) {
+            rt = first - now;
         } else {
             rt = 0;     /* callout time is in the past */
         }
     } else {
         rt = OS_TIMEOUT_NEVER;
     }
+#endif
 
     return (rt);
 }
@@ -48,10 +48,19 @@ void
 os_cputime_delay_ticks(uint32_t ticks)
 {
     uint32_t until;
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    os_sr_t sr;
+#endif
 
     until = os_cputime_get32() + ticks;
     while ((int32_t)(os_cputime_get32() - until) < 0) {
         /* Loop here till finished */
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+        /* Nothing else moves virtual time forward while we spin. */
+        OS_ENTER_CRITICAL(sr);
+        os_time_advance(1);
+        OS_EXIT_CRITICAL(sr);
+#endif
     }
 }
 
@@ -0,0 +1,198 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "os/mynewt.h"
+#include "os_priv.h"
+
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+#include "stats/stats.h"
+
+#define OS_CRIT_TRACE_TOP_N     MYNEWT_VAL(OS_CRIT_TRACE_TOP_N)
+
+STATS_SECT_START(os_crit_stats)
+    STATS_SECT_ENTRY(max)
+    STATS_SECT_ENTRY(sections)
+STATS_SECT_END
+
+STATS_SECT_DECL(os_crit_stats) g_os_crit_stats;
+
+STATS_NAME_START(os_crit_stats)
+    STATS_NAME(os_crit_stats, max)
+    STATS_NAME(os_crit_stats, sections)
+STATS_NAME_END(os_crit_stats)
+
+/*
+ * Longest critical sections seen, at most one entry per caller.  Unused
+ * entries have a zero duration.
+ */
+static struct os_crit_info os_crit_trace_tbl[OS_CRIT_TRACE_TOP_N];
+
+/* Shortest duration in the table; shorter sections are not looked at */
+static uint32_t os_crit_trace_floor;
+static uint32_t os_crit_trace_max;
+
+/* The section being timed */
+static uint32_t os_crit_trace_start;
+static uintptr_t os_crit_trace_ra;
+static uint8_t os_crit_trace_timing;
+
+/* Set once os_cputime can be read */
+static uint8_t os_crit_trace_on;
+
+static void
+os_crit_trace_insert(uintptr_t ra, uint32_t ticks)
+{
+    struct os_crit_info *oci;
+    int i;
+
+    oci = NULL;
+    for (i = 0; i < OS_CRIT_TRACE_TOP_N; i++) {
+        if (os_crit_trace_tbl[i].oci_ra == ra) {
+            oci = &os_crit_trace_tbl[i];
+            break;
+        }
+    }
+    if (oci == NULL) {
+        /* Replace the shortest entry */
+        oci = &os_crit_trace_tbl[0];
+        for (i = 1; i < OS_CRIT_TRACE_TOP_N; i++) {
+            if (os_crit_trace_tbl[i].oci_ticks < oci->oci_ticks) {
+                oci = &os_crit_trace_tbl[i];
+            }
+        }
+        oci->oci_ra = ra;
+        oci->oci_ticks = ticks;
+    } else if (ticks > oci->oci_ticks) {
+        oci->oci_ticks = ticks;
+    }
+
+    os_crit_trace_floor = os_crit_trace_tbl[0].oci_ticks;
+    for (i = 1; i < OS_CRIT_TRACE_TOP_N; i++) {
+        if (os_crit_trace_tbl[i].oci_ticks < os_crit_trace_floor) {
+            os_crit_trace_floor = os_crit_trace_tbl[i].oci_ticks;
+        }
+    }
+}
+
+void
+os_crit_trace_enter(void *ra)
+{
+    if (!os_crit_trace_on) {
+        return;
+    }
+
+    os_crit_trace_ra = (uintptr_t)ra;
+    os_crit_trace_start = os_cputime_get32();
+    os_crit_trace_timing = 1;
+}
+
+void
+os_crit_trace_exit(void)
+{
+    uint32_t ticks;
+
+    if (!os_crit_trace_timing) {
+        return;
+    }
+    os_crit_trace_timing = 0;
+
+    ticks = os_cputime_get32() - os_crit_trace_start;
+
+    STATS_INC(g_os_crit_stats, sections);
+    if (ticks > os_crit_trace_max) {
+        os_crit_trace_max = ticks;
+        STATS_SET(g_os_crit_stats, max, ticks);
+    }
+
+#if MYNEWT_VAL(OS_TASK_PROF)
+    if (g_current_task != NULL &&
+        ticks > g_current_task->t_prof.tp_crit_max) {
+        g_current_task->t_prof.tp_crit_max = ticks;
+    }
+#endif
+
+    if (ticks > os_crit_trace_floor) {
+        os_crit_trace_insert(os_crit_trace_ra, ticks);
+    }
+}
+
+int
+os_crit_trace_get(struct os_crit_info *info, int max)
+{
+    struct os_crit_info tmp;
+    os_sr_t sr;
+    int cnt;
+    int i;
+    int j;
+
+    cnt = 0;
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < OS_CRIT_TRACE_TOP_N; i++) {
+        if (os_crit_trace_tbl[i].oci_ticks == 0) {
+            continue;
+        }
+        tmp = os_crit_trace_tbl[i];
+
+        /* Insertion sort, longest first */
+        for (j = cnt; j > 0 && info[j - 1].oci_ticks < tmp.oci_ticks; j--) {
+            if (j < max) {
+                info[j] = info[j - 1];
+            }
+        }
+        if (j < max) {
+            info[j] = tmp;
+            if (cnt < max) {
+                cnt++;
+            }
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return cnt;
+}
+
+void
+os_crit_trace_reset(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(os_crit_trace_tbl, 0, sizeof(os_crit_trace_tbl));
+    os_crit_trace_floor = 0;
+    os_crit_trace_max = 0;
+    STATS_CLEAR(g_os_crit_stats, max);
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+os_crit_trace_init(void)
+{
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(g_os_crit_stats),
+                            STATS_SIZE_INIT_PARMS(g_os_crit_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(os_crit_stats),
+                            "os_crit");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    os_crit_trace_on = 1;
+}
+#endif
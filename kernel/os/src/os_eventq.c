@@ -27,6 +27,19 @@
 
 static struct os_eventq os_eventq_main;
 
+/*
+ * Values of os_event.ev_queued.  Any non-zero value means the event is
+ * pending; only OS_EVENT_S_LISTED events are linked on an event queue.
+ */
+#define OS_EVENT_S_IDLE         0
+/* Linked on an event queue */
+#define OS_EVENT_S_LISTED       1
+/* Taken off the queue by os_eventq_run_batch(), waiting to be dispatched */
+#define OS_EVENT_S_BATCHED      2
+
+/* Events os_eventq_run_batch() takes off the queue at a time */
+#define OS_EVENTQ_BATCH_CHUNK   8
+
 void
 os_eventq_init(struct os_eventq *evq)
 {
@@ -40,6 +53,124 @@ os_eventq_inited(const struct os_eventq *evq)
     return evq->evq_list.stqh_last != NULL;
 }
 
+#if MYNEWT_VAL(OS_EVENTQ_RING)
+int
+os_eventq_ring_init(struct os_eventq *evq, struct os_eventq_ring *ring,
+                    struct os_event **events, uint16_t size)
+{
+    if (size == 0 || size > 0x8000 || (size & (size - 1)) != 0) {
+        return OS_EINVAL;
+    }
+
+    ring->er_events = events;
+    ring->er_size = size;
+    ring->er_head = 0;
+    ring->er_tail = 0;
+    evq->evq_ring = ring;
+
+    return OS_OK;
+}
+
+int
+os_eventq_ring_put(struct os_eventq *evq, struct os_event *ev)
+{
+    struct os_eventq_ring *ring;
+    struct os_task *t;
+    uint16_t head;
+    int resched;
+    os_sr_t sr;
+
+    os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_PUT, (uint32_t)evq, (uint32_t)ev);
+
+    ring = evq->evq_ring;
+    head = ring->er_head;
+    if ((uint16_t)(head - ring->er_tail) == ring->er_size) {
+        os_trace_api_ret(OS_TRACE_ID_EVENTQ_PUT);
+        return OS_ENOMEM;
+    }
+
+    ring->er_events[head & (ring->er_size - 1)] = ev;
+
+    /* The slot must be written before the consumer can see the new head */
+    __sync_synchronize();
+    ring->er_head = head + 1;
+    __sync_synchronize();
+
+    /* Only involve the scheduler if the consumer is waiting for an event.
+     * The consumer checks the ring with interrupts disabled before it goes
+     * to sleep, so an event pushed before evq_task is set is never missed.
+     */
+    if (evq->evq_task == NULL) {
+        os_trace_api_ret(OS_TRACE_ID_EVENTQ_PUT);
+        return OS_OK;
+    }
+
+    resched = 0;
+    OS_ENTER_CRITICAL(sr);
+    t = evq->evq_task;
+    if (t != NULL) {
+        if (t->t_state == OS_TASK_SLEEP) {
+            os_sched_wakeup(t);
+            resched = 1;
+        }
+        evq->evq_task = NULL;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (resched) {
+        os_sched(NULL);
+    }
+
+    os_trace_api_ret(OS_TRACE_ID_EVENTQ_PUT);
+    return OS_OK;
+}
+
+static struct os_event *
+os_eventq_ring_pull(struct os_eventq_ring *ring)
+{
+    struct os_event *ev;
+    uint16_t tail;
+
+    tail = ring->er_tail;
+    if (tail == ring->er_head) {
+        return NULL;
+    }
+
+    /* Read the slot only after observing the producer's head */
+    __sync_synchronize();
+    ev = ring->er_events[tail & (ring->er_size - 1)];
+
+    /* Done with the slot; hand it back to the producer */
+    __sync_synchronize();
+    ring->er_tail = tail + 1;
+
+    return ev;
+}
+#endif
+
+/*
+ * Removes the first pending event from an event queue.  Events on the queue
+ * itself are returned before events on its ring, if any.
+ */
+static struct os_event *
+os_eventq_pull(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    ev = STAILQ_FIRST(&evq->evq_list);
+    if (ev) {
+        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
+        ev->ev_queued = OS_EVENT_S_IDLE;
+    }
+#if MYNEWT_VAL(OS_EVENTQ_RING)
+    else if (evq->evq_ring != NULL) {
+        ev = os_eventq_ring_pull(evq->evq_ring);
+    }
+#endif
+
+    return ev;
+}
+
 void
 os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 {
@@ -52,13 +183,18 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 
     /* Do not queue if already queued */
     if (OS_EVENT_QUEUED(ev)) {
+        if ((ev->ev_flags & OS_EVENT_F_COALESCE) &&
+            ev->ev_coalesced != UINT16_MAX) {
+            ev->ev_coalesced++;
+        }
         OS_EXIT_CRITICAL(sr);
         os_trace_api_ret(OS_TRACE_ID_EVENTQ_PUT);
         return;
     }
 
     /* Queue the event */
-    ev->ev_queued = 1;
+    ev->ev_queued = OS_EVENT_S_LISTED;
+    ev->ev_coalesced = 0;
     STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
 
     resched = 0;
@@ -93,28 +229,33 @@ os_eventq_get_no_wait(struct os_eventq *evq)
 
     os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)evq);
 
-    ev = STAILQ_FIRST(&evq->evq_list);
-    if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
-    }
+    ev = os_eventq_pull(evq);
 
     os_trace_api_ret_u32(OS_TRACE_ID_EVENTQ_GET_NO_WAIT, (uint32_t)ev);
 
     return ev;
 }
 
-struct os_event *
-os_eventq_get(struct os_eventq *evq)
+/*
+ * Takes up to 'max' events off the queue in one critical section.  If 'wait'
+ * is set and the queue is empty, blocks until an event arrives.  Like
+ * os_eventq_pull(), empties the list before touching the ring, so events
+ * taken off the list come first in 'evs'; they are left in state 'state'.
+ *
+ * @return The total number of events taken; *listed gets the number taken
+ *         off the list.
+ */
+static int
+os_eventq_take(struct os_eventq *evq, struct os_event **evs, int max,
+               uint8_t state, int wait, int *listed)
 {
     struct os_event *ev;
-    os_sr_t sr;
     struct os_task *t;
-
-    os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET, (uint32_t)evq);
+    os_sr_t sr;
+    int cnt;
 
     t = os_sched_get_current_task();
-    if (evq->evq_owner != t) {
+    if (wait && evq->evq_owner != t) {
         if (evq->evq_owner == NULL) {
             evq->evq_owner = t;
         } else {
@@ -125,27 +266,58 @@ os_eventq_get(struct os_eventq *evq)
             assert(0);
         }
     }
+
+    *listed = 0;
+    cnt = 0;
+
     OS_ENTER_CRITICAL(sr);
-pull_one:
-    ev = STAILQ_FIRST(&evq->evq_list);
-    if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
-        t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
-    } else {
-        evq->evq_task = t;
-        os_sched_sleep(evq->evq_task, OS_TIMEOUT_NEVER);
-        t->t_flags |= OS_TASK_FLAG_EVQ_WAIT;
-        OS_EXIT_CRITICAL(sr);
+    while (cnt < max) {
+        ev = STAILQ_FIRST(&evq->evq_list);
+        if (ev != NULL) {
+            STAILQ_REMOVE_HEAD(&evq->evq_list, ev_next);
+            ev->ev_queued = state;
+            (*listed)++;
+        }
+#if MYNEWT_VAL(OS_EVENTQ_RING)
+        else if (evq->evq_ring != NULL) {
+            ev = os_eventq_ring_pull(evq->evq_ring);
+        }
+#endif
+        if (ev == NULL) {
+            if (cnt > 0 || !wait) {
+                break;
+            }
+            evq->evq_task = t;
+            os_sched_sleep(evq->evq_task, OS_TIMEOUT_NEVER);
+            t->t_flags |= OS_TASK_FLAG_EVQ_WAIT;
+            OS_EXIT_CRITICAL(sr);
 
-        os_sched(NULL);
+            os_sched(NULL);
 
-        OS_ENTER_CRITICAL(sr);
-        evq->evq_task = NULL;
-        goto pull_one;
+            OS_ENTER_CRITICAL(sr);
+            evq->evq_task = NULL;
+            continue;
+        }
+        if (cnt == 0) {
+            t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
+        }
+        evs[cnt++] = ev;
     }
     OS_EXIT_CRITICAL(sr);
 
+    return cnt;
+}
+
+struct os_event *
+os_eventq_get(struct os_eventq *evq)
+{
+    struct os_event *ev;
+    int listed;
+
+    os_trace_api_u32(OS_TRACE_ID_EVENTQ_GET, (uint32_t)evq);
+
+    os_eventq_take(evq, &ev, 1, OS_EVENT_S_IDLE, 1, &listed);
+
     os_trace_api_ret_u32(OS_TRACE_ID_EVENTQ_GET, (uint32_t)ev);
 
     return (ev);
@@ -162,6 +334,58 @@ os_eventq_run(struct os_eventq *evq)
     ev->ev_cb(ev);
 }
 
+int
+os_eventq_run_batch(struct os_eventq *evq, int max)
+{
+    struct os_event *evs[OS_EVENTQ_BATCH_CHUNK];
+    struct os_event *ev;
+    os_sr_t sr;
+    int listed;
+    int wait;
+    int todo;
+    int cnt;
+    int n;
+    int i;
+
+    assert(max > 0);
+
+    /*
+     * Events are taken off the queue a chunk at a time, in one critical
+     * section, and only the local array refers to them afterwards.  Until
+     * its turn comes, a listed event stays marked batched: posting it again
+     * is a no-op, as for any pending event.  A callback that removes or
+     * reinitializes it clears the mark, and it is skipped; if it was posted
+     * again after that, it is back on the list and runs from there.
+     */
+    cnt = 0;
+    wait = 1;
+    while (cnt < max) {
+        todo = min(max - cnt, OS_EVENTQ_BATCH_CHUNK);
+        n = os_eventq_take(evq, evs, todo, OS_EVENT_S_BATCHED, wait, &listed);
+        if (n == 0) {
+            break;
+        }
+        wait = 0;
+        for (i = 0; i < n; i++) {
+            ev = evs[i];
+            if (i < listed) {
+                OS_ENTER_CRITICAL(sr);
+                if (ev->ev_queued != OS_EVENT_S_BATCHED) {
+                    OS_EXIT_CRITICAL(sr);
+                    continue;
+                }
+                ev->ev_queued = OS_EVENT_S_IDLE;
+                OS_EXIT_CRITICAL(sr);
+            }
+            assert(ev->ev_cb != NULL);
+            ev->ev_cb(ev);
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
 static struct os_event *
 os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 {
@@ -176,10 +400,8 @@ os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 
     OS_ENTER_CRITICAL(sr);
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
+        ev = os_eventq_pull(evq[i]);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
             break;
         }
     }
@@ -214,10 +436,8 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
     cur_t = os_sched_get_current_task();
 
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
+        ev = os_eventq_pull(evq[i]);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
             /* Reset the items that already have an evq task set. */
             for (j = 0; j < i; j++) {
                 evq[j]->evq_task = NULL;
@@ -245,11 +465,7 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
          * we haven't found one.
          */
         if (!ev) {
-            ev = STAILQ_FIRST(&evq[i]->evq_list);
-            if (ev) {
-                STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-                ev->ev_queued = 0;
-            }
+            ev = os_eventq_pull(evq[i]);
         }
         evq[i]->evq_task = NULL;
     }
@@ -269,10 +485,11 @@ os_eventq_remove(struct os_eventq *evq, struct os_event *ev)
     os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_REMOVE, (uint32_t)evq, (uint32_t)ev);
 
     OS_ENTER_CRITICAL(sr);
-    if (OS_EVENT_QUEUED(ev)) {
+    if (ev->ev_queued == OS_EVENT_S_LISTED) {
         STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
     }
-    ev->ev_queued = 0;
+    /* A batched event is only referred to by its batch, which skips it */
+    ev->ev_queued = OS_EVENT_S_IDLE;
     OS_EXIT_CRITICAL(sr);
 
     os_trace_api_ret(OS_TRACE_ID_EVENTQ_REMOVE);
@@ -18,12 +18,138 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 #if MYNEWT_VAL(OS_SCHEDULING)
 static struct os_mutex os_malloc_mutex;
 #endif
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+/*
+ * Slab front end.
+ *
+ * Small requests are rounded up to a power of two and served from a memory
+ * pool dedicated to that size, which takes neither the malloc mutex nor a
+ * walk of the heap's free list.  When a class is exhausted the next larger
+ * one is tried; requests too large for any class, or made when all suitable
+ * classes are exhausted, go to the heap.  A class with a block count of zero
+ * is skipped.
+ */
+#define OS_MALLOC_SLAB_DATA(sz)                                         \
+    static os_membuf_t os_malloc_slab_##sz##_data[                      \
+        OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_##sz##_COUNT), sz)]
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_16_COUNT) > 0
+OS_MALLOC_SLAB_DATA(16);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_32_COUNT) > 0
+OS_MALLOC_SLAB_DATA(32);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_64_COUNT) > 0
+OS_MALLOC_SLAB_DATA(64);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_128_COUNT) > 0
+OS_MALLOC_SLAB_DATA(128);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_256_COUNT) > 0
+OS_MALLOC_SLAB_DATA(256);
+#endif
+
+struct os_malloc_slab {
+    struct os_mempool oms_pool;
+    os_membuf_t *oms_data;
+    uint16_t oms_size;
+    uint16_t oms_count;
+    char *oms_name;
+};
+
+#define OS_MALLOC_SLAB_ENTRY(sz)                                        \
+    {                                                                   \
+        .oms_data = os_malloc_slab_##sz##_data,                         \
+        .oms_size = sz,                                                 \
+        .oms_count = MYNEWT_VAL(OS_MALLOC_SLAB_##sz##_COUNT),           \
+        .oms_name = "malloc_" #sz,                                      \
+    }
+
+/* Smallest class first */
+static struct os_malloc_slab os_malloc_slabs[] = {
+#if MYNEWT_VAL(OS_MALLOC_SLAB_16_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(16),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_32_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(32),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_64_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(64),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_128_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(128),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_256_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(256),
+#endif
+};
+
+#define OS_MALLOC_SLAB_CNT                                              \
+    (sizeof(os_malloc_slabs) / sizeof(os_malloc_slabs[0]))
+
+void
+os_malloc_slab_init(void)
+{
+    struct os_malloc_slab *oms;
+    int rc;
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        oms = &os_malloc_slabs[i];
+
+        /* os_init() may run more than once (e.g. in unit tests). */
+        os_mempool_unregister(&oms->oms_pool);
+        rc = os_mempool_init(&oms->oms_pool, oms->oms_count, oms->oms_size,
+                             oms->oms_data, oms->oms_name);
+        assert(rc == 0);
+    }
+}
+
+static void *
+os_malloc_slab_get(size_t size)
+{
+    void *ptr;
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (size <= os_malloc_slabs[i].oms_size) {
+            ptr = os_memblock_get(&os_malloc_slabs[i].oms_pool);
+            if (ptr != NULL) {
+                return ptr;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns the slab class 'ptr' was allocated from, or NULL if it came from
+ * the heap.
+ */
+static struct os_malloc_slab *
+os_malloc_slab_find(const void *ptr)
+{
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (os_memblock_from(&os_malloc_slabs[i].oms_pool, ptr)) {
+            return &os_malloc_slabs[i];
+        }
+    }
+
+    return NULL;
+}
+#endif
+
 static void
 os_malloc_lock(void)
 {
@@ -55,6 +181,13 @@ os_malloc(size_t size)
 {
     void *ptr;
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    ptr = os_malloc_slab_get(size);
+    if (ptr != NULL) {
+        return ptr;
+    }
+#endif
+
     os_malloc_lock();
     ptr = malloc(size);
     os_malloc_unlock();
@@ -65,6 +198,16 @@ os_malloc(size_t size)
 void
 os_free(void *mem)
 {
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_malloc_slab *oms;
+
+    oms = os_malloc_slab_find(mem);
+    if (oms != NULL) {
+        os_memblock_put(&oms->oms_pool, mem);
+        return;
+    }
+#endif
+
     os_malloc_lock();
     free(mem);
     os_malloc_unlock();
@@ -74,6 +217,27 @@ void *
 os_realloc(void *ptr, size_t size)
 {
     void *new_ptr;
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_malloc_slab *oms;
+
+    oms = os_malloc_slab_find(ptr);
+    if (oms != NULL) {
+        if (size == 0) {
+            os_memblock_put(&oms->oms_pool, ptr);
+            return NULL;
+        }
+        if (size <= oms->oms_size) {
+            return ptr;
+        }
+
+        new_ptr = os_malloc(size);
+        if (new_ptr != NULL) {
+            memcpy(new_ptr, ptr, oms->oms_size);
+            os_memblock_put(&oms->oms_pool, ptr);
+        }
+        return new_ptr;
+    }
+#endif
 
     os_malloc_lock();
     new_ptr = realloc(ptr, size);
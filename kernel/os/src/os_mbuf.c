@@ -41,6 +41,11 @@
 #define OS_TRACE_DISABLE_FILE_API
 #endif
 #include "os/mynewt.h"
+#include "os_priv.h"
+
+#if MYNEWT_VAL(MSYS_STATS)
+#include "stats/stats.h"
+#endif
 
 /**
  * @addtogroup OSKernel
@@ -52,6 +57,102 @@
 STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
     STAILQ_HEAD_INITIALIZER(g_msys_pool_list);
 
+/* Maximum number of blocks moved to or from a mempool in one call */
+#define OS_MBUF_BATCH   (8)
+
+#if MYNEWT_VAL(MSYS_STATS)
+STATS_SECT_START(os_msys_stats)
+    STATS_SECT_ENTRY(hit)
+    STATS_SECT_ENTRY(miss)
+    STATS_SECT_ENTRY(fallback)
+    STATS_SECT_ENTRY(failed)
+STATS_SECT_END
+
+STATS_NAME_START(os_msys_stats)
+    STATS_NAME(os_msys_stats, hit)
+    STATS_NAME(os_msys_stats, miss)
+    STATS_NAME(os_msys_stats, fallback)
+    STATS_NAME(os_msys_stats, failed)
+STATS_NAME_END(os_msys_stats)
+
+/*
+ * Statistics of the msys pools, one entry per pool.  Entries are never
+ * reused, so a pool which is registered again after os_msys_reset() keeps
+ * its statistics section.
+ */
+static struct {
+    const struct os_mbuf_pool *pool;
+    STATS_SECT_DECL(os_msys_stats) stats;
+} os_msys_stats[MYNEWT_VAL(MSYS_STATS_MAX_POOLS)];
+static int os_msys_stats_cnt;
+
+/* Set once the stats package can take registrations */
+static uint8_t os_msys_stats_ready;
+
+#define OS_MSYS_STATS_INC(pool, name) do {                      \
+    struct stats_os_msys_stats *_stats;                         \
+                                                                \
+    _stats = os_msys_stats_find(pool);                          \
+    if (_stats != NULL) {                                       \
+        STATS_INC(*_stats, name);                               \
+    }                                                           \
+} while (0)
+
+static struct stats_os_msys_stats *
+os_msys_stats_find(const struct os_mbuf_pool *pool)
+{
+    int i;
+
+    for (i = 0; i < os_msys_stats_cnt; i++) {
+        if (os_msys_stats[i].pool == pool) {
+            return &os_msys_stats[i].stats;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+os_msys_stats_register(const struct os_mbuf_pool *pool)
+{
+    const char *name;
+    int rc;
+
+    if (!os_msys_stats_ready || os_msys_stats_find(pool) != NULL ||
+        os_msys_stats_cnt >= MYNEWT_VAL(MSYS_STATS_MAX_POOLS)) {
+        return;
+    }
+
+    name = pool->omp_pool->name;
+    if (name == NULL) {
+        return;
+    }
+
+    rc = stats_init_and_reg(
+        STATS_HDR(os_msys_stats[os_msys_stats_cnt].stats),
+        STATS_SIZE_INIT_PARMS(os_msys_stats[os_msys_stats_cnt].stats,
+                              STATS_SIZE_32),
+        STATS_NAME_INIT_PARMS(os_msys_stats), name);
+    if (rc == 0) {
+        os_msys_stats[os_msys_stats_cnt].pool = pool;
+        os_msys_stats_cnt++;
+    }
+}
+
+void
+os_msys_stats_init(void)
+{
+    struct os_mbuf_pool *pool;
+
+    os_msys_stats_ready = 1;
+    STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
+        os_msys_stats_register(pool);
+    }
+}
+#else
+#define OS_MSYS_STATS_INC(pool, name)
+#endif
+
 
 int
 os_mqueue_init(struct os_mqueue *mq, os_event_fn *ev_cb, void *arg)
@@ -138,6 +239,10 @@ os_msys_register(struct os_mbuf_pool *new_pool)
         STAILQ_INSERT_TAIL(&g_msys_pool_list, new_pool, omp_next);
     }
 
+#if MYNEWT_VAL(MSYS_STATS)
+    os_msys_stats_register(new_pool);
+#endif
+
     return (0);
 }
 
@@ -166,41 +271,131 @@ _os_msys_find_pool(uint16_t dsize)
     return (pool);
 }
 
+#if MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
+/**
+ * Returns the largest registered pool which is smaller than the specified
+ * one, or NULL if there is none.
+ */
+static struct os_mbuf_pool *
+_os_msys_prev_pool(const struct os_mbuf_pool *pool)
+{
+    struct os_mbuf_pool *prev;
+    struct os_mbuf_pool *cur;
 
-struct os_mbuf *
-os_msys_get(uint16_t dsize, uint16_t leadingspace)
+    prev = NULL;
+    STAILQ_FOREACH(cur, &g_msys_pool_list, omp_next) {
+        if (cur == pool) {
+            break;
+        }
+        prev = cur;
+    }
+
+    return prev;
+}
+#endif
+
+static struct os_mbuf *
+_os_msys_pool_get(struct os_mbuf_pool *pool, int pkthdr, uint16_t hdr_len)
+{
+    if (pkthdr) {
+        return os_mbuf_get_pkthdr(pool, hdr_len);
+    } else {
+        return os_mbuf_get(pool, hdr_len);
+    }
+}
+
+/**
+ * Allocates an mbuf from the msys pool which fits 'dsize' bytes best.  If
+ * that pool is empty, the other pools are tried according to the configured
+ * fallback policy.  'min_len' is the number of bytes the first buffer must
+ * be able to hold: the packet header or the requested leading space.
+ */
+static struct os_mbuf *
+_os_msys_get(uint16_t dsize, int pkthdr, uint16_t hdr_len, uint16_t min_len)
 {
+    struct os_mbuf_pool *best;
     struct os_mbuf *m;
+#if MYNEWT_VAL(MSYS_FALLBACK_LARGER) || MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
     struct os_mbuf_pool *pool;
+#endif
 
-    pool = _os_msys_find_pool(dsize);
-    if (!pool) {
-        goto err;
+    best = _os_msys_find_pool(dsize);
+    if (!best) {
+        return (NULL);
     }
 
-    m = os_mbuf_get(pool, leadingspace);
-    return (m);
-err:
+    m = _os_msys_pool_get(best, pkthdr, hdr_len);
+    if (m) {
+        OS_MSYS_STATS_INC(best, hit);
+        return (m);
+    }
+    OS_MSYS_STATS_INC(best, miss);
+
+#if MYNEWT_VAL(MSYS_FALLBACK_LARGER)
+    for (pool = STAILQ_NEXT(best, omp_next);
+         pool != NULL;
+         pool = STAILQ_NEXT(pool, omp_next)) {
+
+        m = _os_msys_pool_get(pool, pkthdr, hdr_len);
+        if (m) {
+            OS_MSYS_STATS_INC(pool, fallback);
+            return (m);
+        }
+        OS_MSYS_STATS_INC(pool, miss);
+    }
+#endif
+
+#if MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
+    for (pool = _os_msys_prev_pool(best);
+         pool != NULL && pool->omp_databuf_len > min_len;
+         pool = _os_msys_prev_pool(pool)) {
+
+        m = _os_msys_pool_get(pool, pkthdr, hdr_len);
+        if (m) {
+            OS_MSYS_STATS_INC(pool, fallback);
+            return (m);
+        }
+        OS_MSYS_STATS_INC(pool, miss);
+    }
+#else
+    (void)min_len;
+#endif
+
+    OS_MSYS_STATS_INC(best, failed);
     return (NULL);
 }
 
+/*
+ * Attributes an mbuf to the caller of the public allocation function, for
+ * OS_MEMPOOL_TRACK.
+ */
+static inline struct os_mbuf *
+_os_mbuf_track(struct os_mbuf *om, const void *site)
+{
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+    if (om != NULL) {
+        os_memblock_track_site(om->om_omp->omp_pool, om, site);
+    }
+#endif
+    return om;
+}
+
+struct os_mbuf *
+os_msys_get(uint16_t dsize, uint16_t leadingspace)
+{
+    return _os_mbuf_track(_os_msys_get(dsize, 0, leadingspace, leadingspace),
+                          __builtin_return_address(0));
+}
+
 struct os_mbuf *
 os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
 {
     uint16_t total_pkthdr_len;
-    struct os_mbuf *m;
-    struct os_mbuf_pool *pool;
 
     total_pkthdr_len =  user_hdr_len + sizeof(struct os_mbuf_pkthdr);
-    pool = _os_msys_find_pool(dsize + total_pkthdr_len);
-    if (!pool) {
-        goto err;
-    }
-
-    m = os_mbuf_get_pkthdr(pool, user_hdr_len);
-    return (m);
-err:
-    return (NULL);
+    return _os_mbuf_track(_os_msys_get(dsize + total_pkthdr_len, 1,
+                                       user_hdr_len, total_pkthdr_len),
+                          __builtin_return_address(0));
 }
 
 int
@@ -242,6 +437,22 @@ os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
     return (0);
 }
 
+static inline void
+_os_mbuf_init(struct os_mbuf_pool *omp, struct os_mbuf *om,
+              uint16_t leadingspace)
+{
+    SLIST_NEXT(om, om_next) = NULL;
+    om->om_flags = 0;
+    om->om_pkthdr_len = 0;
+    om->om_len = 0;
+    om->om_data = (&om->om_databuf[0] + leadingspace);
+    om->om_omp = omp;
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    om->om_shared = NULL;
+    om->om_refcnt = 1;
+#endif
+}
+
 struct os_mbuf *
 os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
 {
@@ -260,18 +471,73 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
         goto done;
     }
 
-    SLIST_NEXT(om, om_next) = NULL;
-    om->om_flags = 0;
-    om->om_pkthdr_len = 0;
-    om->om_len = 0;
-    om->om_data = (&om->om_databuf[0] + leadingspace);
-    om->om_omp = omp;
+    _os_mbuf_init(omp, om, leadingspace);
+    _os_mbuf_track(om, __builtin_return_address(0));
 
 done:
     os_trace_api_ret_u32(OS_TRACE_ID_MBUF_GET, (uint32_t)om);
     return om;
 }
 
+/**
+ * Allocates a chain of cnt empty mbufs from the specified pool, taking the
+ * blocks from the mempool in batches.  Either the whole chain is allocated
+ * or nothing is.
+ */
+static struct os_mbuf *
+_os_mbuf_get_n(struct os_mbuf_pool *omp, int cnt)
+{
+    void *blocks[OS_MBUF_BATCH];
+    struct os_mbuf *head;
+    struct os_mbuf *last;
+    struct os_mbuf *om;
+    int batch;
+    int rc;
+    int i;
+
+    head = NULL;
+    last = NULL;
+    while (cnt > 0) {
+        batch = min(cnt, OS_MBUF_BATCH);
+        rc = os_memblock_get_n(omp->omp_pool, blocks, batch);
+        if (rc != 0) {
+            os_mbuf_free_chain(head);
+            return NULL;
+        }
+
+        for (i = 0; i < batch; i++) {
+            om = blocks[i];
+            _os_mbuf_init(omp, om, 0);
+            if (last != NULL) {
+                SLIST_NEXT(last, om_next) = om;
+            } else {
+                head = om;
+            }
+            last = om;
+        }
+        cnt -= batch;
+    }
+
+    return head;
+}
+
+struct os_mbuf *
+os_mbuf_get_chain(struct os_mbuf_pool *omp, int total_len)
+{
+    int cnt;
+
+    if (total_len < 0) {
+        return NULL;
+    }
+
+    cnt = (total_len + omp->omp_databuf_len - 1) / omp->omp_databuf_len;
+    if (cnt == 0) {
+        cnt = 1;
+    }
+
+    return _os_mbuf_get_n(omp, cnt);
+}
+
 struct os_mbuf *
 os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
 {
@@ -291,6 +557,7 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
 
     om = os_mbuf_get(omp, 0);
     if (om) {
+        _os_mbuf_track(om, __builtin_return_address(0));
         om->om_pkthdr_len = pkthdr_len;
         om->om_data += pkthdr_len;
 
@@ -305,14 +572,147 @@ done:
     return om;
 }
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+/**
+ * Drops one reference to the block of the specified mbuf.
+ *
+ * @return 1 if that was the last reference; 0 otherwise.
+ */
+static int
+_os_mbuf_unref(struct os_mbuf *om)
+{
+    os_sr_t sr;
+    int last;
+
+    OS_ENTER_CRITICAL(sr);
+    assert(om->om_refcnt > 0);
+    om->om_refcnt--;
+    last = om->om_refcnt == 0;
+    OS_EXIT_CRITICAL(sr);
+
+    return last;
+}
+
+/**
+ * Stops an mbuf from using the data buffer of another mbuf, returning that
+ * mbuf's block to its pool if this was the last reference to it.
+ */
+static int
+_os_mbuf_detach(struct os_mbuf *om)
+{
+    struct os_mbuf *owner;
+
+    owner = om->om_shared;
+    om->om_shared = NULL;
+
+    if (_os_mbuf_unref(owner)) {
+        return os_memblock_put(owner->om_omp->omp_pool, owner);
+    }
+
+    return 0;
+}
+
+/**
+ * Releases the references an mbuf holds when it is freed.
+ *
+ * @param om                    The mbuf being freed.
+ * @param out_last              On success, set to 1 if the mbuf's own block
+ *                                  is no longer referenced and can be
+ *                                  returned to its pool.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+_os_mbuf_release(struct os_mbuf *om, int *out_last)
+{
+    int rc;
+
+    /* Nobody else can take a reference to an unshared mbuf. */
+    if (!_os_mbuf_is_shared(om)) {
+        *out_last = 1;
+        return 0;
+    }
+
+    if (om->om_shared != NULL) {
+        rc = _os_mbuf_detach(om);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    *out_last = _os_mbuf_unref(om);
+    return 0;
+}
+
+/**
+ * Gives an mbuf a private copy of its data if its data buffer is shared, so
+ * that the data can be modified in place.  The data moves to the mbuf's own
+ * buffer if nothing else uses it, otherwise to a newly allocated block from
+ * the pool the data came from.
+ */
+static int
+_os_mbuf_unshare(struct os_mbuf *om)
+{
+    struct os_mbuf *owner;
+    struct os_mbuf *priv;
+    uint8_t *dst;
+    int rc;
+
+    owner = om->om_shared;
+    if (owner == NULL) {
+        if (om->om_refcnt == 1) {
+            return 0;
+        }
+    } else if (owner->om_refcnt == 1) {
+        return 0;
+    }
+
+    if (owner != NULL && om->om_refcnt == 1 &&
+        om->om_len <= om->om_omp->omp_databuf_len - om->om_pkthdr_len) {
+        priv = NULL;
+        dst = om->om_databuf + om->om_pkthdr_len;
+    } else {
+        priv = os_mbuf_get(owner != NULL ? owner->om_omp : om->om_omp, 0);
+        if (priv == NULL) {
+            return OS_ENOMEM;
+        }
+        dst = priv->om_databuf;
+    }
+
+    memcpy(dst, om->om_data, om->om_len);
+    om->om_data = dst;
+
+    /* The mbuf keeps the reference to its own block even when moving the
+     * data out of it, as the block still holds the mbuf itself.
+     */
+    if (owner != NULL) {
+        rc = _os_mbuf_detach(om);
+    } else {
+        rc = 0;
+    }
+    om->om_shared = priv;
+
+    return rc;
+}
+#endif
+
 int
 os_mbuf_free(struct os_mbuf *om)
 {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    int last;
+#endif
     int rc;
 
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)om);
 
     if (om->om_omp != NULL) {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+        rc = _os_mbuf_release(om, &last);
+        if (rc != 0 || !last) {
+            goto done;
+        }
+#endif
         rc = os_memblock_put(om->om_omp->omp_pool, om);
         if (rc != 0) {
             goto done;
@@ -329,22 +729,60 @@ done:
 int
 os_mbuf_free_chain(struct os_mbuf *om)
 {
+    void *blocks[OS_MBUF_BATCH];
+    struct os_mbuf_pool *omp;
     struct os_mbuf *next;
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    int last;
+#endif
+    int cnt;
     int rc;
 
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE_CHAIN, (uint32_t)om);
 
+    /* Return consecutive mbufs from the same pool in batches. */
+    omp = NULL;
+    cnt = 0;
     while (om != NULL) {
         next = SLIST_NEXT(om, om_next);
 
-        rc = os_mbuf_free(om);
-        if (rc != 0) {
-            goto done;
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+        if (om->om_omp != NULL) {
+            rc = _os_mbuf_release(om, &last);
+            if (rc != 0) {
+                goto done;
+            }
+            if (!last) {
+                /* The block is still in use by a clone. */
+                om = next;
+                continue;
+            }
+        }
+#endif
+
+        if (om->om_omp != NULL) {
+            if (cnt == OS_MBUF_BATCH || (cnt > 0 && om->om_omp != omp)) {
+                rc = os_memblock_put_n(omp->omp_pool, blocks, cnt);
+                if (rc != 0) {
+                    goto done;
+                }
+                cnt = 0;
+            }
+
+            omp = om->om_omp;
+            blocks[cnt++] = om;
         }
 
         om = next;
     }
 
+    if (cnt > 0) {
+        rc = os_memblock_put_n(omp->omp_pool, blocks, cnt);
+        if (rc != 0) {
+            goto done;
+        }
+    }
+
     rc = 0;
 
 done:
@@ -425,8 +863,23 @@ os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
         remainder -= space;
     }
 
-    /* Take the remaining data, and keep allocating new mbufs and copying
-     * data into it, until data is exhausted.
+    /* Allocate all the mbufs needed for the rest of the data at once. */
+    if (remainder > 0) {
+        new = os_mbuf_get_chain(omp, remainder);
+        SLIST_NEXT(last, om_next) = new;
+        while (new != NULL) {
+            new->om_len = min(omp->omp_databuf_len, remainder);
+            memcpy(OS_MBUF_DATA(new, void *), data, new->om_len);
+            data += new->om_len;
+            remainder -= new->om_len;
+            last = new;
+            new = SLIST_NEXT(new, om_next);
+        }
+    }
+
+    /* If the pool could not provide them all, keep allocating new mbufs one
+     * at a time and copying data into them, until data or mbufs are
+     * exhausted.
      */
     while (remainder > 0) {
         new = os_mbuf_get(omp, 0);
@@ -493,37 +946,40 @@ os_mbuf_dup(struct os_mbuf *om)
     struct os_mbuf_pool *omp;
     struct os_mbuf *head;
     struct os_mbuf *copy;
+    struct os_mbuf *cur;
+    uint16_t leadingspace;
+    int cnt;
 
     omp = om->om_omp;
 
-    head = NULL;
-    copy = NULL;
+    cnt = 0;
+    for (cur = om; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        cnt++;
+    }
 
-    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
-        if (head) {
-            SLIST_NEXT(copy, om_next) = os_mbuf_get(omp,
-                    OS_MBUF_LEADINGSPACE(om));
-            if (!SLIST_NEXT(copy, om_next)) {
-                os_mbuf_free_chain(head);
-                goto err;
-            }
+    /* Allocate the whole copy at once, then fill it in. */
+    head = _os_mbuf_get_n(omp, cnt);
+    if (!head) {
+        goto err;
+    }
 
-            copy = SLIST_NEXT(copy, om_next);
+    copy = head;
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        if (copy == head && OS_MBUF_IS_PKTHDR(om)) {
+            _os_mbuf_copypkthdr(copy, om);
         } else {
-            head = os_mbuf_get(omp, OS_MBUF_LEADINGSPACE(om));
-            if (!head) {
+            leadingspace = OS_MBUF_LEADINGSPACE(om);
+            if (leadingspace > omp->omp_databuf_len) {
+                os_mbuf_free_chain(head);
                 goto err;
             }
-
-            if (OS_MBUF_IS_PKTHDR(om)) {
-                _os_mbuf_copypkthdr(head, om);
-            }
-            copy = head;
+            copy->om_data = &copy->om_databuf[0] + leadingspace;
         }
         copy->om_flags = om->om_flags;
         copy->om_len = om->om_len;
         memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
                 om->om_len);
+        copy = SLIST_NEXT(copy, om_next);
     }
 
     return (head);
@@ -531,6 +987,54 @@ err:
     return (NULL);
 }
 
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+struct os_mbuf *
+os_mbuf_clone(struct os_mbuf *om)
+{
+    struct os_mbuf *owner;
+    struct os_mbuf *head;
+    struct os_mbuf *copy;
+    struct os_mbuf *cur;
+    os_sr_t sr;
+    int cnt;
+
+    cnt = 0;
+    for (cur = om; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        cnt++;
+    }
+
+    head = _os_mbuf_get_n(om->om_omp, cnt);
+    if (head == NULL) {
+        return NULL;
+    }
+
+    copy = head;
+    for (cur = om; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        if (copy == head && OS_MBUF_IS_PKTHDR(cur)) {
+            _os_mbuf_copypkthdr(copy, cur);
+        }
+
+        /* Always refer to the mbuf holding the data, never to another
+         * clone.
+         */
+        owner = cur->om_shared != NULL ? cur->om_shared : cur;
+
+        OS_ENTER_CRITICAL(sr);
+        assert(owner->om_refcnt < UINT16_MAX);
+        owner->om_refcnt++;
+        OS_EXIT_CRITICAL(sr);
+
+        copy->om_shared = owner;
+        copy->om_data = cur->om_data;
+        copy->om_len = cur->om_len;
+        copy->om_flags = cur->om_flags;
+        copy = SLIST_NEXT(copy, om_next);
+    }
+
+    return head;
+}
+#endif
+
 struct os_mbuf *
 os_mbuf_off(const struct os_mbuf *om, int off, uint16_t *out_off)
 {
@@ -593,6 +1097,156 @@ os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst)
     return (len > 0 ? -1 : 0);
 }
 
+/**
+ * Moves an iterator that sits at the end of an mbuf to the start of the next
+ * non-empty one.  The iterator only ever rests at the end of an mbuf if it
+ * is the last one in the chain.
+ */
+static void
+os_mbuf_iter_norm(struct os_mbuf_iter *it)
+{
+    const struct os_mbuf *next;
+
+    while (it->omi_off == it->omi_om->om_len) {
+        next = SLIST_NEXT(it->omi_om, om_next);
+        if (next == NULL) {
+            break;
+        }
+
+        it->omi_om = next;
+        it->omi_off = 0;
+    }
+}
+
+int
+os_mbuf_iter_init(struct os_mbuf_iter *it, const struct os_mbuf *om, int off)
+{
+    it->omi_om = om;
+    it->omi_off = 0;
+
+    if (om == NULL || off < 0) {
+        return -1;
+    }
+
+    return os_mbuf_iter_advance(it, off);
+}
+
+int
+os_mbuf_iter_seg(const struct os_mbuf_iter *it, const uint8_t **out_data)
+{
+    if (it->omi_om == NULL) {
+        return 0;
+    }
+
+    *out_data = it->omi_om->om_data + it->omi_off;
+    return it->omi_om->om_len - it->omi_off;
+}
+
+const void *
+os_mbuf_iter_peek(const struct os_mbuf_iter *it, void *buf, int len)
+{
+    const struct os_mbuf *om;
+    uint8_t *dst;
+    int count;
+    int off;
+
+    om = it->omi_om;
+    if (om == NULL) {
+        return NULL;
+    }
+
+    off = it->omi_off;
+    if (len <= om->om_len - off) {
+        return om->om_data + off;
+    }
+
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    /* The requested bytes straddle a boundary; gather them. */
+    dst = buf;
+    while (len > 0) {
+        if (om == NULL) {
+            return NULL;
+        }
+
+        count = min(om->om_len - off, len);
+        memcpy(dst, om->om_data + off, count);
+        dst += count;
+        len -= count;
+        off = 0;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    return buf;
+}
+
+int
+os_mbuf_iter_advance(struct os_mbuf_iter *it, int len)
+{
+    const struct os_mbuf *next;
+    int avail;
+
+    if (it->omi_om == NULL) {
+        return len > 0 ? -1 : 0;
+    }
+
+    while (1) {
+        avail = it->omi_om->om_len - it->omi_off;
+        if (len <= avail) {
+            it->omi_off += len;
+            break;
+        }
+
+        next = SLIST_NEXT(it->omi_om, om_next);
+        if (next == NULL) {
+            it->omi_off = it->omi_om->om_len;
+            return -1;
+        }
+
+        len -= avail;
+        it->omi_om = next;
+        it->omi_off = 0;
+    }
+
+    os_mbuf_iter_norm(it);
+
+    return 0;
+}
+
+int
+os_mbuf_to_iovec(const struct os_mbuf *om, int off, int len,
+                 struct os_iovec *iov, int iov_cnt)
+{
+    struct os_mbuf_iter it;
+    const uint8_t *data;
+    int count;
+    int i;
+
+    if (os_mbuf_iter_init(&it, om, off) != 0) {
+        return -1;
+    }
+
+    i = 0;
+    while (len > 0) {
+        count = os_mbuf_iter_seg(&it, &data);
+        if (count == 0 || i >= iov_cnt) {
+            return -1;
+        }
+
+        count = min(count, len);
+        iov[i].iov_base = (void *)data;
+        iov[i].iov_len = count;
+        i++;
+
+        len -= count;
+        os_mbuf_iter_advance(&it, count);
+    }
+
+    return i;
+}
+
 void
 os_mbuf_adj(struct os_mbuf *mp, int req_len)
 {
@@ -853,6 +1507,12 @@ os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len)
     while (1) {
         copylen = min(cur->om_len - cur_off, len);
         if (copylen > 0) {
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+            rc = _os_mbuf_unshare(cur);
+            if (rc != 0) {
+                return rc;
+            }
+#endif
             memcpy(cur->om_data + cur_off, sptr, copylen);
             sptr += copylen;
             len -= copylen;
@@ -25,16 +25,22 @@
 #define OS_TRACE_DISABLE_FILE_API
 #endif
 #include "os/mynewt.h"
+#include "os_priv.h"
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+#include "console/console.h"
+#endif
 
 #define OS_MEM_TRUE_BLOCK_SIZE(bsize)   OS_ALIGN(bsize, OS_ALIGNMENT)
 #if MYNEWT_VAL(OS_MEMPOOL_GUARD)
-#define OS_MEMPOOL_TRUE_BLOCK_SIZE(mp)                                  \
+#define OS_MEMPOOL_BLOCK_END(mp)                                        \
     (((mp)->mp_flags & OS_MEMPOOL_F_EXT) ?                              \
       OS_MEM_TRUE_BLOCK_SIZE(mp->mp_block_size) :                       \
       (OS_MEM_TRUE_BLOCK_SIZE(mp->mp_block_size) + sizeof(os_membuf_t)))
 #else
-#define OS_MEMPOOL_TRUE_BLOCK_SIZE(mp) OS_MEM_TRUE_BLOCK_SIZE(mp->mp_block_size)
+#define OS_MEMPOOL_BLOCK_END(mp) OS_MEM_TRUE_BLOCK_SIZE(mp->mp_block_size)
 #endif
+#define OS_MEMPOOL_TRUE_BLOCK_SIZE(mp)                                  \
+    (OS_MEMPOOL_BLOCK_END(mp) + OS_MEMPOOL_TRACK_SZ)
 
 STAILQ_HEAD(, os_mempool) g_os_mempool_list =
     STAILQ_HEAD_INITIALIZER(g_os_mempool_list);
@@ -114,6 +120,173 @@ os_mempool_guard_check(const struct os_mempool *mp, void *start)
 #define os_mempool_guard(mp, start)
 #define os_mempool_guard_check(mp, start)
 #endif
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+#define OS_MEMPOOL_TRACK_AGE_MAX                                        \
+    (MYNEWT_VAL(OS_MEMPOOL_TRACK_AGE_MAX) * OS_TICKS_PER_SEC / 1000)
+#define OS_MEMPOOL_TRACK_INTERVAL                                       \
+    (MYNEWT_VAL(OS_MEMPOOL_TRACK_INTERVAL) * OS_TICKS_PER_SEC / 1000)
+
+static struct os_callout os_mempool_track_callout;
+
+/* Blocks allocated up to this time have already been reported */
+static os_time_t os_mempool_track_reported;
+
+static struct os_memblock_track *
+os_mempool_track_rec(const struct os_mempool *mp, const void *start)
+{
+    return (struct os_memblock_track *)((uintptr_t)start +
+                                        OS_MEMPOOL_BLOCK_END(mp));
+}
+
+static void
+os_mempool_track(const struct os_mempool *mp, void *start, const void *site)
+{
+    struct os_memblock_track *mbt;
+
+    mbt = os_mempool_track_rec(mp, start);
+    mbt->mbt_time = os_time_get();
+    mbt->mbt_site = (uintptr_t)site;
+}
+
+static void
+os_mempool_untrack(const struct os_mempool *mp, void *start)
+{
+    os_mempool_track_rec(mp, start)->mbt_site = 0;
+}
+#else
+#define os_mempool_track(mp, start, site)
+#define os_mempool_untrack(mp, start)
+#endif
+
+#if defined(OS_MEMPOOL_LOCKFREE_LLSC) || defined(OS_MEMPOOL_LOCKFREE_TAGGED)
+#define OS_MEMPOOL_LOCKFREE_IMPL    (1)
+
+/*
+ * Reserves cnt blocks by decrementing mp_num_free, unless fewer are free,
+ * and lowers mp_min_free accordingly.  Blocks are pushed on the free list
+ * before mp_num_free is incremented, so the list always holds at least
+ * mp_num_free blocks and a successful reservation guarantees that the
+ * following pops find them.
+ */
+static int
+os_mempool_reserve(struct os_mempool *mp, uint16_t cnt)
+{
+    uint16_t nfree;
+    uint16_t min;
+
+    nfree = __atomic_load_n(&mp->mp_num_free, __ATOMIC_RELAXED);
+    do {
+        if (nfree < cnt) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&mp->mp_num_free, &nfree,
+                                          nfree - cnt, 1, __ATOMIC_ACQUIRE,
+                                          __ATOMIC_RELAXED));
+    nfree -= cnt;
+
+    min = __atomic_load_n(&mp->mp_min_free, __ATOMIC_RELAXED);
+    while (nfree < min &&
+           !__atomic_compare_exchange_n(&mp->mp_min_free, &min, nfree, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    return 1;
+}
+
+#ifdef OS_MEMPOOL_LOCKFREE_LLSC
+static struct os_memblock *
+os_mempool_pop(struct os_mempool *mp)
+{
+    volatile uint32_t *head;
+    struct os_memblock *block;
+
+    head = (volatile uint32_t *)&SLIST_FIRST(mp);
+    do {
+        block = (struct os_memblock *)__LDREXW(head);
+    } while (__STREXW((uint32_t)SLIST_NEXT(block, mb_next), head) != 0);
+
+    return block;
+}
+
+/* Pushes the list of blocks from first to last on the free list. */
+static void
+os_mempool_push(struct os_mempool *mp, struct os_memblock *first,
+                struct os_memblock *last)
+{
+    volatile uint32_t *head;
+    uint32_t next;
+
+    head = (volatile uint32_t *)&SLIST_FIRST(mp);
+    while (1) {
+        /* Link the list before claiming the head, so that no other store
+         * happens between the exclusive load and store.
+         */
+        next = *head;
+        SLIST_NEXT(last, mb_next) = (struct os_memblock *)next;
+        if (__LDREXW(head) != next) {
+            __CLREX();
+            continue;
+        }
+        if (__STREXW((uint32_t)first, head) == 0) {
+            break;
+        }
+    }
+}
+#else
+/* Layout of mp_free_word */
+struct os_mempool_free {
+    struct os_memblock *head;
+    uint32_t gen;
+};
+
+_Static_assert(sizeof(struct os_mempool_free) == sizeof(uint64_t),
+               "Free list head and generation must fit in 64 bits");
+
+static struct os_memblock *
+os_mempool_pop(struct os_mempool *mp)
+{
+    struct os_mempool_free old;
+    struct os_mempool_free new;
+    uint64_t oldw;
+    uint64_t neww;
+
+    oldw = __atomic_load_n(&mp->mp_free_word, __ATOMIC_ACQUIRE);
+    do {
+        memcpy(&old, &oldw, sizeof(old));
+        /* May read a block someone else took; the swap fails then. */
+        new.head = SLIST_NEXT(old.head, mb_next);
+        new.gen = old.gen + 1;
+        memcpy(&neww, &new, sizeof(neww));
+    } while (!__atomic_compare_exchange_n(&mp->mp_free_word, &oldw, neww, 1,
+                                          __ATOMIC_ACQUIRE,
+                                          __ATOMIC_ACQUIRE));
+
+    return old.head;
+}
+
+/* Pushes the list of blocks from first to last on the free list. */
+static void
+os_mempool_push(struct os_mempool *mp, struct os_memblock *first,
+                struct os_memblock *last)
+{
+    struct os_mempool_free old;
+    struct os_mempool_free new;
+    uint64_t oldw;
+    uint64_t neww;
+
+    oldw = __atomic_load_n(&mp->mp_free_word, __ATOMIC_RELAXED);
+    do {
+        memcpy(&old, &oldw, sizeof(old));
+        SLIST_NEXT(last, mb_next) = old.head;
+        new.head = first;
+        new.gen = old.gen + 1;
+        memcpy(&neww, &new, sizeof(neww));
+    } while (!__atomic_compare_exchange_n(&mp->mp_free_word, &oldw, neww, 1,
+                                          __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+}
+#endif
+#endif
 
 static os_error_t
 os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
@@ -152,6 +325,7 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
     mp->name = name;
     os_mempool_poison(mp, membuf);
     os_mempool_guard(mp, membuf);
+    os_mempool_untrack(mp, membuf);
     SLIST_FIRST(mp) = membuf;
 
     true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
@@ -163,6 +337,7 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
         block_addr += true_block_size;
         os_mempool_poison(mp, block_addr);
         os_mempool_guard(mp, block_addr);
+        os_mempool_untrack(mp, block_addr);
         SLIST_NEXT(block_ptr, mb_next) = (struct os_memblock *)block_addr;
         block_ptr = (struct os_memblock *)block_addr;
         --blocks;
@@ -258,6 +433,7 @@ os_mempool_clear(struct os_mempool *mp)
     mp->mp_min_free = mp->mp_num_blocks;
     os_mempool_poison(mp, (void *)mp->mp_membuf_addr);
     os_mempool_guard(mp, (void *)mp->mp_membuf_addr);
+    os_mempool_untrack(mp, (void *)mp->mp_membuf_addr);
     SLIST_FIRST(mp) = (void *)mp->mp_membuf_addr;
 
     /* Chain the memory blocks to the free list */
@@ -269,6 +445,7 @@ os_mempool_clear(struct os_mempool *mp)
         block_addr += true_block_size;
         os_mempool_poison(mp, block_addr);
         os_mempool_guard(mp, block_addr);
+        os_mempool_untrack(mp, block_addr);
         SLIST_NEXT(block_ptr, mb_next) = (struct os_memblock *)block_addr;
         block_ptr = (struct os_memblock *)block_addr;
         --blocks;
@@ -327,7 +504,9 @@ os_memblock_from(const struct os_mempool *mp, const void *block_addr)
 void *
 os_memblock_get(struct os_mempool *mp)
 {
+#if !OS_MEMPOOL_LOCKFREE_IMPL
     os_sr_t sr;
+#endif
     struct os_memblock *block;
 
     os_trace_api_u32(OS_TRACE_ID_MEMBLOCK_GET, (uint32_t)mp);
@@ -335,6 +514,11 @@ os_memblock_get(struct os_mempool *mp)
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
     if (mp) {
+#if OS_MEMPOOL_LOCKFREE_IMPL
+        if (os_mempool_reserve(mp, 1)) {
+            block = os_mempool_pop(mp);
+        }
+#else
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
         if (mp->mp_num_free) {
@@ -351,10 +535,12 @@ os_memblock_get(struct os_mempool *mp)
             }
         }
         OS_EXIT_CRITICAL(sr);
+#endif
 
         if (block) {
             os_mempool_poison_check(mp, block);
             os_mempool_guard_check(mp, block);
+            os_mempool_track(mp, block, __builtin_return_address(0));
         }
     }
 
@@ -366,7 +552,9 @@ os_memblock_get(struct os_mempool *mp)
 os_error_t
 os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
 {
+#if !OS_MEMPOOL_LOCKFREE_IMPL
     os_sr_t sr;
+#endif
     struct os_memblock *block;
 
     os_trace_api_u32x2(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)mp,
@@ -374,8 +562,13 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
 
     os_mempool_guard_check(mp, block_addr);
     os_mempool_poison(mp, block_addr);
+    os_mempool_untrack(mp, block_addr);
 
     block = (struct os_memblock *)block_addr;
+#if OS_MEMPOOL_LOCKFREE_IMPL
+    os_mempool_push(mp, block, block);
+    __atomic_fetch_add(&mp->mp_num_free, 1, __ATOMIC_RELEASE);
+#else
     OS_ENTER_CRITICAL(sr);
 
     /* Chain current free list pointer to this block; make this block head */
@@ -387,6 +580,7 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     mp->mp_num_free++;
 
     OS_EXIT_CRITICAL(sr);
+#endif
 
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)OS_OK);
 
@@ -441,6 +635,119 @@ done:
     return ret;
 }
 
+os_error_t
+os_memblock_get_n(struct os_mempool *mp, void **blocks, int cnt)
+{
+#if !OS_MEMPOOL_LOCKFREE_IMPL
+    struct os_memblock *block;
+    os_sr_t sr;
+#endif
+    int i;
+
+    if (mp == NULL || blocks == NULL || cnt < 0) {
+        return OS_INVALID_PARM;
+    }
+
+#if OS_MEMPOOL_LOCKFREE_IMPL
+    if (!os_mempool_reserve(mp, cnt)) {
+        return OS_ENOMEM;
+    }
+    for (i = 0; i < cnt; i++) {
+        blocks[i] = os_mempool_pop(mp);
+    }
+#else
+    OS_ENTER_CRITICAL(sr);
+    if (mp->mp_num_free < cnt) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_ENOMEM;
+    }
+
+    /* Unlink the first cnt blocks of the free list */
+    block = SLIST_FIRST(mp);
+    for (i = 0; i < cnt; i++) {
+        blocks[i] = block;
+        block = SLIST_NEXT(block, mb_next);
+    }
+    SLIST_FIRST(mp) = block;
+
+    mp->mp_num_free -= cnt;
+    if (mp->mp_min_free > mp->mp_num_free) {
+        mp->mp_min_free = mp->mp_num_free;
+    }
+    OS_EXIT_CRITICAL(sr);
+#endif
+
+    for (i = 0; i < cnt; i++) {
+        os_mempool_poison_check(mp, blocks[i]);
+        os_mempool_guard_check(mp, blocks[i]);
+        os_mempool_track(mp, blocks[i], __builtin_return_address(0));
+    }
+
+    return OS_OK;
+}
+
+os_error_t
+os_memblock_put_n(struct os_mempool *mp, void **blocks, int cnt)
+{
+    struct os_memblock *first;
+    struct os_memblock *last;
+    os_error_t rc;
+    bool slow;
+    int i;
+#if !OS_MEMPOOL_LOCKFREE_IMPL
+    os_sr_t sr;
+#endif
+
+    if (mp == NULL || blocks == NULL || cnt < 0) {
+        return OS_INVALID_PARM;
+    }
+    if (cnt == 0) {
+        return OS_OK;
+    }
+
+    /* Put callbacks and debug checks are per block; let
+     * os_memblock_put() deal with them.
+     */
+    slow = MYNEWT_VAL(OS_MEMPOOL_CHECK) ||
+           ((mp->mp_flags & OS_MEMPOOL_F_EXT) &&
+            ((struct os_mempool_ext *)mp)->mpe_put_cb != NULL);
+    if (slow) {
+        for (i = 0; i < cnt; i++) {
+            rc = os_memblock_put(mp, blocks[i]);
+            if (rc != OS_OK) {
+                return rc;
+            }
+        }
+        return OS_OK;
+    }
+
+    /* Link the blocks together, then splice them onto the free list */
+    for (i = 0; i < cnt; i++) {
+        os_mempool_guard_check(mp, blocks[i]);
+        os_mempool_poison(mp, blocks[i]);
+        os_mempool_untrack(mp, blocks[i]);
+        if (i > 0) {
+            SLIST_NEXT((struct os_memblock *)blocks[i - 1], mb_next) =
+                blocks[i];
+        }
+    }
+    first = blocks[0];
+    last = blocks[cnt - 1];
+
+#if OS_MEMPOOL_LOCKFREE_IMPL
+    os_mempool_push(mp, first, last);
+    __atomic_fetch_add(&mp->mp_num_free, cnt, __ATOMIC_RELEASE);
+#else
+    OS_ENTER_CRITICAL(sr);
+    SLIST_NEXT(last, mb_next) = SLIST_FIRST(mp);
+    SLIST_FIRST(mp) = first;
+    mp->mp_num_free += cnt;
+    OS_EXIT_CRITICAL(sr);
+#endif
+
+    return OS_OK;
+}
+
 struct os_mempool *
 os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 {
@@ -466,3 +773,117 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 }
 
 
+
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+void
+os_memblock_track_site(const struct os_mempool *mp, void *block,
+                       const void *site)
+{
+    os_mempool_track_rec(mp, block)->mbt_site = (uintptr_t)site;
+}
+
+int
+os_mempool_track_sites(const struct os_mempool *mp,
+                       struct os_mempool_site *sites, int max)
+{
+    struct os_memblock_track mbt;
+    uint8_t *block_addr;
+    os_sr_t sr;
+    int cnt;
+    int i;
+    int j;
+
+    cnt = 0;
+    block_addr = (uint8_t *)mp->mp_membuf_addr;
+    for (i = 0; i < mp->mp_num_blocks; i++) {
+        /* Read the record in one go; the block may be freed meanwhile. */
+        OS_ENTER_CRITICAL(sr);
+        mbt = *os_mempool_track_rec(mp, block_addr);
+        OS_EXIT_CRITICAL(sr);
+        block_addr += OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
+
+        if (mbt.mbt_site == 0) {
+            continue;
+        }
+
+        for (j = 0; j < cnt; j++) {
+            if (sites[j].oms_site == mbt.mbt_site) {
+                break;
+            }
+        }
+        if (j == cnt) {
+            if (cnt == max) {
+                continue;
+            }
+            sites[j].oms_site = mbt.mbt_site;
+            sites[j].oms_count = 0;
+            sites[j].oms_oldest = mbt.mbt_time;
+            cnt++;
+        }
+
+        sites[j].oms_count++;
+        if (OS_TIME_TICK_LT(mbt.mbt_time, sites[j].oms_oldest)) {
+            sites[j].oms_oldest = mbt.mbt_time;
+        }
+    }
+
+    return cnt;
+}
+
+/*
+ * Reports every block which has been allocated for longer than
+ * OS_MEMPOOL_TRACK_AGE_MAX, once.
+ */
+static void
+os_mempool_track_check(struct os_event *ev)
+{
+    struct os_memblock_track mbt;
+    struct os_mempool *mp;
+    uint8_t *block_addr;
+    os_time_t cutoff;
+    os_time_t now;
+    os_sr_t sr;
+    int i;
+
+    now = os_time_get();
+    cutoff = now - OS_MEMPOOL_TRACK_AGE_MAX;
+
+    STAILQ_FOREACH(mp, &g_os_mempool_list, mp_list) {
+        block_addr = (uint8_t *)mp->mp_membuf_addr;
+        for (i = 0; i < mp->mp_num_blocks; i++) {
+            OS_ENTER_CRITICAL(sr);
+            mbt = *os_mempool_track_rec(mp, block_addr);
+            OS_EXIT_CRITICAL(sr);
+
+            if (mbt.mbt_site != 0 &&
+                OS_TIME_TICK_GT(mbt.mbt_time, os_mempool_track_reported) &&
+                OS_TIME_TICK_GEQ(cutoff, mbt.mbt_time)) {
+
+                console_printf("mempool %s: block %p held for %lu ms, "
+                               "allocated at 0x%08lx\n",
+                               mp->name, block_addr,
+                               (unsigned long)os_time_ticks_to_ms32(
+                                   now - mbt.mbt_time),
+                               (unsigned long)mbt.mbt_site);
+            }
+            block_addr += OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
+        }
+    }
+
+    os_mempool_track_reported = cutoff;
+    os_callout_reset(&os_mempool_track_callout, OS_MEMPOOL_TRACK_INTERVAL);
+}
+
+void
+os_mempool_track_init(void)
+{
+    os_mempool_track_reported = os_time_get() - OS_MEMPOOL_TRACK_AGE_MAX;
+
+    if (OS_MEMPOOL_TRACK_INTERVAL > 0) {
+        os_callout_init(&os_mempool_track_callout, os_eventq_dflt_get(),
+                        os_mempool_track_check, NULL);
+        os_callout_reset(&os_mempool_track_callout,
+                         OS_MEMPOOL_TRACK_INTERVAL);
+    }
+}
+#endif
@@ -38,6 +38,31 @@ extern struct os_task_stailq g_os_task_list;
 extern struct os_callout_list g_callout_list;
 
 void os_msys_init(void);
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+void os_callout_wheel_init(void);
+#endif
+#if MYNEWT_VAL(OS_SCHED_STATS)
+void os_sched_stats_init(void);
+void os_sched_stats_idle(os_time_t now);
+#endif
+#if MYNEWT_VAL(OS_TASK_PROF)
+void os_sched_prof_restart(uint32_t now);
+#endif
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+void os_task_stack_scan(void);
+#endif
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+void os_crit_trace_init(void);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+void os_malloc_slab_init(void);
+#endif
+#if MYNEWT_VAL(MSYS_STATS)
+void os_msys_stats_init(void);
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+void os_mempool_track_init(void);
+#endif
 
 /**
  * Prints information about a crash to the console.  This functionality is
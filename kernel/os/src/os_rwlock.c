@@ -0,0 +1,559 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+
+/*
+ * Uncontended locks and unlocks only compare-and-swap rw_state.  Where the
+ * architecture has no suitable compare-and-swap the helpers below use a
+ * critical section instead.  Everything that touches the wait list runs in
+ * a critical section, and OS_RWLOCK_WAITERS keeps the fast paths off the
+ * lock while anybody waits.
+ */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+    MYNEWT_VAL(BSP_SIMULATED)
+#define OS_RWLOCK_ATOMIC    (1)
+#endif
+
+static inline uint32_t
+os_rwlock_state(struct os_rwlock *rw)
+{
+#ifdef OS_RWLOCK_ATOMIC
+    return __atomic_load_n(&rw->rw_state, __ATOMIC_ACQUIRE);
+#else
+    return *(volatile uint32_t *)&rw->rw_state;
+#endif
+}
+
+static int
+os_rwlock_state_cas(struct os_rwlock *rw, uint32_t old, uint32_t new)
+{
+#ifdef OS_RWLOCK_ATOMIC
+    return __atomic_compare_exchange_n(&rw->rw_state, &old, new, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#else
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    rc = rw->rw_state == old;
+    if (rc) {
+        rw->rw_state = new;
+    }
+    OS_EXIT_CRITICAL(sr);
+    return rc;
+#endif
+}
+
+/**
+ * Records 't' as a reader so that waiters can lend it their priority.
+ * 'prio' is the priority to restore on release.  Readers beyond
+ * OS_RWLOCK_MAX_READERS are only counted in rw_rd_untracked.
+ */
+static void
+os_rwlock_reader_add(struct os_rwlock *rw, struct os_task *t, uint8_t prio)
+{
+    struct os_rwlock_reader *rr;
+    int i;
+#ifdef OS_RWLOCK_ATOMIC
+    struct os_task *none;
+#else
+    os_sr_t sr;
+#endif
+
+    for (i = 0; i < MYNEWT_VAL(OS_RWLOCK_MAX_READERS); i++) {
+        rr = &rw->rw_readers[i];
+#ifdef OS_RWLOCK_ATOMIC
+        none = NULL;
+        if (__atomic_compare_exchange_n(&rr->rr_task, &none, t, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            rr->rr_prio = prio;
+            return;
+        }
+#else
+        OS_ENTER_CRITICAL(sr);
+        if (rr->rr_task == NULL) {
+            rr->rr_task = t;
+            rr->rr_prio = prio;
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        OS_EXIT_CRITICAL(sr);
+#endif
+    }
+
+#ifdef OS_RWLOCK_ATOMIC
+    __atomic_fetch_add(&rw->rw_rd_untracked, 1, __ATOMIC_ACQ_REL);
+#else
+    OS_ENTER_CRITICAL(sr);
+    rw->rw_rd_untracked++;
+    OS_EXIT_CRITICAL(sr);
+#endif
+}
+
+/**
+ * Drops one of the untracked readers.
+ *
+ * @return 0 on success; -1 if there were none.
+ */
+static int
+os_rwlock_untracked_del(struct os_rwlock *rw)
+{
+#ifdef OS_RWLOCK_ATOMIC
+    uint16_t cnt;
+
+    cnt = __atomic_load_n(&rw->rw_rd_untracked, __ATOMIC_ACQUIRE);
+    do {
+        if (cnt == 0) {
+            return -1;
+        }
+    } while (!__atomic_compare_exchange_n(&rw->rw_rd_untracked, &cnt,
+                                          cnt - 1, 0, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+    return 0;
+#else
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (rw->rw_rd_untracked == 0) {
+        rc = -1;
+    } else {
+        rw->rw_rd_untracked--;
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+    return rc;
+#endif
+}
+
+/**
+ * Forgets reader 't'.
+ *
+ * @return The priority 't' had when it took the lock; -1 if it was not
+ *         tracked.
+ */
+static int
+os_rwlock_reader_del(struct os_rwlock *rw, struct os_task *t)
+{
+    struct os_rwlock_reader *rr;
+    int prio;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(OS_RWLOCK_MAX_READERS); i++) {
+        rr = &rw->rw_readers[i];
+        if (rr->rr_task == t) {
+            /* The slot is up for grabs once cleared */
+            prio = rr->rr_prio;
+#ifdef OS_RWLOCK_ATOMIC
+            __atomic_store_n(&rr->rr_task, NULL, __ATOMIC_RELEASE);
+#else
+            rr->rr_task = NULL;
+#endif
+            return prio;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Raises the writer and the tracked readers to at least 'prio'.
+ */
+static void
+os_rwlock_boost(struct os_rwlock *rw, uint8_t prio)
+{
+    struct os_task *t;
+    int i;
+
+    OS_ASSERT_CRITICAL();
+
+    t = rw->rw_writer;
+    if (t && t->t_prio > prio) {
+        t->t_prio = prio;
+        os_sched_resort(t);
+    }
+    for (i = 0; i < MYNEWT_VAL(OS_RWLOCK_MAX_READERS); i++) {
+        t = rw->rw_readers[i].rr_task;
+        if (t && t->t_prio > prio) {
+            t->t_prio = prio;
+            os_sched_resort(t);
+        }
+    }
+}
+
+/**
+ * Called after taking the lock on a fast path.  A task that started waiting
+ * before we registered as owner could not boost us, so do it here.
+ */
+static void
+os_rwlock_inherit(struct os_rwlock *rw)
+{
+    struct os_task *t;
+    os_sr_t sr;
+
+    if (os_rwlock_state(rw) & OS_RWLOCK_WAITERS) {
+        OS_ENTER_CRITICAL(sr);
+        t = SLIST_FIRST(&rw->rw_head);
+        if (t) {
+            os_rwlock_boost(rw, t->t_prio);
+        }
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
+static void
+os_rwlock_restore_prio(struct os_task *t, uint8_t prio)
+{
+    os_sr_t sr;
+
+    if (t->t_prio != prio) {
+        OS_ENTER_CRITICAL(sr);
+        t->t_prio = prio;
+        os_sched_resort(t);
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
+static void
+os_rwlock_grant(struct os_task *t, uint8_t flag)
+{
+    assert(t->t_obj);
+    t->t_flags &= ~flag;
+    t->t_lockcnt++;
+    os_sched_wakeup(t);
+}
+
+/**
+ * Hands the lock to waiters, if it is free for them.  The head of the wait
+ * list is the highest priority waiter.  A writer there gets the lock once no
+ * one holds it; otherwise all readers queued before the first writer join
+ * the current readers.
+ */
+static void
+os_rwlock_handoff(struct os_rwlock *rw)
+{
+    struct os_task *t;
+    struct os_task *next;
+
+    OS_ASSERT_CRITICAL();
+
+    t = SLIST_FIRST(&rw->rw_head);
+    if (t && (t->t_flags & OS_TASK_FLAG_RWLOCK_WR_WAIT)) {
+        if (!(rw->rw_state & (OS_RWLOCK_WRITER | OS_RWLOCK_READERS_MASK))) {
+            rw->rw_state |= OS_RWLOCK_WRITER;
+            rw->rw_writer = t;
+            rw->rw_writer_prio = t->t_prio;
+            rw->rw_wr_waiting--;
+            os_rwlock_grant(t, OS_TASK_FLAG_RWLOCK_WR_WAIT);
+        }
+    } else if (!(rw->rw_state & OS_RWLOCK_WRITER)) {
+        while (t && (t->t_flags & OS_TASK_FLAG_RWLOCK_RD_WAIT)) {
+            next = SLIST_NEXT(t, t_obj_list);
+            rw->rw_state++;
+            os_rwlock_reader_add(rw, t, t->t_prio);
+            os_rwlock_grant(t, OS_TASK_FLAG_RWLOCK_RD_WAIT);
+            t = next;
+        }
+    }
+
+    /* New owners inherit from whoever is still waiting */
+    t = SLIST_FIRST(&rw->rw_head);
+    if (t) {
+        os_rwlock_boost(rw, t->t_prio);
+    } else {
+        rw->rw_state &= ~OS_RWLOCK_WAITERS;
+    }
+}
+
+/**
+ * Release slow path: clears 'clr' from the state, drops the current task
+ * back to 'prio' (unless negative), hands the lock to waiters and yields to
+ * them if they outrank us.  Like os_mutex_release(), all of it happens in
+ * one critical section, so nothing can run between losing the inherited
+ * priority and the waiters getting the lock.
+ */
+static void
+os_rwlock_wake(struct os_rwlock *rw, uint32_t clr, int prio)
+{
+    struct os_task *current;
+    struct os_task *rdy;
+    os_sr_t sr;
+
+    current = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    rw->rw_state &= ~clr;
+    if (prio >= 0 && current->t_prio != prio) {
+        current->t_prio = prio;
+        os_sched_resort(current);
+    }
+    os_rwlock_handoff(rw);
+    rdy = os_sched_next_task();
+    OS_EXIT_CRITICAL(sr);
+
+    if (rdy != current) {
+        os_sched(rdy);
+    }
+}
+
+/**
+ * Pend slow path.  Takes the lock if it can, otherwise queues the current
+ * task in priority order and lends its priority to the owners.
+ */
+static os_error_t
+os_rwlock_wait(struct os_rwlock *rw, os_time_t timeout, uint8_t flag)
+{
+    struct os_task *current;
+    struct os_task *entry;
+    struct os_task *last;
+    struct os_task *rdy;
+    os_sr_t sr;
+
+    current = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+
+    if (flag == OS_TASK_FLAG_RWLOCK_RD_WAIT) {
+        if (!(rw->rw_state & OS_RWLOCK_WRITER) && rw->rw_wr_waiting == 0) {
+            assert((rw->rw_state & OS_RWLOCK_READERS_MASK) !=
+                   OS_RWLOCK_READERS_MASK);
+            rw->rw_state++;
+            os_rwlock_reader_add(rw, current, current->t_prio);
+            current->t_lockcnt++;
+            OS_EXIT_CRITICAL(sr);
+            return OS_OK;
+        }
+        rw->rw_rd_blocked++;
+    } else {
+        if (!(rw->rw_state & (OS_RWLOCK_WRITER | OS_RWLOCK_READERS_MASK))) {
+            rw->rw_state |= OS_RWLOCK_WRITER;
+            rw->rw_writer = current;
+            rw->rw_writer_prio = current->t_prio;
+            current->t_lockcnt++;
+            OS_EXIT_CRITICAL(sr);
+            return OS_OK;
+        }
+        rw->rw_wr_blocked++;
+    }
+
+    if (timeout == 0) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_TIMEOUT;
+    }
+
+    /* Insert in priority order, behind waiters of the same priority */
+    last = NULL;
+    SLIST_FOREACH(entry, &rw->rw_head, t_obj_list) {
+        if (current->t_prio < entry->t_prio) {
+            break;
+        }
+        last = entry;
+    }
+    if (last) {
+        SLIST_INSERT_AFTER(last, current, t_obj_list);
+    } else {
+        SLIST_INSERT_HEAD(&rw->rw_head, current, t_obj_list);
+    }
+
+    if (flag == OS_TASK_FLAG_RWLOCK_WR_WAIT) {
+        rw->rw_wr_waiting++;
+    }
+    rw->rw_state |= OS_RWLOCK_WAITERS;
+    os_rwlock_boost(rw, current->t_prio);
+
+    current->t_obj = rw;
+    current->t_flags |= flag;
+    os_sched_sleep(current, timeout);
+    OS_EXIT_CRITICAL(sr);
+
+    os_sched(NULL);
+
+    /* The granting task clears our wait flag */
+    if (!(current->t_flags & flag)) {
+        return OS_OK;
+    }
+
+    /*
+     * Timed out.  A writer leaving the queue may let the readers queued
+     * behind it in.
+     */
+    OS_ENTER_CRITICAL(sr);
+    current->t_flags &= ~flag;
+    if (flag == OS_TASK_FLAG_RWLOCK_WR_WAIT) {
+        rw->rw_wr_waiting--;
+    }
+    rw->rw_timeouts++;
+    os_rwlock_handoff(rw);
+    rdy = os_sched_next_task();
+    OS_EXIT_CRITICAL(sr);
+
+    if (rdy != current) {
+        os_sched(rdy);
+    }
+    return OS_TIMEOUT;
+}
+
+os_error_t
+os_rwlock_init(struct os_rwlock *rw)
+{
+    if (!rw) {
+        return OS_INVALID_PARM;
+    }
+
+    memset(rw, 0, sizeof(*rw));
+    SLIST_FIRST(&rw->rw_head) = NULL;
+
+    return OS_OK;
+}
+
+os_error_t
+os_rwlock_read_pend(struct os_rwlock *rw, os_time_t timeout)
+{
+    struct os_task *current;
+    uint32_t state;
+    uint8_t prio;
+
+    if (!g_os_started) {
+        return OS_NOT_STARTED;
+    }
+    if (!rw) {
+        return OS_INVALID_PARM;
+    }
+
+    current = os_sched_get_current_task();
+    prio = current->t_prio;
+
+    state = os_rwlock_state(rw);
+    while (!(state & (OS_RWLOCK_WRITER | OS_RWLOCK_WAITERS))) {
+        assert((state & OS_RWLOCK_READERS_MASK) != OS_RWLOCK_READERS_MASK);
+        if (os_rwlock_state_cas(rw, state, state + 1)) {
+            os_rwlock_reader_add(rw, current, prio);
+            current->t_lockcnt++;
+            os_rwlock_inherit(rw);
+            return OS_OK;
+        }
+        state = os_rwlock_state(rw);
+    }
+
+    return os_rwlock_wait(rw, timeout, OS_TASK_FLAG_RWLOCK_RD_WAIT);
+}
+
+os_error_t
+os_rwlock_read_release(struct os_rwlock *rw)
+{
+    struct os_task *current;
+    uint32_t state;
+    int prio;
+
+    if (!g_os_started) {
+        return OS_NOT_STARTED;
+    }
+    if (!rw) {
+        return OS_INVALID_PARM;
+    }
+
+    /* Only a reader may release; an untracked one can't be told apart */
+    current = os_sched_get_current_task();
+    prio = os_rwlock_reader_del(rw, current);
+    if (prio < 0 && os_rwlock_untracked_del(rw) != 0) {
+        return OS_BAD_MUTEX;
+    }
+
+    do {
+        state = os_rwlock_state(rw);
+        assert(state & OS_RWLOCK_READERS_MASK);
+    } while (!os_rwlock_state_cas(rw, state, state - 1));
+
+    current->t_lockcnt--;
+
+    /* Last reader out lets the waiters in */
+    if ((state & OS_RWLOCK_READERS_MASK) == 1 &&
+        (state & OS_RWLOCK_WAITERS)) {
+        os_rwlock_wake(rw, 0, prio);
+    } else if (prio >= 0) {
+        os_rwlock_restore_prio(current, prio);
+    }
+
+    return OS_OK;
+}
+
+os_error_t
+os_rwlock_write_pend(struct os_rwlock *rw, os_time_t timeout)
+{
+    struct os_task *current;
+    uint8_t prio;
+
+    if (!g_os_started) {
+        return OS_NOT_STARTED;
+    }
+    if (!rw) {
+        return OS_INVALID_PARM;
+    }
+
+    current = os_sched_get_current_task();
+    prio = current->t_prio;
+
+    if (os_rwlock_state_cas(rw, 0, OS_RWLOCK_WRITER)) {
+        rw->rw_writer_prio = prio;
+        rw->rw_writer = current;
+        current->t_lockcnt++;
+        os_rwlock_inherit(rw);
+        return OS_OK;
+    }
+
+    return os_rwlock_wait(rw, timeout, OS_TASK_FLAG_RWLOCK_WR_WAIT);
+}
+
+os_error_t
+os_rwlock_write_release(struct os_rwlock *rw)
+{
+    struct os_task *current;
+    uint8_t prio;
+
+    if (!g_os_started) {
+        return OS_NOT_STARTED;
+    }
+    if (!rw) {
+        return OS_INVALID_PARM;
+    }
+
+    current = os_sched_get_current_task();
+    if (rw->rw_writer != current) {
+        return OS_BAD_MUTEX;
+    }
+
+    /*
+     * Drop ownership before the state word so that a waiter arriving in
+     * between does not boost a task that is on its way out.  The next
+     * writer overwrites rw_writer_prio, so read it first.
+     */
+    prio = rw->rw_writer_prio;
+    rw->rw_writer = NULL;
+    current->t_lockcnt--;
+
+    if (os_rwlock_state_cas(rw, OS_RWLOCK_WRITER, 0)) {
+        os_rwlock_restore_prio(current, prio);
+    } else {
+        os_rwlock_wake(rw, OS_RWLOCK_WRITER, prio);
+    }
+
+    return OS_OK;
+}
@@ -18,8 +18,12 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "os_priv.h"
+#if MYNEWT_VAL(OS_SCHED_STATS)
+#include "stats/stats.h"
+#endif
 
 struct os_task_list g_os_run_list = TAILQ_HEAD_INITIALIZER(g_os_run_list);
 struct os_task_list g_os_sleep_list = TAILQ_HEAD_INITIALIZER(g_os_sleep_list);
@@ -29,6 +33,372 @@ struct os_task *g_current_task;
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_TASK_PROF)
+/* os_cputime of the last context switch */
+static uint32_t os_sched_prof_last_sw;
+#endif
+
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+/*
+ * Priority bitmap run queue.
+ *
+ * The run list is still kept sorted by priority so that the architecture
+ * specific context switch code can simply pick its head.  In addition, the
+ * first ready task of every priority level is remembered and a two level
+ * bitmap records which levels are occupied.  This lets insertion find its
+ * spot with a couple of count-leading-zeros operations instead of walking
+ * the list.
+ *
+ * Priority 0 maps to the most significant bit of the first word, so the
+ * highest priority set in a word is given directly by clz.
+ */
+#define OS_SCHED_PRIO_LEVELS    (OS_TASK_PRI_LOWEST + 1)
+#define OS_SCHED_PRIO_WORDS     (OS_SCHED_PRIO_LEVELS / 32)
+
+static uint32_t os_sched_prio_map[OS_SCHED_PRIO_WORDS];
+static uint32_t os_sched_prio_grp;
+static struct os_task *os_sched_prio_head[OS_SCHED_PRIO_LEVELS];
+
+static void
+os_sched_prio_set(uint8_t prio)
+{
+    os_sched_prio_map[prio >> 5] |= 0x80000000UL >> (prio & 31);
+    os_sched_prio_grp |= 0x80000000UL >> (prio >> 5);
+}
+
+static void
+os_sched_prio_clear(uint8_t prio)
+{
+    os_sched_prio_map[prio >> 5] &= ~(0x80000000UL >> (prio & 31));
+    if (os_sched_prio_map[prio >> 5] == 0) {
+        os_sched_prio_grp &= ~(0x80000000UL >> (prio >> 5));
+    }
+}
+
+/*
+ * Returns the highest occupied priority level that is numerically greater
+ * than or equal to 'prio', or -1 if there is none.
+ */
+static int
+os_sched_prio_find(int prio)
+{
+    uint32_t bits;
+    int w;
+
+    if (prio >= OS_SCHED_PRIO_LEVELS) {
+        return (-1);
+    }
+
+    w = prio >> 5;
+    bits = os_sched_prio_map[w] & (0xffffffffUL >> (prio & 31));
+    if (bits != 0) {
+        return ((w << 5) + __builtin_clz(bits));
+    }
+
+    /* Look at the words following this one */
+    bits = os_sched_prio_grp & (0x7fffffffUL >> w);
+    if (bits == 0) {
+        return (-1);
+    }
+    w = __builtin_clz(bits);
+
+    return ((w << 5) + __builtin_clz(os_sched_prio_map[w]));
+}
+#endif
+
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+/*
+ * Sleep heap.
+ *
+ * Tasks sleeping with a timeout are kept in a pairing heap ordered by wakeup
+ * time; g_os_sleep_list then only holds tasks waiting forever.  Inserting a
+ * sleeping task is constant time and removing one, including the earliest,
+ * is logarithmic (amortized).  The heap is linked through the task structure
+ * itself: t_sleep_child is the first child, t_sleep_next the next sibling and
+ * t_sleep_prev either the previous sibling or, for a first child, the parent.
+ */
+static struct os_task *os_sched_sleep_heap;
+
+static struct os_task *
+os_sched_sleep_heap_meld(struct os_task *a, struct os_task *b)
+{
+    struct os_task *tmp;
+
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    if (OS_TIME_TICK_LT(b->t_next_wakeup, a->t_next_wakeup)) {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    /* b becomes the first child of a */
+    b->t_sleep_next = a->t_sleep_child;
+    if (a->t_sleep_child != NULL) {
+        a->t_sleep_child->t_sleep_prev = b;
+    }
+    b->t_sleep_prev = a;
+    a->t_sleep_child = b;
+
+    return a;
+}
+
+/*
+ * Melds a list of sibling subheaps into a single heap, using the standard
+ * two pass pairing.
+ */
+static struct os_task *
+os_sched_sleep_heap_pairs(struct os_task *t)
+{
+    struct os_task *pairs;
+    struct os_task *a;
+    struct os_task *b;
+
+    /* Left to right, meld siblings pairwise; stack the results */
+    pairs = NULL;
+    while (t != NULL) {
+        a = t;
+        b = a->t_sleep_next;
+        if (b != NULL) {
+            t = b->t_sleep_next;
+            b->t_sleep_next = NULL;
+            b->t_sleep_prev = NULL;
+        } else {
+            t = NULL;
+        }
+        a->t_sleep_next = NULL;
+        a->t_sleep_prev = NULL;
+
+        a = os_sched_sleep_heap_meld(a, b);
+        a->t_sleep_next = pairs;
+        pairs = a;
+    }
+
+    /* Right to left, meld the stacked pairs together */
+    t = NULL;
+    while (pairs != NULL) {
+        a = pairs;
+        pairs = a->t_sleep_next;
+        a->t_sleep_next = NULL;
+        t = os_sched_sleep_heap_meld(t, a);
+    }
+
+    return t;
+}
+
+static void
+os_sched_sleep_heap_insert(struct os_task *t)
+{
+    t->t_sleep_child = NULL;
+    t->t_sleep_next = NULL;
+    t->t_sleep_prev = NULL;
+    os_sched_sleep_heap = os_sched_sleep_heap_meld(os_sched_sleep_heap, t);
+}
+
+static void
+os_sched_sleep_heap_remove(struct os_task *t)
+{
+    struct os_task *sub;
+
+    sub = os_sched_sleep_heap_pairs(t->t_sleep_child);
+    t->t_sleep_child = NULL;
+
+    if (t == os_sched_sleep_heap) {
+        os_sched_sleep_heap = sub;
+        return;
+    }
+
+    /* Unlink from parent or previous sibling */
+    if (t->t_sleep_prev->t_sleep_child == t) {
+        t->t_sleep_prev->t_sleep_child = t->t_sleep_next;
+    } else {
+        t->t_sleep_prev->t_sleep_next = t->t_sleep_next;
+    }
+    if (t->t_sleep_next != NULL) {
+        t->t_sleep_next->t_sleep_prev = t->t_sleep_prev;
+    }
+    t->t_sleep_next = NULL;
+    t->t_sleep_prev = NULL;
+
+    os_sched_sleep_heap = os_sched_sleep_heap_meld(os_sched_sleep_heap, sub);
+}
+#endif
+
+#if MYNEWT_VAL(OS_SCHED_STATS)
+STATS_SECT_START(os_sched_stats)
+    STATS_SECT_ENTRY(tick_crit_max)
+    STATS_SECT_ENTRY(tick_wakeups)
+    STATS_SECT_ENTRY(idle_wakeups)
+    STATS_SECT_ENTRY(idle_wakeups_sec)
+STATS_SECT_END
+
+STATS_SECT_DECL(os_sched_stats) g_os_sched_stats;
+
+/* Longest critical section in the tick path, in os_cputime ticks */
+static uint32_t os_sched_tick_crit_max;
+
+/* Start of the current idle wakeup rate window, and sleeps within it */
+static os_time_t os_sched_idle_window;
+static uint32_t os_sched_idle_window_cnt;
+
+STATS_NAME_START(os_sched_stats)
+    STATS_NAME(os_sched_stats, tick_crit_max)
+    STATS_NAME(os_sched_stats, tick_wakeups)
+    STATS_NAME(os_sched_stats, idle_wakeups)
+    STATS_NAME(os_sched_stats, idle_wakeups_sec)
+STATS_NAME_END(os_sched_stats)
+
+void
+os_sched_stats_init(void)
+{
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(g_os_sched_stats),
+                            STATS_SIZE_INIT_PARMS(g_os_sched_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(os_sched_stats),
+                            "os_sched");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    os_sched_idle_window = os_time_get();
+}
+
+/**
+ * Called by the idle task every time it puts the CPU to sleep.  Counts the
+ * sleeps and, about once a second, updates the average number of wakeups
+ * per second since the previous update.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+void
+os_sched_stats_idle(os_time_t now)
+{
+    os_time_t elapsed;
+
+    STATS_INC(g_os_sched_stats, idle_wakeups);
+    os_sched_idle_window_cnt++;
+
+    elapsed = now - os_sched_idle_window;
+    if (elapsed >= OS_TICKS_PER_SEC) {
+        STATS_SET(g_os_sched_stats, idle_wakeups_sec,
+                  (uint64_t)os_sched_idle_window_cnt * OS_TICKS_PER_SEC /
+                  elapsed);
+        os_sched_idle_window = now;
+        os_sched_idle_window_cnt = 0;
+    }
+}
+#endif
+
+/*
+ * Links a ready task into the run list, behind any other task of the same
+ * priority.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static void
+os_sched_run_list_insert(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    int next_prio;
+
+    next_prio = os_sched_prio_find(t->t_prio + 1);
+    if (next_prio >= 0) {
+        TAILQ_INSERT_BEFORE(os_sched_prio_head[next_prio], t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_run_list, t, t_os_list);
+    }
+
+    /* Remember the level; t_prio can change before the task is removed */
+    t->t_run_prio = t->t_prio;
+    if (os_sched_prio_head[t->t_prio] == NULL) {
+        os_sched_prio_head[t->t_prio] = t;
+        os_sched_prio_set(t->t_prio);
+    }
+#else
+    struct os_task *entry;
+
+    entry = NULL;
+    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
+        if (t->t_prio < entry->t_prio) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
+    }
+#endif
+}
+
+/*
+ * Unlinks a task from the run list.
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    struct os_task *next;
+    uint8_t prio;
+
+    prio = t->t_run_prio;
+    if (os_sched_prio_head[prio] == t) {
+        next = TAILQ_NEXT(t, t_os_list);
+        if (next != NULL && next->t_run_prio == prio) {
+            os_sched_prio_head[prio] = next;
+        } else {
+            os_sched_prio_head[prio] = NULL;
+            os_sched_prio_clear(prio);
+        }
+    }
+#endif
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+
+/*
+ * Unlinks a task from the sleep list (or sleep heap).
+ *
+ * NOTE: must be called with interrupts disabled.
+ */
+static void
+os_sched_sleep_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    if (!(t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
+        os_sched_sleep_heap_remove(t);
+        return;
+    }
+#endif
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+}
+
+/**
+ * os sched reset
+ *
+ * Empties the run and sleep lists. Used by architectures which can
+ * re-initialize the OS at runtime (sim).
+ */
+void
+os_sched_reset(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+    TAILQ_INIT(&g_os_sleep_list);
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    os_sched_sleep_heap = NULL;
+#endif
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    memset(os_sched_prio_map, 0, sizeof(os_sched_prio_map));
+    memset(os_sched_prio_head, 0, sizeof(os_sched_prio_head));
+    os_sched_prio_grp = 0;
+#endif
+}
+
 /**
  * os sched insert
  *
@@ -43,7 +413,6 @@ os_time_t g_os_last_ctx_sw_time;
 os_error_t
 os_sched_insert(struct os_task *t)
 {
-    struct os_task *entry;
     os_sr_t sr;
     os_error_t rc;
 
@@ -52,18 +421,11 @@ os_sched_insert(struct os_task *t)
         goto err;
     }
 
-    entry = NULL;
     OS_ENTER_CRITICAL(sr);
-    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
-        if (t->t_prio < entry->t_prio) {
-            break;
-        }
-    }
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
-    } else {
-        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
-    }
+#if MYNEWT_VAL(OS_TASK_PROF)
+    t->t_prof.tp_ready_at = os_cputime_get32();
+#endif
+    os_sched_run_list_insert(t);
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -71,6 +433,63 @@ err:
     return (rc);
 }
 
+#if MYNEWT_VAL(OS_TASK_PROF)
+static void
+os_sched_prof_lat(struct os_task_prof *tp, uint32_t lat)
+{
+    uint32_t v;
+    int b;
+
+    if (lat > tp->tp_lat_max) {
+        tp->tp_lat_max = lat;
+    }
+
+    v = lat >> MYNEWT_VAL(OS_TASK_PROF_HIST_SHIFT);
+    if (v == 0) {
+        b = 0;
+    } else {
+        b = 32 - __builtin_clz(v);
+        if (b >= MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS)) {
+            b = MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS) - 1;
+        }
+    }
+    tp->tp_lat_hist[b]++;
+}
+
+/*
+ * Charge the slice that just ended to the outgoing task and account the time
+ * the incoming one spent waiting in the run list.  A task which is switched
+ * out while still ready (preempted) starts waiting again right away; one that
+ * went to sleep gets its ready timestamp when it is woken up.
+ */
+static void
+os_sched_prof_switch(struct os_task *prev, struct os_task *next)
+{
+    uint32_t now;
+    uint32_t slice;
+
+    now = os_cputime_get32();
+    if (prev != NULL) {
+        slice = now - os_sched_prof_last_sw;
+        prev->t_prof.tp_run_time += slice;
+        if (slice > prev->t_prof.tp_slice_max) {
+            prev->t_prof.tp_slice_max = slice;
+        }
+        if (prev->t_state == OS_TASK_READY) {
+            prev->t_prof.tp_ready_at = now;
+        }
+    }
+    os_sched_prof_lat(&next->t_prof, now - next->t_prof.tp_ready_at);
+    os_sched_prof_last_sw = now;
+}
+
+void
+os_sched_prof_restart(uint32_t now)
+{
+    os_sched_prof_last_sw = now;
+}
+#endif
+
 void
 os_sched_ctx_sw_hook(struct os_task *next_t)
 {
@@ -82,6 +501,11 @@ os_sched_ctx_sw_hook(struct os_task *next_t)
     for (i = 0; i < MYNEWT_VAL(OS_CTX_SW_STACK_GUARD); i++) {
         assert(top[i] == OS_STACK_PATTERN);
     }
+#endif
+#if MYNEWT_VAL(OS_TASK_PROF)
+    if (next_t != g_current_task) {
+        os_sched_prof_switch(g_current_task, next_t);
+    }
 #endif
     next_t->t_ctx_sw_cnt++;
     g_current_task->t_run_time += g_os_time - g_os_last_ctx_sw_time;
@@ -141,17 +565,22 @@ os_sched(struct os_task *next_t)
 int
 os_sched_sleep(struct os_task *t, os_time_t nticks)
 {
+#if !MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
     struct os_task *entry;
 
     entry = NULL;
+#endif
 
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
         t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
         TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
     } else {
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+        os_sched_sleep_heap_insert(t);
+#else
         TAILQ_FOREACH(entry, &g_os_sleep_list, t_os_list) {
             if ((entry->t_flags & OS_TASK_FLAG_NO_TIMEOUT) ||
                     OS_TIME_TICK_GT(entry->t_next_wakeup, t->t_next_wakeup)) {
@@ -163,6 +592,7 @@ os_sched_sleep(struct os_task *t, os_time_t nticks)
         } else {
             TAILQ_INSERT_TAIL(&g_os_sleep_list, t, t_os_list);
         }
+#endif
     }
 
     os_trace_task_stop_ready(t, OS_TASK_SLEEP);
@@ -187,9 +617,9 @@ os_sched_remove(struct os_task *t)
 {
 
     if (t->t_state == OS_TASK_SLEEP) {
-        TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+        os_sched_sleep_list_remove(t);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -229,10 +659,13 @@ os_sched_wakeup(struct os_task *t)
     }
 
     /* Remove task from sleep list */
+    os_sched_sleep_list_remove(t);
     t->t_state = OS_TASK_READY;
     t->t_next_wakeup = 0;
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+    t->t_slack = 0;
+#endif
     t->t_flags &= ~OS_TASK_FLAG_NO_TIMEOUT;
-    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     os_sched_insert(t);
 
     os_trace_task_start_ready(t);
@@ -253,17 +686,37 @@ void
 os_sched_os_timer_exp(void)
 {
     struct os_task *t;
+#if !MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
     struct os_task *next;
+#endif
     os_time_t now;
     os_sr_t sr;
+#if MYNEWT_VAL(OS_SCHED_STATS)
+    uint32_t start;
+    uint32_t elapsed;
+    uint32_t wakeups;
+#endif
 
     now = os_time_get();
 
     OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_SCHED_STATS)
+    start = os_cputime_get32();
+    wakeups = 0;
+#endif
 
     /*
      * Wakeup any tasks that have their sleep timer expired
      */
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    while ((t = os_sched_sleep_heap) != NULL &&
+           OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
+        os_sched_wakeup(t);
+#if MYNEWT_VAL(OS_SCHED_STATS)
+        wakeups++;
+#endif
+    }
+#else
     t = TAILQ_FIRST(&g_os_sleep_list);
     while (t) {
         /* If task waiting forever, do not check next wakeup time */
@@ -273,32 +726,80 @@ os_sched_os_timer_exp(void)
         next = TAILQ_NEXT(t, t_os_list);
         if (OS_TIME_TICK_GEQ(now, t->t_next_wakeup)) {
             os_sched_wakeup(t);
+#if MYNEWT_VAL(OS_SCHED_STATS)
+            wakeups++;
+#endif
         } else {
             break;
         }
         t = next;
     }
+#endif
 
+#if MYNEWT_VAL(OS_SCHED_STATS)
+    elapsed = os_cputime_get32() - start;
+    if (elapsed > os_sched_tick_crit_max) {
+        os_sched_tick_crit_max = elapsed;
+        STATS_SET(g_os_sched_stats, tick_crit_max, elapsed);
+    }
+    STATS_INCN(g_os_sched_stats, tick_wakeups, wakeups);
+#endif
     OS_EXIT_CRITICAL(sr);
 }
 
+#if MYNEWT_VAL(OS_TIMER_SLACK) && !MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+/*
+ * Returns the earliest deadline (wakeup time plus slack) of the sleeping
+ * tasks which are due before it, starting at the head of the sleep list.
+ */
+static os_time_t
+os_sched_sleep_deadline(struct os_task *t)
+{
+    os_time_t deadline;
+
+    deadline = t->t_next_wakeup + t->t_slack;
+    while ((t = TAILQ_NEXT(t, t_os_list)) != NULL &&
+           !(t->t_flags & OS_TASK_FLAG_NO_TIMEOUT) &&
+           OS_TIME_TICK_LT(t->t_next_wakeup, deadline)) {
+        if (OS_TIME_TICK_LT(t->t_next_wakeup + t->t_slack, deadline)) {
+            deadline = t->t_next_wakeup + t->t_slack;
+        }
+    }
+
+    return deadline;
+}
+#endif
+
 /*
  * Return the number of ticks until the first sleep timer expires.If there are
- * no such tasks then return OS_TIMEOUT_NEVER instead.
+ * no such tasks then return OS_TIMEOUT_NEVER instead.  With OS_TIMER_SLACK
+ * the latest wakeup which keeps every task within its slack is returned.
  */
 os_time_t
 os_sched_wakeup_ticks(os_time_t now)
 {
     os_time_t rt;
+    os_time_t wakeup;
     struct os_task *t;
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    t = os_sched_sleep_heap;
+#else
     t = TAILQ_FIRST(&g_os_sleep_list);
+#endif
     if (t == NULL || (t->t_flags & OS_TASK_FLAG_NO_TIMEOUT)) {
-        rt = OS_TIMEOUT_NEVER;
-    } else if (OS_TIME_TICK_GEQ(t->t_next_wakeup, now)) {
-        rt = t->t_next_wakeup - now;
+        return OS_TIMEOUT_NEVER;
+    }
+
+#if MYNEWT_VAL(OS_TIMER_SLACK) && !MYNEWT_VAL(OS_SCHED_SLEEP_HEAP)
+    wakeup = os_sched_sleep_deadline(t);
+#else
+    wakeup = t->t_next_wakeup;
+#endif
+    if (OS_TIME_TICK_GEQ(wakeup, now)) {
+        rt = wakeup - now;
     } else {
         rt = 0;     /* wakeup time was in the past */
     }
@@ -339,7 +840,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
-        os_sched_insert(t);
+        os_sched_run_list_remove(t);
+        os_sched_run_list_insert(t);
     }
 }
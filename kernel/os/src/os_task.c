@@ -26,6 +26,14 @@ uint8_t g_task_id;
 
 struct os_task_stailq g_os_task_list;
 
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+/* Position of the idle task's stack scan: task and offset from the bottom
+ * of its stack, in os_stack_t units.
+ */
+static struct os_task *os_task_scan_task;
+static uint16_t os_task_scan_off;
+#endif
+
 static void
 _clear_stack(os_stack_t *stack_bottom, int size)
 {
@@ -97,6 +105,9 @@ os_task_init(struct os_task *t, const char *name, os_task_func_t func,
     t->t_stacksize = stack_size;
     t->t_stackptr = os_arch_task_stack_init(t, t->t_stacktop,
             t->t_stacksize);
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+    t->t_stack_hwm = t->t_stacktop - t->t_stackptr;
+#endif
 
     STAILQ_FOREACH(task, &g_os_task_list, t_os_task_list) {
         assert(t->t_prio != task->t_prio);
@@ -151,7 +162,8 @@ os_task_remove(struct os_task *t)
      * Disallow suspending tasks which are waiting on a lock
      */
     if (t->t_flags & (OS_TASK_FLAG_SEM_WAIT | OS_TASK_FLAG_MUTEX_WAIT |
-                                               OS_TASK_FLAG_EVQ_WAIT)) {
+                      OS_TASK_FLAG_EVQ_WAIT | OS_TASK_FLAG_RWLOCK_RD_WAIT |
+                      OS_TASK_FLAG_RWLOCK_WR_WAIT)) {
         return OS_EBUSY;
     }
 
@@ -164,6 +176,11 @@ os_task_remove(struct os_task *t)
 
     OS_ENTER_CRITICAL(sr);
     rc = os_sched_remove(t);
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+    if (os_task_scan_task == t) {
+        os_task_scan_task = NULL;
+    }
+#endif
     OS_EXIT_CRITICAL(sr);
     return rc;
 }
@@ -204,6 +221,9 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
 
     oti->oti_stkusage = (uint16_t) (next->t_stacktop - bottom);
     oti->oti_stksize = next->t_stacksize;
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+    oti->oti_stkhwm = next->t_stack_hwm;
+#endif
     oti->oti_cswcnt = next->t_ctx_sw_cnt;
     oti->oti_runtime = next->t_run_time;
     oti->oti_last_checkin = next->t_sanity_check.sc_checkin_last;
@@ -214,3 +234,80 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
     return (next);
 }
 
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+/**
+ * Called by the idle task to check the next OS_TASK_STACK_WATERMARK_WORDS
+ * words of the stack scan.  The scan visits the tasks in turn and checks
+ * the part of each stack below its high-water mark, from the bottom up, for
+ * words which no longer hold the fill pattern.
+ */
+void
+os_task_stack_scan(void)
+{
+    struct os_task *t;
+    os_stack_t *bottom;
+    uint16_t end;
+    os_sr_t sr;
+    int n;
+
+    OS_ENTER_CRITICAL(sr);
+
+    t = os_task_scan_task;
+    if (t == NULL) {
+        t = STAILQ_FIRST(&g_os_task_list);
+        os_task_scan_off = 0;
+    }
+
+    if (t != NULL) {
+        bottom = t->t_stacktop - t->t_stacksize;
+        end = t->t_stacksize - t->t_stack_hwm;
+        for (n = 0; n < MYNEWT_VAL(OS_TASK_STACK_WATERMARK_WORDS) &&
+                    os_task_scan_off < end; n++) {
+            if (bottom[os_task_scan_off] != OS_STACK_PATTERN) {
+                t->t_stack_hwm = t->t_stacksize - os_task_scan_off;
+                end = os_task_scan_off;
+                break;
+            }
+            os_task_scan_off++;
+        }
+
+        if (os_task_scan_off >= end) {
+            /* Done with this task's stack; move on to the next one. */
+            t = STAILQ_NEXT(t, t_os_task_list);
+            os_task_scan_off = 0;
+        }
+    }
+    os_task_scan_task = t;
+
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
+#if MYNEWT_VAL(OS_TASK_PROF)
+void
+os_task_prof_get(const struct os_task *t, struct os_task_prof *tp)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *tp = t->t_prof;
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+os_task_prof_reset(void)
+{
+    struct os_task *t;
+    os_sr_t sr;
+    uint32_t now;
+
+    OS_ENTER_CRITICAL(sr);
+    now = os_cputime_get32();
+    STAILQ_FOREACH(t, &g_os_task_list, t_os_task_list) {
+        memset(&t->t_prof, 0, sizeof(t->t_prof));
+        t->t_prof.tp_ready_at = now;
+    }
+    os_sched_prof_restart(now);
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
@@ -109,11 +109,22 @@ os_time_advance(int ticks)
 void
 os_time_delay(os_time_t osticks)
 {
+    os_time_delay_slack(osticks, 0);
+}
+
+void
+os_time_delay_slack(os_time_t osticks, os_time_t slack)
+{
+    struct os_task *t;
     os_sr_t sr;
 
     if (osticks > 0) {
         OS_ENTER_CRITICAL(sr);
-        os_sched_sleep(os_sched_get_current_task(), (os_time_t)osticks);
+        t = os_sched_get_current_task();
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+        t->t_slack = slack;
+#endif
+        os_sched_sleep(t, (os_time_t)osticks);
         OS_EXIT_CRITICAL(sr);
         os_sched(NULL);
     }
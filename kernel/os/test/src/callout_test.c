@@ -59,6 +59,13 @@ os_stack_t callout_task_stack_listen[CALLOUT_STACK_SIZE];
 
 struct os_callout callout_speak;
 
+/* Declaring variables for callout_slack */
+struct os_task callout_task_struct_slack;
+os_stack_t callout_task_stack_slack[CALLOUT_STACK_SIZE];
+
+struct os_callout callout_slack_test[SLACK_SIZE];
+struct os_eventq callout_slack_evq;
+
 /* Global variables to be used by the callout functions */
 int p;
 int q;
@@ -225,13 +232,77 @@ callout_task_stop_listen(void *arg)
 
 }
 
+/*
+ * Expected wakeup with and without OS_TIMER_SLACK.  Without it the slack is
+ * ignored and the earliest callout sets the wakeup.
+ */
+#if MYNEWT_VAL(OS_TIMER_SLACK)
+#define SLACK_WAKEUP(slack, exact)  (slack)
+#else
+#define SLACK_WAKEUP(slack, exact)  (exact)
+#endif
+
+/* This is the task for the callout_slack test case */
+void
+callout_task_slack(void *arg)
+{
+    struct os_event *event;
+    os_time_t now;
+    os_time_t tm;
+    os_sr_t sr;
+    int k;
+
+    os_callout_set_slack(&callout_slack_test[0], 10);
+    os_callout_set_slack(&callout_slack_test[1], 10);
+
+    OS_ENTER_CRITICAL(sr);
+    now = os_time_get();
+
+    /* Windows [10, 20] and [15, 25] overlap; a wakeup at 20 serves both */
+    os_callout_reset(&callout_slack_test[0], 10);
+    os_callout_reset(&callout_slack_test[1], 15);
+    tm = os_callout_wakeup_ticks(now);
+    TEST_ASSERT(tm == SLACK_WAKEUP(20, 10));
+
+    /* A callout which is only due after that does not matter */
+    os_callout_reset(&callout_slack_test[2], 30);
+    tm = os_callout_wakeup_ticks(now);
+    TEST_ASSERT(tm == SLACK_WAKEUP(20, 10));
+
+    /* A callout without slack inside the window pulls the wakeup in */
+    os_callout_reset(&callout_slack_test[2], 12);
+    tm = os_callout_wakeup_ticks(now);
+    TEST_ASSERT(tm == SLACK_WAKEUP(12, 10));
+
+    os_callout_stop(&callout_slack_test[2]);
+    OS_EXIT_CRITICAL(sr);
+
+    /* Both remaining callouts still expire */
+    for (k = 0; k < 2; k++) {
+        event = os_eventq_get(&callout_slack_evq);
+        TEST_ASSERT(event->ev_cb == my_callout);
+    }
+    for (k = 0; k < SLACK_SIZE; k++) {
+        TEST_ASSERT(!os_callout_queued(&callout_slack_test[k]));
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    tm = os_callout_wakeup_ticks(os_time_get());
+    TEST_ASSERT(tm == OS_TIMEOUT_NEVER);
+    OS_EXIT_CRITICAL(sr);
+
+    os_test_restart();
+}
+
 TEST_CASE_DECL(callout_test_speak)
 TEST_CASE_DECL(callout_test_stop)
 TEST_CASE_DECL(callout_test)
+TEST_CASE_DECL(callout_test_slack)
 
 TEST_SUITE(os_callout_test_suite)
 {
     callout_test();
     callout_test_stop();
     callout_test_speak();
+    callout_test_slack();
 }
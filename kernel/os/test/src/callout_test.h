@@ -73,6 +73,14 @@ extern os_stack_t callout_task_stack_listen[CALLOUT_STACK_SIZE];
 extern struct os_callout callout_speak;
 extern struct os_callout callout_test_c;
 
+/* Declaring variables for callout_slack */
+#define SLACK_CALLOUT_TASK_PRIO         (INITIAL_CALLOUT_TASK_PRIO + 6)
+#define SLACK_SIZE    (3)
+extern struct os_task callout_task_struct_slack;
+extern os_stack_t callout_task_stack_slack[CALLOUT_STACK_SIZE];
+extern struct os_callout callout_slack_test[SLACK_SIZE];
+extern struct os_eventq callout_slack_evq;
+
 /* Global variables to be used by the callout functions */
 extern int p;
 extern int q;
@@ -87,6 +95,7 @@ void callout_task_stop_send(void *arg);
 void callout_task_stop_receive(void *arg);
 void callout_task_stop_speak(void *arg);
 void callout_task_stop_listen(void *arg);
+void callout_task_slack(void *arg);
 
 #ifdef __cplusplus
 }
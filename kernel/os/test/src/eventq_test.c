@@ -71,11 +71,17 @@ os_stack_t eventq_task_stack_poll_single_s[POLL_STACK_SIZE];
 struct os_task eventq_task_poll_single_r;
 os_stack_t eventq_task_stack_poll_single_r[POLL_STACK_SIZE];
 
+/* Define the task stack for the eventq_task_batch */
+struct os_task eventq_task_batch;
+os_stack_t eventq_task_stack_batch[POLL_STACK_SIZE];
+
 TEST_CASE_DECL(event_test_sr)
 TEST_CASE_DECL(event_test_poll_sr)
 TEST_CASE_DECL(event_test_poll_timeout_sr)
 TEST_CASE_DECL(event_test_poll_single_sr)
 TEST_CASE_DECL(event_test_poll_0timo)
+TEST_CASE_DECL(event_test_ring)
+TEST_CASE_DECL(event_test_batch)
 
 /* This is the task function  to send data */
 void
@@ -252,6 +258,125 @@ eventq_task_poll_single_receive(void *arg)
     os_test_restart();
 }
 
+static int event_test_batch_cnt;
+static uint16_t event_test_batch_coalesced;
+
+static void
+event_test_batch_cb(struct os_event *ev)
+{
+    event_test_batch_cnt++;
+    event_test_batch_coalesced = ev->ev_coalesced;
+}
+
+/* Removes the event passed as argument from the queue */
+static void
+event_test_batch_remove_cb(struct os_event *ev)
+{
+    event_test_batch_cnt++;
+    os_eventq_remove(&my_eventq, ev->ev_arg);
+}
+
+/*
+ * Stops, reinitializes and requeues the event passed as argument, like
+ * os_callout_stop() followed by os_callout_init() and os_callout_reset().
+ */
+static void
+event_test_batch_reinit_cb(struct os_event *ev)
+{
+    struct os_event *other;
+
+    event_test_batch_cnt++;
+    other = ev->ev_arg;
+    os_eventq_remove(&my_eventq, other);
+    memset(other, 0, sizeof *other);
+    other->ev_cb = event_test_batch_cb;
+    os_eventq_put(&my_eventq, other);
+}
+
+/*
+ * Tests os_eventq_run_batch() and event coalescing.  Events are queued
+ * before each batch is run, so os_eventq_run_batch() never blocks.
+ */
+void
+eventq_task_batch_handler(void *arg)
+{
+    struct os_event ev[4];
+    int rc;
+    int i;
+
+    memset(ev, 0, sizeof ev);
+    for (i = 0; i < 4; i++) {
+        ev[i].ev_cb = event_test_batch_cb;
+    }
+
+    /* Batch limit is honored. */
+    for (i = 0; i < 4; i++) {
+        os_eventq_put(&my_eventq, &ev[i]);
+    }
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&my_eventq, 3);
+    TEST_ASSERT(rc == 3);
+    TEST_ASSERT(event_test_batch_cnt == 3);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&ev[2]));
+    TEST_ASSERT(OS_EVENT_QUEUED(&ev[3]));
+
+    rc = os_eventq_run_batch(&my_eventq, 3);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(event_test_batch_cnt == 4);
+
+    /* An event removed after being taken off the queue is not dispatched. */
+    ev[0].ev_cb = event_test_batch_remove_cb;
+    ev[0].ev_arg = &ev[2];
+    os_eventq_put(&my_eventq, &ev[1]);
+    os_eventq_put(&my_eventq, &ev[0]);
+    os_eventq_put(&my_eventq, &ev[2]);
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&my_eventq, 4);
+    TEST_ASSERT(rc == 2);
+    TEST_ASSERT(event_test_batch_cnt == 2);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&ev[2]));
+
+    /*
+     * An event reinitialized and requeued by an earlier callback does not
+     * cut off the events queued behind it, and runs after them.
+     */
+    ev[0].ev_cb = event_test_batch_reinit_cb;
+    ev[0].ev_arg = &ev[1];
+    os_eventq_put(&my_eventq, &ev[0]);
+    os_eventq_put(&my_eventq, &ev[1]);
+    os_eventq_put(&my_eventq, &ev[2]);
+    os_eventq_put(&my_eventq, &ev[3]);
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&my_eventq, 8);
+    TEST_ASSERT(rc == 4);
+    TEST_ASSERT(event_test_batch_cnt == 4);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(!OS_EVENT_QUEUED(&ev[i]));
+    }
+    ev[0].ev_cb = event_test_batch_cb;
+
+    /* Repeated posts of a coalescing event are counted. */
+    ev[1].ev_flags = OS_EVENT_F_COALESCE;
+    for (i = 0; i < 3; i++) {
+        os_eventq_put(&my_eventq, &ev[1]);
+    }
+    event_test_batch_cnt = 0;
+    rc = os_eventq_run_batch(&my_eventq, 4);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(event_test_batch_cnt == 1);
+    TEST_ASSERT(event_test_batch_coalesced == 2);
+
+    /* Non-coalescing events drop repeated posts without counting. */
+    os_eventq_put(&my_eventq, &ev[0]);
+    os_eventq_put(&my_eventq, &ev[0]);
+    rc = os_eventq_run_batch(&my_eventq, 4);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(event_test_batch_coalesced == 0);
+
+    /* Finishes the test when OS has been started */
+    os_test_restart();
+}
+
 TEST_SUITE(os_eventq_test_suite)
 {
     event_test_sr();
@@ -259,4 +384,6 @@ TEST_SUITE(os_eventq_test_suite)
     event_test_poll_timeout_sr();
     event_test_poll_single_sr();
     event_test_poll_0timo();
+    event_test_ring();
+    event_test_batch();
 }
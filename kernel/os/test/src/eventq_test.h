@@ -94,10 +94,16 @@ extern os_stack_t eventq_task_stack_poll_single_s[POLL_STACK_SIZE];
 extern struct os_task eventq_task_poll_single_r;
 extern os_stack_t eventq_task_stack_poll_single_r[POLL_STACK_SIZE];
 
+/* Define the task stack for the eventq_task_batch */
+#define BATCH_TASK_PRIO                 (INITIAL_EVENTQ_TASK_PRIO + 9)
+extern struct os_task eventq_task_batch;
+extern os_stack_t eventq_task_stack_batch[POLL_STACK_SIZE];
+
 void eventq_task_send(void *arg);
 void eventq_task_receive(void *arg);
 void eventq_task_poll_send(void *arg);
 void eventq_task_poll_receive(void *arg);
+void eventq_task_batch_handler(void *arg);
 void eventq_task_poll_timeout_send(void *arg);
 void eventq_task_poll_timeout_receive(void *arg);
 void eventq_task_poll_single_send(void *arg);
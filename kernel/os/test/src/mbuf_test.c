@@ -102,6 +102,10 @@ TEST_CASE_DECL(os_mbuf_test_extend)
 TEST_CASE_DECL(os_mbuf_test_adj)
 TEST_CASE_DECL(os_mbuf_test_get_pkthdr)
 TEST_CASE_DECL(os_mbuf_test_widen)
+TEST_CASE_DECL(os_mbuf_test_iter)
+TEST_CASE_DECL(os_mbuf_test_msys)
+TEST_CASE_DECL(os_mbuf_test_bulk)
+TEST_CASE_DECL(os_mbuf_test_clone)
 
 TEST_SUITE(os_mbuf_test_suite)
 {
@@ -113,4 +117,8 @@ TEST_SUITE(os_mbuf_test_suite)
     os_mbuf_test_adj();
     os_mbuf_test_get_pkthdr();
     os_mbuf_test_widen();
+    os_mbuf_test_iter();
+    os_mbuf_test_msys();
+    os_mbuf_test_bulk();
+    os_mbuf_test_clone();
 }
@@ -46,6 +46,9 @@ mempool_test_get_pool_size(int num_blocks, int block_size)
 {
     int mem_pool_size;
 
+    /* Account for the guard area and tracking record, if any. */
+    block_size = OS_MEMPOOL_BLOCK_SZ(block_size);
+
 #if OS_CFG_ALIGNMENT == OS_CFG_ALIGN_4
     mem_pool_size = (num_blocks * ((block_size + 3)/4) * sizeof(os_membuf_t));
 #else
@@ -58,6 +61,9 @@ mempool_test_get_pool_size(int num_blocks, int block_size)
 TEST_CASE_DECL(os_mempool_test_case)
 TEST_CASE_DECL(os_mempool_test_ext_basic)
 TEST_CASE_DECL(os_mempool_test_ext_nested)
+TEST_CASE_DECL(os_mempool_test_malloc_slab)
+TEST_CASE_DECL(os_mempool_test_stress)
+TEST_CASE_DECL(os_mempool_test_track)
 
 TEST_SUITE(os_mempool_test_suite)
 {
@@ -69,6 +75,9 @@ TEST_SUITE(os_mempool_test_suite)
     os_mempool_test_case();
     os_mempool_test_ext_basic();
     os_mempool_test_ext_nested();
+    os_mempool_test_malloc_slab();
+    os_mempool_test_stress();
+    os_mempool_test_track();
 
     free(TstMembuf);
     TstMembufSz = 0;
@@ -66,6 +66,7 @@ os_test_all(void)
 {
     os_mempool_test_suite();
     os_mutex_test_suite();
+    os_rwlock_test_suite();
     os_sem_test_suite();
     os_mbuf_test_suite();
     os_eventq_test_suite();
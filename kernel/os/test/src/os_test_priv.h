@@ -31,6 +31,7 @@
 #include "mbuf_test.h"
 #include "mempool_test.h"
 #include "mutex_test.h"
+#include "rwlock_test.h"
 #include "sem_test.h"
 
 #ifdef __cplusplus
@@ -54,6 +55,7 @@ int os_mbuf_test_suite(void);
 int os_sem_test_suite(void);
 int os_eventq_test_suite(void);
 int os_callout_test_suite(void);
+int os_rwlock_test_suite(void);
 
 #ifdef __cplusplus
 }
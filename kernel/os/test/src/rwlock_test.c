@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+struct os_rwlock g_rwlock1;
+volatile int g_rwlock_task2_val;
+volatile int g_rwlock_task3_val;
+struct os_task *g_rwlock_task3;
+
+/*
+ * The test task itself is the highest priority task of each case and plays
+ * "task 1"; these are its lower priority partners.
+ */
+
+/*
+ * Test 1: task 1 holds a read lock, task 2 waits to write and task 3 tries
+ * to read after it.  Task 2 must get the lock before task 3.
+ */
+void
+rwlock_test_1_task2_handler(void *arg)
+{
+    os_error_t err;
+
+    os_time_delay(1);
+
+    err = os_rwlock_write_pend(&g_rwlock1, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(g_rwlock_task3_val == 0);
+
+    os_time_delay(OS_TICKS_PER_SEC / 10);
+
+    g_rwlock_task2_val = 1;
+    err = os_rwlock_write_release(&g_rwlock1);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+void
+rwlock_test_1_task3_handler(void *arg)
+{
+    os_error_t err;
+
+    os_time_delay(2);
+
+    /* Lock is only read-held, but a writer is waiting */
+    err = os_rwlock_read_pend(&g_rwlock1, 0);
+    TEST_ASSERT(err == OS_TIMEOUT, "err=%d", err);
+
+    err = os_rwlock_read_pend(&g_rwlock1, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(g_rwlock_task2_val == 1);
+
+    g_rwlock_task3_val = 1;
+    err = os_rwlock_read_release(&g_rwlock1);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+/*
+ * Test 2: task 3 holds a read lock and task 1 waits to write, lending task 3
+ * its priority.  Task 2 queues to read behind task 1 and gets in when task 1
+ * times out.
+ */
+void
+rwlock_test_2_task2_handler(void *arg)
+{
+    os_error_t err;
+
+    os_time_delay(2);
+
+    TEST_ASSERT(os_sched_get_current_task()->t_prio == TASK2_PRIO);
+    TEST_ASSERT(g_rwlock_task3->t_prio == TASK1_PRIO,
+                "prio=%u", g_rwlock_task3->t_prio);
+
+    /* Only task 3 reads; task 2 can't release its lock */
+    err = os_rwlock_read_release(&g_rwlock1);
+    TEST_ASSERT(err == OS_BAD_MUTEX, "err=%d", err);
+    TEST_ASSERT((g_rwlock1.rw_state & OS_RWLOCK_READERS_MASK) == 1);
+
+    err = os_rwlock_read_pend(&g_rwlock1, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(g_rwlock_task3_val == 0);
+    TEST_ASSERT((g_rwlock1.rw_state & OS_RWLOCK_READERS_MASK) == 2);
+
+    g_rwlock_task2_val = 1;
+    err = os_rwlock_read_release(&g_rwlock1);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+void
+rwlock_test_2_task3_handler(void *arg)
+{
+    os_error_t err;
+
+    g_rwlock_task3 = os_sched_get_current_task();
+
+    err = os_rwlock_read_pend(&g_rwlock1, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+
+    os_time_delay(OS_TICKS_PER_SEC / 5);
+
+    err = os_rwlock_read_release(&g_rwlock1);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(g_rwlock_task3->t_prio == TASK3_PRIO);
+
+    g_rwlock_task3_val = 1;
+
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+TEST_CASE_DECL(os_rwlock_test_basic)
+TEST_CASE_DECL(os_rwlock_test_case_1)
+TEST_CASE_DECL(os_rwlock_test_case_2)
+
+TEST_SUITE(os_rwlock_test_suite)
+{
+    os_rwlock_test_basic();
+    os_rwlock_test_case_1();
+    os_rwlock_test_case_2();
+}
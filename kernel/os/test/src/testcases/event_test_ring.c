@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/**
+ * Tests pushing events to a ring attached to an event queue.  Events are
+ * read back with a timeout of 0, so this works without starting the OS.
+ */
+TEST_CASE(event_test_ring)
+{
+#if MYNEWT_VAL(OS_EVENTQ_RING)
+    struct os_event *ring_events[4];
+    struct os_eventq_ring ring;
+    struct os_eventq *eventqs[2];
+    struct os_event *evp;
+    struct os_event ev[5];
+    int rc;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        os_eventq_init(&multi_eventq[i]);
+        eventqs[i] = &multi_eventq[i];
+    }
+    memset(ev, 0, sizeof ev);
+
+    /* Size must be a power of two. */
+    rc = os_eventq_ring_init(eventqs[1], &ring, ring_events, 3);
+    TEST_ASSERT(rc == OS_EINVAL);
+    rc = os_eventq_ring_init(eventqs[1], &ring, ring_events, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    evp = os_eventq_poll(eventqs, 2, 0);
+    TEST_ASSERT(evp == NULL);
+
+    /* Fill the ring. */
+    for (i = 0; i < 4; i++) {
+        rc = os_eventq_ring_put(eventqs[1], &ev[i]);
+        TEST_ASSERT(rc == 0);
+    }
+    rc = os_eventq_ring_put(eventqs[1], &ev[4]);
+    TEST_ASSERT(rc == OS_ENOMEM);
+
+    /* Events on the queue itself are returned before ring events. */
+    os_eventq_put(eventqs[1], &ev[4]);
+    evp = os_eventq_poll(eventqs, 2, 0);
+    TEST_ASSERT(evp == &ev[4]);
+
+    /* Ring events come out in order. */
+    for (i = 0; i < 2; i++) {
+        evp = os_eventq_poll(eventqs, 2, 0);
+        TEST_ASSERT(evp == &ev[i]);
+    }
+
+    /* Wrap around. */
+    rc = os_eventq_ring_put(eventqs[1], &ev[0]);
+    TEST_ASSERT(rc == 0);
+    for (i = 2; i < 4; i++) {
+        evp = os_eventq_get_no_wait(eventqs[1]);
+        TEST_ASSERT(evp == &ev[i]);
+    }
+    evp = os_eventq_get_no_wait(eventqs[1]);
+    TEST_ASSERT(evp == &ev[0]);
+
+    evp = os_eventq_poll(eventqs, 2, 0);
+    TEST_ASSERT(evp == NULL);
+#endif
+}
@@ -0,0 +1,36 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/* Test case of callouts with slack */
+TEST_CASE(callout_test_slack)
+{
+    int k;
+
+    os_task_init(&callout_task_struct_slack, "callout_task_slack",
+        callout_task_slack, NULL, SLACK_CALLOUT_TASK_PRIO, OS_WAIT_FOREVER,
+        callout_task_stack_slack, CALLOUT_STACK_SIZE);
+
+    os_eventq_init(&callout_slack_evq);
+
+    for (k = 0; k < SLACK_SIZE; k++) {
+        os_callout_init(&callout_slack_test[k], &callout_slack_evq,
+            my_callout, NULL);
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static int
+omtb_chain_cnt(const struct os_mbuf *om)
+{
+    int cnt;
+
+    for (cnt = 0; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        cnt++;
+    }
+
+    return cnt;
+}
+
+TEST_CASE(os_mbuf_test_bulk)
+{
+    void *blocks[MBUF_TEST_POOL_BUF_COUNT + 1];
+    struct os_mempool *mp;
+    struct os_mbuf *om;
+    struct os_mbuf *dup;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+    mp = &os_mbuf_mempool;
+
+    /*** Mempool batches are all or nothing. */
+    rc = os_memblock_get_n(mp, blocks, MBUF_TEST_POOL_BUF_COUNT + 1);
+    TEST_ASSERT(rc == OS_ENOMEM);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+
+    rc = os_memblock_get_n(mp, blocks, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 4);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(os_memblock_from(mp, blocks[i]));
+    }
+
+    rc = os_memblock_put_n(mp, blocks, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+    TEST_ASSERT(os_mempool_is_sane(mp));
+
+    /*** Chain allocation. */
+    om = os_mbuf_get_chain(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(omtb_chain_cnt(om) == 1);
+    os_mbuf_free_chain(om);
+
+    om = os_mbuf_get_chain(&os_mbuf_pool, os_mbuf_pool.omp_databuf_len * 2 + 1);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(omtb_chain_cnt(om) == 3);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 3);
+    os_mbuf_test_misc_assert_sane(om, NULL, 0, 0, 0);
+    os_mbuf_free_chain(om);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+
+    om = os_mbuf_get_chain(&os_mbuf_pool,
+                           os_mbuf_pool.omp_databuf_len *
+                           MBUF_TEST_POOL_BUF_COUNT + 1);
+    TEST_ASSERT(om == NULL);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+
+    /*** Append and dup build their chains in bulk. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 1000);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 1000);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 1000) == 0);
+
+    dup = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(omtb_chain_cnt(dup) == omtb_chain_cnt(om));
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 1000);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 0, os_mbuf_test_data, 1000) == 0);
+
+    /* Not enough blocks for another copy. */
+    TEST_ASSERT(os_mbuf_dup(om) == NULL);
+    TEST_ASSERT(mp->mp_num_free ==
+                MBUF_TEST_POOL_BUF_COUNT - 2 * omtb_chain_cnt(om));
+
+    os_mbuf_free_chain(dup);
+    os_mbuf_free_chain(om);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+
+    /*** Partial append when the pool runs dry. */
+    om = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    for (i = 0; i < 2; i++) {
+        rc = os_mbuf_append(om, os_mbuf_test_data, MBUF_TEST_DATA_LEN);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(mp->mp_num_free == 1);
+
+    /* Too few blocks for a bulk allocation; the last one is still used. */
+    rc = os_mbuf_append(om, os_mbuf_test_data, MBUF_TEST_DATA_LEN);
+    TEST_ASSERT(rc == OS_ENOMEM);
+    TEST_ASSERT(mp->mp_num_free == 0);
+    os_mbuf_free_chain(om);
+    TEST_ASSERT(mp->mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_mbuf_test_clone)
+{
+#if MYNEWT_VAL(OS_MBUF_CLONE)
+    static const uint8_t patch[2] = { 0xff, 0xfe };
+    struct os_mbuf *clone2;
+    struct os_mbuf *clone;
+    struct os_mbuf *om;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 400);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(SLIST_NEXT(om, om_next) != NULL);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 2);
+
+    /*** The clone refers to the original data. */
+    clone = os_mbuf_clone(om);
+    TEST_ASSERT_FATAL(clone != NULL);
+    TEST_ASSERT(clone != om);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 4);
+    TEST_ASSERT(OS_MBUF_PKTLEN(clone) == 400);
+    TEST_ASSERT(clone->om_data == om->om_data);
+    TEST_ASSERT(clone->om_shared == om);
+    TEST_ASSERT(os_mbuf_cmpf(clone, 0, os_mbuf_test_data, 400) == 0);
+
+    /* Shared data can't grow in place. */
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(clone) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(SLIST_NEXT(clone, om_next)) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(SLIST_NEXT(om, om_next)) == 0);
+
+    /* A clone of a clone refers to the mbuf holding the data. */
+    clone2 = os_mbuf_clone(clone);
+    TEST_ASSERT_FATAL(clone2 != NULL);
+    TEST_ASSERT(clone2->om_shared == om);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 6);
+
+    /*** Freeing the original keeps its blocks while the clones use them. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 6);
+    TEST_ASSERT(os_mbuf_cmpf(clone, 0, os_mbuf_test_data, 400) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(clone2, 0, os_mbuf_test_data, 400) == 0);
+
+    /*** Writing to a clone copies the data into the clone's own buffer. */
+    rc = os_mbuf_copyinto(clone, 10, patch, sizeof patch);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(clone->om_shared == NULL);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 6);
+    TEST_ASSERT(OS_MBUF_PKTLEN(clone) == 400);
+    TEST_ASSERT(os_mbuf_cmpf(clone, 0, os_mbuf_test_data, 10) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(clone, 10, patch, sizeof patch) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(clone, 12, os_mbuf_test_data + 12, 388) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(clone2, 0, os_mbuf_test_data, 400) == 0);
+
+    /* The second clone was the last user of the original head. */
+    rc = os_mbuf_free_chain(clone2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 3);
+
+    rc = os_mbuf_free_chain(clone);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+
+    /*** Writing to a cloned mbuf moves its data to a new block. */
+    om = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    clone = os_mbuf_clone(om);
+    TEST_ASSERT_FATAL(clone != NULL);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 2);
+
+    rc = os_mbuf_copyinto(om, 0, patch, sizeof patch);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(om->om_shared != NULL);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 3);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, patch, sizeof patch) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(om, 2, os_mbuf_test_data + 2, 98) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(clone, 0, os_mbuf_test_data, 100) == 0);
+
+    rc = os_mbuf_free(clone);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 2);
+
+    rc = os_mbuf_free(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+#endif
+}
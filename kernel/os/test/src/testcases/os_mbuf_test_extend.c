@@ -21,6 +21,7 @@
 TEST_CASE(os_mbuf_test_extend)
 {
     struct os_mbuf *om;
+    uint16_t room;
     void *v;
 
     os_mbuf_test_setup();
@@ -29,7 +30,10 @@ TEST_CASE(os_mbuf_test_extend)
     om = os_mbuf_get_pkthdr(&os_mbuf_pool, 10);
     TEST_ASSERT_FATAL(om != NULL);
 
-    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 222);
+    /* Data space left after the 18 bytes of packet header */
+    room = os_mbuf_pool.omp_databuf_len - 18;
+
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == room);
     TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
     os_mbuf_test_misc_assert_sane(om, NULL, 0, 0, 18);
 
@@ -38,7 +42,7 @@ TEST_CASE(os_mbuf_test_extend)
     TEST_ASSERT(v == om->om_data);
     TEST_ASSERT(om->om_len == 20);
 
-    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 202);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == room - 20);
     TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
     os_mbuf_test_misc_assert_sane(om, NULL, 20, 20, 18);
 
@@ -47,27 +51,27 @@ TEST_CASE(os_mbuf_test_extend)
     TEST_ASSERT(v == om->om_data + 20);
     TEST_ASSERT(om->om_len == 120);
 
-    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 102);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == room - 120);
     TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
     os_mbuf_test_misc_assert_sane(om, NULL, 120, 120, 18);
 
-    v = os_mbuf_extend(om, 101);
+    v = os_mbuf_extend(om, room - 121);
     TEST_ASSERT(v != NULL);
     TEST_ASSERT(v == om->om_data + 120);
-    TEST_ASSERT(om->om_len == 221);
+    TEST_ASSERT(om->om_len == room - 1);
 
     TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 1);
     TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
-    os_mbuf_test_misc_assert_sane(om, NULL, 221, 221, 18);
+    os_mbuf_test_misc_assert_sane(om, NULL, room - 1, room - 1, 18);
 
     v = os_mbuf_extend(om, 1);
     TEST_ASSERT(v != NULL);
-    TEST_ASSERT(v == om->om_data + 221);
-    TEST_ASSERT(om->om_len == 222);
+    TEST_ASSERT(v == om->om_data + room - 1);
+    TEST_ASSERT(om->om_len == room);
 
     TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
     TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
-    os_mbuf_test_misc_assert_sane(om, NULL, 222, 222, 18);
+    os_mbuf_test_misc_assert_sane(om, NULL, room, room, 18);
 
     /* Overflow into next buffer. */
     v = os_mbuf_extend(om, 1);
@@ -75,17 +79,17 @@ TEST_CASE(os_mbuf_test_extend)
     TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
 
     TEST_ASSERT(v == SLIST_NEXT(om, om_next)->om_data);
-    TEST_ASSERT(om->om_len == 222);
+    TEST_ASSERT(om->om_len == room);
     TEST_ASSERT(SLIST_NEXT(om, om_next)->om_len == 1);
-    os_mbuf_test_misc_assert_sane(om, NULL, 222, 223, 18);
+    os_mbuf_test_misc_assert_sane(om, NULL, room, room + 1, 18);
 
     /*** Attempt to extend by an amount larger than max buf size fails. */
-    v = os_mbuf_extend(om, 257);
+    v = os_mbuf_extend(om, MBUF_TEST_POOL_BUF_SIZE + 1);
     TEST_ASSERT(v == NULL);
     TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
     TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
 
-    TEST_ASSERT(om->om_len == 222);
+    TEST_ASSERT(om->om_len == room);
     TEST_ASSERT(SLIST_NEXT(om, om_next)->om_len == 1);
-    os_mbuf_test_misc_assert_sane(om, NULL, 222, 223, 18);
+    os_mbuf_test_misc_assert_sane(om, NULL, room, room + 1, 18);
 }
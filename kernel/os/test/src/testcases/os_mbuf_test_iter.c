@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/**
+ * Builds a chain of mbufs holding os_mbuf_test_data[0..total), with each mbuf
+ * holding at most seg_len bytes.
+ */
+static struct os_mbuf *
+omti_chain(int total, int seg_len)
+{
+    struct os_mbuf *head;
+    struct os_mbuf *om;
+    int off;
+    int len;
+    int rc;
+
+    head = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(head != NULL);
+
+    len = min(seg_len, total);
+    rc = os_mbuf_copyinto(head, 0, os_mbuf_test_data, len);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(head->om_len == len);
+
+    for (off = len; off < total; off += len) {
+        om = os_mbuf_get(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+
+        len = min(seg_len, total - off);
+        memcpy(om->om_data, os_mbuf_test_data + off, len);
+        om->om_len = len;
+        os_mbuf_concat(head, om);
+    }
+
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(head) == total);
+    return head;
+}
+
+TEST_CASE(os_mbuf_test_iter)
+{
+    struct os_mbuf_iter it;
+    struct os_iovec iov[4];
+    struct os_mbuf *om;
+    struct os_mbuf *om2;
+    const uint8_t *data;
+    const uint8_t *p;
+    uint8_t buf[32];
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    /* Three mbufs of 10, 10 and 5 bytes. */
+    om = omti_chain(25, 10);
+
+    /*** Invalid offsets. */
+    rc = os_mbuf_iter_init(&it, om, 26);
+    TEST_ASSERT(rc == -1);
+    rc = os_mbuf_iter_init(&it, om, -1);
+    TEST_ASSERT(rc == -1);
+    rc = os_mbuf_iter_init(&it, NULL, 0);
+    TEST_ASSERT(rc == -1);
+    TEST_ASSERT(os_mbuf_iter_seg(&it, &data) == 0);
+
+    /*** Contiguous peek returns a pointer into the mbuf. */
+    rc = os_mbuf_iter_init(&it, om, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_iter_seg(&it, &data) == 8);
+    TEST_ASSERT(data == om->om_data + 2);
+
+    p = os_mbuf_iter_peek(&it, buf, 8);
+    TEST_ASSERT(p == om->om_data + 2);
+
+    /*** Peek across a boundary gathers into the buffer. */
+    p = os_mbuf_iter_peek(&it, buf, 20);
+    TEST_ASSERT(p == buf);
+    TEST_ASSERT(memcmp(buf, os_mbuf_test_data + 2, 20) == 0);
+    TEST_ASSERT(os_mbuf_iter_peek(&it, NULL, 20) == NULL);
+    TEST_ASSERT(os_mbuf_iter_peek(&it, buf, 24) == NULL);
+
+    /*** Advance onto an mbuf boundary lands at the start of the next. */
+    rc = os_mbuf_iter_advance(&it, 8);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(it.omi_om == SLIST_NEXT(om, om_next));
+    TEST_ASSERT(it.omi_off == 0);
+
+    rc = os_mbuf_iter_advance(&it, 13);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_iter_seg(&it, &data) == 2);
+    TEST_ASSERT(*data == os_mbuf_test_data[23]);
+
+    /*** Advance to the end, then past it. */
+    rc = os_mbuf_iter_advance(&it, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_iter_seg(&it, &data) == 0);
+    rc = os_mbuf_iter_advance(&it, 1);
+    TEST_ASSERT(rc == -1);
+
+    /*** Walking the segments visits every byte once. */
+    rc = os_mbuf_iter_init(&it, om, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    i = 0;
+    while ((rc = os_mbuf_iter_seg(&it, &data)) > 0) {
+        TEST_ASSERT(memcmp(data, os_mbuf_test_data + i, rc) == 0);
+        i += rc;
+        os_mbuf_iter_advance(&it, rc);
+    }
+    TEST_ASSERT(i == 25);
+
+    /*** Empty mbufs in the middle of a chain are skipped. */
+    om2 = os_mbuf_get(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om2 != NULL);
+    SLIST_NEXT(om2, om_next) = SLIST_NEXT(om, om_next);
+    SLIST_NEXT(om, om_next) = om2;
+
+    rc = os_mbuf_iter_init(&it, om, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(it.omi_om == SLIST_NEXT(om2, om_next));
+
+    /*** Iovec conversion. */
+    rc = os_mbuf_to_iovec(om, 5, 18, iov, 4);
+    TEST_ASSERT_FATAL(rc == 3);
+    TEST_ASSERT(iov[0].iov_base == om->om_data + 5);
+    TEST_ASSERT(iov[0].iov_len == 5);
+    TEST_ASSERT(iov[1].iov_len == 10);
+    TEST_ASSERT(iov[2].iov_len == 3);
+    TEST_ASSERT(memcmp(iov[2].iov_base, os_mbuf_test_data + 20, 3) == 0);
+
+    rc = os_mbuf_to_iovec(om, 5, 18, iov, 2);
+    TEST_ASSERT(rc == -1);
+    rc = os_mbuf_to_iovec(om, 5, 21, iov, 4);
+    TEST_ASSERT(rc == -1);
+    rc = os_mbuf_to_iovec(om, 25, 0, iov, 4);
+    TEST_ASSERT(rc == 0);
+
+    os_mbuf_free_chain(om);
+}
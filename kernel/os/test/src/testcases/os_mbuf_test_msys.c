@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define OMTM_SMALL_BUF_SIZE     (64)
+#define OMTM_SMALL_BUF_COUNT    (4)
+#define OMTM_LARGE_BUF_SIZE     (256)
+#define OMTM_LARGE_BUF_COUNT    (2)
+
+static os_membuf_t omtm_small_membuf[OS_MEMPOOL_SIZE(OMTM_SMALL_BUF_COUNT,
+                                                     OMTM_SMALL_BUF_SIZE)];
+static os_membuf_t omtm_large_membuf[OS_MEMPOOL_SIZE(OMTM_LARGE_BUF_COUNT,
+                                                     OMTM_LARGE_BUF_SIZE)];
+
+static struct os_mempool omtm_small_mempool;
+static struct os_mempool omtm_large_mempool;
+static struct os_mbuf_pool omtm_small_pool;
+static struct os_mbuf_pool omtm_large_pool;
+
+static void
+omtm_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
+               os_membuf_t *membuf, int count, int size, char *name)
+{
+    int rc;
+
+    rc = os_mempool_init(mp, count, size, membuf, name);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_pool_init(omp, mp, size, count);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_msys_register(omp);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_CASE(os_mbuf_test_msys)
+{
+    struct os_mbuf *small[OMTM_SMALL_BUF_COUNT];
+    struct os_mbuf *large[OMTM_LARGE_BUF_COUNT];
+    struct os_mbuf *om;
+#if MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
+    int rc;
+#endif
+    int i;
+
+    os_msys_reset();
+    omtm_pool_init(&omtm_small_pool, &omtm_small_mempool, omtm_small_membuf,
+                   OMTM_SMALL_BUF_COUNT, OMTM_SMALL_BUF_SIZE, "omtm_small");
+    omtm_pool_init(&omtm_large_pool, &omtm_large_mempool, omtm_large_membuf,
+                   OMTM_LARGE_BUF_COUNT, OMTM_LARGE_BUF_SIZE, "omtm_large");
+    TEST_ASSERT(os_msys_count() ==
+                OMTM_SMALL_BUF_COUNT + OMTM_LARGE_BUF_COUNT);
+
+    /*** Best fit. */
+    for (i = 0; i < OMTM_SMALL_BUF_COUNT; i++) {
+        small[i] = os_msys_get(16, 0);
+        TEST_ASSERT_FATAL(small[i] != NULL);
+        TEST_ASSERT(small[i]->om_omp == &omtm_small_pool);
+    }
+
+    /*** Small pool exhausted; fall back to the large one. */
+    om = os_msys_get(16, 0);
+#if MYNEWT_VAL(MSYS_FALLBACK_LARGER)
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_omp == &omtm_large_pool);
+    large[0] = om;
+#else
+    TEST_ASSERT(om == NULL);
+    large[0] = os_msys_get(100, 0);
+    TEST_ASSERT_FATAL(large[0] != NULL);
+    TEST_ASSERT(large[0]->om_omp == &omtm_large_pool);
+#endif
+
+    large[1] = os_msys_get_pkthdr(100, 0);
+    TEST_ASSERT_FATAL(large[1] != NULL);
+    TEST_ASSERT(large[1]->om_omp == &omtm_large_pool);
+
+    /*** Everything exhausted. */
+    TEST_ASSERT(os_msys_get(16, 0) == NULL);
+    TEST_ASSERT(os_msys_get_pkthdr(100, 0) == NULL);
+
+    /*** Large pool exhausted; fall back to the small one and chain. */
+    for (i = 0; i < OMTM_SMALL_BUF_COUNT; i++) {
+        os_mbuf_free_chain(small[i]);
+    }
+
+    /* A packet header which does not fit a small buffer cannot fall back. */
+    TEST_ASSERT(os_msys_get_pkthdr(100, OMTM_SMALL_BUF_SIZE) == NULL);
+
+    om = os_msys_get_pkthdr(100, 0);
+#if MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_omp == &omtm_small_pool);
+
+    rc = os_mbuf_append(om, os_mbuf_test_data, 100);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 100);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 100) == 0);
+
+    os_mbuf_free_chain(om);
+#else
+    TEST_ASSERT(om == NULL);
+#endif
+    os_mbuf_free_chain(large[0]);
+    os_mbuf_free_chain(large[1]);
+    TEST_ASSERT(os_msys_num_free() ==
+                OMTM_SMALL_BUF_COUNT + OMTM_LARGE_BUF_COUNT);
+
+    os_msys_reset();
+}
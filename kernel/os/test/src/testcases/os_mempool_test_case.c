@@ -57,12 +57,13 @@ retest:
                 "Total memory pool size not correct! (%d vs %lu)",
                 mem_pool_size, (unsigned long)TstMembufSz);
 
-    /* Get the real block size */
+    /* Get the real block size, including guard area and tracking record */
 #if (OS_CFG_ALIGNMENT == OS_CFG_ALIGN_4)
     true_block_size = (g_TstMempool.mp_block_size + 3) & ~3;
 #else
     true_block_size = (g_TstMempool.mp_block_size + 7) & ~7;
 #endif
+    true_block_size += OS_MEMPOOL_BLOCK_SZ(0);
 
     /* Traverse free list. Better add up to number of blocks! */
     cnt = 0;
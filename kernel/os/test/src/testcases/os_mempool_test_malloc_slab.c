@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static struct os_mempool *
+malloc_slab_pool(const char *name)
+{
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+
+    mp = NULL;
+    while ((mp = os_mempool_info_get_next(mp, &omi)) != NULL) {
+        if (strcmp(omi.omi_name, name) == 0) {
+            return mp;
+        }
+    }
+    return NULL;
+}
+
+TEST_CASE(os_mempool_test_malloc_slab)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    void *ptrs[MYNEWT_VAL(OS_MALLOC_SLAB_16_COUNT)];
+    struct os_mempool *mp16;
+    struct os_mempool *mp32;
+    struct os_mempool *mp128;
+    uint8_t *p;
+    uint8_t *q;
+    int i;
+
+    mp16 = malloc_slab_pool("malloc_16");
+    mp32 = malloc_slab_pool("malloc_32");
+    mp128 = malloc_slab_pool("malloc_128");
+    TEST_ASSERT_FATAL(mp16 != NULL && mp32 != NULL && mp128 != NULL);
+
+    /*** Small requests come from the smallest fitting class. */
+    p = os_malloc(10);
+    TEST_ASSERT_FATAL(p != NULL);
+    TEST_ASSERT(os_memblock_from(mp16, p));
+    TEST_ASSERT(mp16->mp_num_free == mp16->mp_num_blocks - 1);
+    os_free(p);
+    TEST_ASSERT(mp16->mp_num_free == mp16->mp_num_blocks);
+
+    /*** An exhausted class spills into the next one. */
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_16_COUNT); i++) {
+        ptrs[i] = os_malloc(16);
+        TEST_ASSERT_FATAL(os_memblock_from(mp16, ptrs[i]));
+    }
+    p = os_malloc(16);
+    TEST_ASSERT(os_memblock_from(mp32, p));
+    os_free(p);
+    for (i = 0; i < MYNEWT_VAL(OS_MALLOC_SLAB_16_COUNT); i++) {
+        os_free(ptrs[i]);
+    }
+    TEST_ASSERT(mp16->mp_num_free == mp16->mp_num_blocks);
+    TEST_ASSERT(mp32->mp_num_free == mp32->mp_num_blocks);
+
+    /*** Large requests go to the heap. */
+    p = os_malloc(1000);
+    TEST_ASSERT_FATAL(p != NULL);
+    TEST_ASSERT(!os_memblock_from(mp16, p) && !os_memblock_from(mp32, p) &&
+                !os_memblock_from(mp128, p));
+    os_free(p);
+
+    /*** Realloc stays in place within the class and moves otherwise. */
+    p = os_malloc(4);
+    TEST_ASSERT_FATAL(p != NULL);
+    for (i = 0; i < 4; i++) {
+        p[i] = i;
+    }
+    q = os_realloc(p, 16);
+    TEST_ASSERT(q == p);
+    q = os_realloc(p, 100);
+    TEST_ASSERT_FATAL(q != NULL);
+    TEST_ASSERT(os_memblock_from(mp128, q));
+    TEST_ASSERT(mp16->mp_num_free == mp16->mp_num_blocks);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(q[i] == i);
+    }
+    os_free(q);
+    TEST_ASSERT(mp128->mp_num_free == mp128->mp_num_blocks);
+#endif
+}
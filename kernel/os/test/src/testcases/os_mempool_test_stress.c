@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/*
+ * Several tasks of different priorities hammer one small pool.  The higher
+ * priority tasks sleep for a tick between rounds, so they keep preempting
+ * the lower priority ones in the middle of os_memblock_get() and
+ * os_memblock_put().  Every block taken is stamped with the owner and checked
+ * before being returned, which catches a block handed out twice.
+ */
+#define STRESS_TASKS        (3)
+#define STRESS_BLOCKS       (8)
+#define STRESS_BLOCK_SIZE   (16)
+#define STRESS_HOLD         (3)
+#define STRESS_ROUNDS       (50)
+#define STRESS_STACK_SIZE   (OS_STACK_ALIGN(512))
+
+static os_membuf_t stress_membuf[OS_MEMPOOL_SIZE(STRESS_BLOCKS,
+                                                 STRESS_BLOCK_SIZE)];
+static struct os_mempool stress_pool;
+static struct os_task stress_tasks[STRESS_TASKS];
+static os_stack_t stress_stacks[STRESS_TASKS][STRESS_STACK_SIZE];
+static struct os_sem stress_done;
+
+static void
+stress_task_handler(void *arg)
+{
+    uint32_t *blocks[STRESS_HOLD];
+    uint32_t id;
+    int round;
+    int spin;
+    int i;
+
+    id = (uint32_t)(uintptr_t)arg;
+
+    for (round = 0; round < STRESS_ROUNDS; round++) {
+        for (i = 0; i < STRESS_HOLD; i++) {
+            blocks[i] = os_memblock_get(&stress_pool);
+            if (blocks[i] != NULL) {
+                TEST_ASSERT(os_memblock_from(&stress_pool, blocks[i]));
+                blocks[i][1] = id;
+            }
+        }
+
+        /* Give others a chance to run while the blocks are held. */
+        for (spin = 0; spin < 1000 * (STRESS_TASKS - id); spin++) {
+            __asm__ volatile ("" ::: "memory");
+        }
+
+        for (i = 0; i < STRESS_HOLD; i++) {
+            if (blocks[i] != NULL) {
+                TEST_ASSERT(blocks[i][1] == id);
+                os_memblock_put(&stress_pool, blocks[i]);
+            }
+        }
+
+        if (id != STRESS_TASKS - 1) {
+            os_time_delay(1);
+        }
+    }
+
+    os_sem_release(&stress_done);
+    while (1) {
+        os_time_delay(OS_TIMEOUT_NEVER);
+    }
+}
+
+TEST_CASE_TASK(os_mempool_test_stress)
+{
+    struct os_memblock *block;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&stress_pool, STRESS_BLOCKS, STRESS_BLOCK_SIZE,
+                         stress_membuf, "stress");
+    TEST_ASSERT_FATAL(rc == 0);
+    os_sem_init(&stress_done, 0);
+
+    for (i = 0; i < STRESS_TASKS; i++) {
+        rc = os_task_init(&stress_tasks[i], "stress", stress_task_handler,
+                          (void *)(uintptr_t)i, TASK1_PRIO + 10 + i,
+                          OS_WAIT_FOREVER, stress_stacks[i],
+                          STRESS_STACK_SIZE);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    for (i = 0; i < STRESS_TASKS; i++) {
+        rc = os_sem_pend(&stress_done, OS_TIMEOUT_NEVER);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Every block is back and the accounting agrees with the list. */
+    TEST_ASSERT(stress_pool.mp_num_free == STRESS_BLOCKS);
+    TEST_ASSERT(stress_pool.mp_min_free <= STRESS_BLOCKS - STRESS_HOLD);
+    TEST_ASSERT(os_mempool_is_sane(&stress_pool));
+
+    cnt = 0;
+    SLIST_FOREACH(block, &stress_pool, mb_next) {
+        cnt++;
+    }
+    TEST_ASSERT(cnt == STRESS_BLOCKS);
+
+    os_mempool_unregister(&stress_pool);
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define OMTT_BLOCK_COUNT    (8)
+#define OMTT_BLOCK_SIZE     (24)
+
+static int omtt_fake_site;
+
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+/* A single allocation site, however often it is called. */
+static void * __attribute__((noinline))
+omtt_get(struct os_mempool *mp)
+{
+    return os_memblock_get(mp);
+}
+#endif
+
+TEST_CASE(os_mempool_test_track)
+{
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+    static os_membuf_t membuf[OS_MEMPOOL_SIZE(OMTT_BLOCK_COUNT,
+                                              OMTT_BLOCK_SIZE)];
+    struct os_mempool_site sites[4];
+    struct os_mempool pool;
+    void *blocks[OMTT_BLOCK_COUNT];
+    int cnt;
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&pool, OMTT_BLOCK_COUNT, OMTT_BLOCK_SIZE, membuf,
+                         "omtt");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Nothing allocated. */
+    TEST_ASSERT(os_mempool_track_sites(&pool, sites, 4) == 0);
+
+    /*** Three blocks from one site, one from another. */
+    for (i = 0; i < 3; i++) {
+        blocks[i] = omtt_get(&pool);
+        TEST_ASSERT_FATAL(blocks[i] != NULL);
+    }
+    blocks[3] = os_memblock_get(&pool);
+    TEST_ASSERT_FATAL(blocks[3] != NULL);
+
+    cnt = os_mempool_track_sites(&pool, sites, 4);
+    TEST_ASSERT_FATAL(cnt == 2);
+    TEST_ASSERT(sites[0].oms_site != sites[1].oms_site);
+    TEST_ASSERT(sites[0].oms_count == 3);
+    TEST_ASSERT(sites[1].oms_count == 1);
+    TEST_ASSERT(!OS_TIME_TICK_GT(sites[0].oms_oldest, os_time_get()));
+
+    /* Sites beyond the array are dropped. */
+    TEST_ASSERT(os_mempool_track_sites(&pool, sites, 1) == 1);
+    TEST_ASSERT(sites[0].oms_count == 3);
+
+    /*** Freed blocks are no longer reported. */
+    rc = os_memblock_put(&pool, blocks[1]);
+    TEST_ASSERT_FATAL(rc == 0);
+    cnt = os_mempool_track_sites(&pool, sites, 4);
+    TEST_ASSERT_FATAL(cnt == 2);
+    TEST_ASSERT(sites[0].oms_count == 2);
+
+    /*** Reattributed blocks. */
+    os_memblock_track_site(&pool, blocks[3], &omtt_fake_site);
+    cnt = os_mempool_track_sites(&pool, sites, 4);
+    TEST_ASSERT_FATAL(cnt == 2);
+    TEST_ASSERT(sites[1].oms_site == (uintptr_t)&omtt_fake_site);
+
+    /*** Bulk allocations and frees are tracked too. */
+    rc = os_memblock_get_n(&pool, blocks + 4, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    cnt = os_mempool_track_sites(&pool, sites, 4);
+    TEST_ASSERT_FATAL(cnt == 3);
+    TEST_ASSERT(sites[0].oms_count + sites[1].oms_count +
+                sites[2].oms_count == 7);
+
+    rc = os_memblock_put_n(&pool, blocks + 4, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_memblock_put(&pool, blocks[0]);
+    os_memblock_put(&pool, blocks[2]);
+    os_memblock_put(&pool, blocks[3]);
+    TEST_ASSERT(os_mempool_track_sites(&pool, sites, 4) == 0);
+
+    /*** Clearing the pool forgets every block. */
+    TEST_ASSERT_FATAL(os_memblock_get(&pool) != NULL);
+    os_mempool_clear(&pool);
+    TEST_ASSERT(os_mempool_track_sites(&pool, sites, 4) == 0);
+
+    os_mempool_unregister(&pool);
+#endif
+}
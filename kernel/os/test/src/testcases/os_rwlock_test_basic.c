@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE_TASK(os_rwlock_test_basic)
+{
+    struct os_rwlock *rw;
+    struct os_task *t;
+    os_error_t err;
+
+    rw = &g_rwlock1;
+    t = os_sched_get_current_task();
+
+    TEST_ASSERT(os_rwlock_init(NULL) == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_read_pend(NULL, 0) == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_read_release(NULL) == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_write_pend(NULL, 0) == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_write_release(NULL) == OS_INVALID_PARM);
+
+    TEST_ASSERT_FATAL(os_rwlock_init(rw) == OS_OK);
+
+    /* Nothing to release */
+    TEST_ASSERT(os_rwlock_read_release(rw) == OS_BAD_MUTEX);
+    TEST_ASSERT(os_rwlock_write_release(rw) == OS_BAD_MUTEX);
+
+    err = os_rwlock_read_pend(rw, 0);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(rw->rw_state == 1);
+    TEST_ASSERT(rw->rw_readers[0].rr_task == t);
+    TEST_ASSERT(rw->rw_readers[0].rr_prio == t->t_prio);
+    TEST_ASSERT(t->t_lockcnt == 1);
+
+    /* Readers keep writers out */
+    err = os_rwlock_write_pend(rw, 0);
+    TEST_ASSERT(err == OS_TIMEOUT, "err=%d", err);
+    TEST_ASSERT(rw->rw_wr_blocked == 1);
+    TEST_ASSERT(os_rwlock_write_release(rw) == OS_BAD_MUTEX);
+
+    err = os_rwlock_read_release(rw);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(rw->rw_state == 0);
+    TEST_ASSERT(rw->rw_readers[0].rr_task == NULL);
+    TEST_ASSERT(t->t_lockcnt == 0);
+
+    err = os_rwlock_write_pend(rw, 0);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(rw->rw_state == OS_RWLOCK_WRITER);
+    TEST_ASSERT(rw->rw_writer == t);
+
+    /* A writer keeps everybody else out */
+    err = os_rwlock_read_pend(rw, 0);
+    TEST_ASSERT(err == OS_TIMEOUT, "err=%d", err);
+    TEST_ASSERT(rw->rw_rd_blocked == 1);
+    TEST_ASSERT(os_rwlock_read_release(rw) == OS_BAD_MUTEX);
+
+    err = os_rwlock_write_release(rw);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+    TEST_ASSERT(rw->rw_state == 0 && rw->rw_writer == NULL);
+    TEST_ASSERT(SLIST_EMPTY(&rw->rw_head));
+    TEST_ASSERT(rw->rw_timeouts == 0);
+
+    os_test_restart();
+}
@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "runtest/runtest.h"
+#include "os_test_priv.h"
+
+TEST_CASE_TASK(os_rwlock_test_case_1)
+{
+    os_error_t err;
+
+    g_rwlock_task2_val = 0;
+    g_rwlock_task3_val = 0;
+    TEST_ASSERT_FATAL(os_rwlock_init(&g_rwlock1) == OS_OK);
+
+    runtest_init_task(rwlock_test_1_task2_handler, TASK2_PRIO);
+    runtest_init_task(rwlock_test_1_task3_handler, TASK3_PRIO);
+
+    err = os_rwlock_read_pend(&g_rwlock1, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+
+    os_time_delay(OS_TICKS_PER_SEC / 10);
+
+    /* Writer and reader are both queued behind us */
+    TEST_ASSERT(g_rwlock1.rw_wr_waiting == 1);
+    TEST_ASSERT(g_rwlock1.rw_state & OS_RWLOCK_WAITERS);
+
+    err = os_rwlock_read_release(&g_rwlock1);
+    TEST_ASSERT(err == OS_OK, "err=%d", err);
+
+    while (!g_rwlock_task3_val) {
+        os_time_delay(OS_TICKS_PER_SEC / 10);
+    }
+
+    TEST_ASSERT(g_rwlock1.rw_state == 0);
+    TEST_ASSERT(SLIST_EMPTY(&g_rwlock1.rw_head));
+    TEST_ASSERT(g_rwlock1.rw_wr_blocked == 1);
+    TEST_ASSERT(g_rwlock1.rw_rd_blocked == 2);
+    TEST_ASSERT(g_rwlock1.rw_timeouts == 0);
+
+    os_test_restart();
+}
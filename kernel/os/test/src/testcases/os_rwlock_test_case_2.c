@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "runtest/runtest.h"
+#include "os_test_priv.h"
+
+TEST_CASE_TASK(os_rwlock_test_case_2)
+{
+    os_error_t err;
+
+    g_rwlock_task2_val = 0;
+    g_rwlock_task3_val = 0;
+    TEST_ASSERT_FATAL(os_rwlock_init(&g_rwlock1) == OS_OK);
+
+    runtest_init_task(rwlock_test_2_task2_handler, TASK2_PRIO);
+    runtest_init_task(rwlock_test_2_task3_handler, TASK3_PRIO);
+
+    /* Let task 3 take the read lock */
+    os_time_delay(1);
+
+    err = os_rwlock_write_pend(&g_rwlock1, OS_TICKS_PER_SEC / 10);
+    TEST_ASSERT(err == OS_TIMEOUT, "err=%d", err);
+    TEST_ASSERT(g_rwlock1.rw_timeouts == 1);
+    TEST_ASSERT(g_rwlock1.rw_wr_waiting == 0);
+
+    os_time_delay(1);
+    TEST_ASSERT(g_rwlock_task2_val == 1);
+
+    while (!g_rwlock_task3_val) {
+        os_time_delay(OS_TICKS_PER_SEC / 10);
+    }
+
+    TEST_ASSERT(g_rwlock1.rw_state == 0);
+    TEST_ASSERT(SLIST_EMPTY(&g_rwlock1.rw_head));
+    TEST_ASSERT(g_rwlock_task3->t_prio == TASK3_PRIO);
+
+    os_test_restart();
+}
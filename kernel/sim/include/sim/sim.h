@@ -48,6 +48,20 @@ void sim_restore_sr(os_sr_t osr);
 int sim_in_critical(void);
 void sim_tick_idle(os_time_t ticks);
 
+/**
+ * Called with interrupts disabled while the wake file descriptor is readable.
+ */
+typedef void sim_wake_fn(void *arg);
+
+/**
+ * Registers a file descriptor that wakes the simulated CPU the way an
+ * interrupt line would: the idle task sleeps until either the next tick or
+ * the descriptor becomes readable.  'cb' runs in interrupt context whenever
+ * the descriptor is found readable, from the idle task or the tick handler.
+ * Only one descriptor is supported; pass -1 to unregister.
+ */
+void sim_wake_fd_set(int fd, sim_wake_fn *cb, void *arg);
+
 /**
  * Prints information about a crash to stdout.  This functionality is defined
  * as a macro rather than a function to ensure that it gets inlined, enforcing
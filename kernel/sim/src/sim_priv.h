@@ -21,6 +21,7 @@
 #define H_SIM_PRIV_
 
 #include <sys/types.h>
+#include <signal.h>
 #include "os/mynewt.h"
 
 #ifdef __cplusplus
@@ -31,6 +32,9 @@ extern "C" {
 
 void sim_switch_tasks(void);
 void sim_tick(void);
+void sim_tick_virtual(os_time_t ticks);
+void sim_suspend(const sigset_t *mask);
+void sim_wake_check(void);
 void sim_signals_init(void);
 void sim_signals_cleanup(void);
 
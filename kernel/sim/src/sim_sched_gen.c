@@ -35,6 +35,8 @@
 #include <unistd.h>
 #include <setjmp.h>
 #include <signal.h>
+#include <poll.h>
+#include <sys/select.h>
 #include <sys/time.h>
 #include <assert.h>
 #include "sim/sim.h"
@@ -45,6 +47,10 @@
 
 pid_t sim_pid;
 
+static int sim_wake_fd = -1;
+static sim_wake_fn *sim_wake_cb;
+static void *sim_wake_arg;
+
 void
 sim_switch_tasks(void)
 {
@@ -121,12 +127,87 @@ sim_tick(void)
     }
 }
 
+/**
+ * Idles in virtual time: rather than waiting for the wall clock to catch up
+ * with the next wakeup, OS time is moved forward to it immediately.  A
+ * request to idle for 0 ticks (i.e., until the next tick) advances time by a
+ * single tick.
+ */
+void
+sim_tick_virtual(os_time_t ticks)
+{
+    OS_ASSERT_CRITICAL();
+
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    os_time_advance(ticks);
+    sim_wake_check();
+}
+
+void
+sim_wake_fd_set(int fd, sim_wake_fn *cb, void *arg)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    sim_wake_fd = fd;
+    sim_wake_cb = cb;
+    sim_wake_arg = arg;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Calls the wake callback if the wake file descriptor is readable.
+ */
+void
+sim_wake_check(void)
+{
+    struct pollfd pfd;
+
+    OS_ASSERT_CRITICAL();
+
+    if (sim_wake_fd < 0) {
+        return;
+    }
+
+    pfd.fd = sim_wake_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 0) > 0) {
+        sim_wake_cb(sim_wake_arg);
+    }
+}
+
+/**
+ * Like sigsuspend(), but also returns when the wake file descriptor becomes
+ * readable.
+ */
+void
+sim_suspend(const sigset_t *mask)
+{
+    fd_set rfds;
+
+    if (sim_wake_fd < 0) {
+        sigsuspend(mask);
+        return;
+    }
+
+    FD_ZERO(&rfds);
+    FD_SET(sim_wake_fd, &rfds);
+    pselect(sim_wake_fd + 1, &rfds, NULL, NULL, NULL, mask);
+}
+
 static void
 sim_start_timer(void)
 {
     struct itimerval it;
     int rc;
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    /* OS time is advanced by the idle task only. */
+    return;
+#endif
+
     memset(&it, 0, sizeof(it));
     it.it_value.tv_sec = 0;
     it.it_value.tv_usec = OS_USEC_PER_TICK;
@@ -243,8 +324,7 @@ sim_os_init(void)
     g_current_task = NULL;
 
     STAILQ_INIT(&g_os_task_list);
-    TAILQ_INIT(&g_os_run_list);
-    TAILQ_INIT(&g_os_sleep_list);
+    os_sched_reset();
 
     sim_signals_init();
 
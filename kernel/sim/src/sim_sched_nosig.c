@@ -159,6 +159,11 @@ sim_tick_idle(os_time_t ticks)
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    sim_tick_virtual(ticks);
+    return;
+#endif
+
     if (ticks > 0) {
         /*
          * Enter tickless regime and set the timer to fire after 'ticks'
@@ -175,7 +180,7 @@ sim_tick_idle(os_time_t ticks)
     unblock_timer();
 
     sigemptyset(&suspsigs);
-    sigsuspend(&nosigs);        /* Wait for a signal to wake us up */
+    sim_suspend(&nosigs);       /* Wait for a signal or the wake fd */
 
     block_timer();
 
@@ -187,6 +192,7 @@ sim_tick_idle(os_time_t ticks)
     if (sigismember(&suspsigs, SIGALRM)) {
         sim_tick();
     }
+    sim_wake_check();
 
     if (ticks > 0) {
         /*
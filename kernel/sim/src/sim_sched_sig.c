@@ -149,6 +149,7 @@ timer_handler(int sig)
         sigaddset(&suspsigs, sig);
     } else {
         sim_tick();
+        sim_wake_check();
     }
 }
 
@@ -171,6 +172,11 @@ sim_tick_idle(os_time_t ticks)
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    sim_tick_virtual(ticks);
+    return;
+#endif
+
     if (ticks > 0) {
         /*
          * Enter tickless regime and set the timer to fire after 'ticks'
@@ -186,7 +192,7 @@ sim_tick_idle(os_time_t ticks)
 
     suspended = true;
     sigemptyset(&suspsigs);
-    sigsuspend(&nosigs);        /* Wait for a signal to wake us up */
+    sim_suspend(&nosigs);       /* Wait for a signal or the wake fd */
     suspended = false;
 
     /*
@@ -204,6 +210,7 @@ sim_tick_idle(os_time_t ticks)
             handler(sig);
         }
     }
+    sim_wake_check();
 
     if (ticks > 0) {
         /*
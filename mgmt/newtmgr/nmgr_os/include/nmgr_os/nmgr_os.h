@@ -34,6 +34,11 @@ extern "C" {
 #define NMGR_ID_DATETIME_STR    4
 #define NMGR_ID_RESET           5
 
+/*
+ * Id's for task profiler group commands
+ */
+#define NMGR_ID_TASKPROF        0
+
 int nmgr_os_groups_register(void);
 
 #ifdef __cplusplus
@@ -48,6 +48,10 @@ static int nmgr_def_mpstat_read(struct mgmt_cbuf *njb);
 static int nmgr_datetime_get(struct mgmt_cbuf *njb);
 static int nmgr_datetime_set(struct mgmt_cbuf *njb);
 static int nmgr_reset(struct mgmt_cbuf *njb);
+#if MYNEWT_VAL(OS_TASK_PROF)
+static int nmgr_taskprof_read(struct mgmt_cbuf *njb);
+static int nmgr_taskprof_reset(struct mgmt_cbuf *njb);
+#endif
 
 static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_ECHO] = {
@@ -79,6 +83,24 @@ static struct mgmt_group nmgr_def_group = {
     .mg_group_id = MGMT_GROUP_ID_DEFAULT
 };
 
+#if MYNEWT_VAL(OS_TASK_PROF)
+static const struct mgmt_handler nmgr_taskprof_group_handlers[] = {
+    [NMGR_ID_TASKPROF] = {
+        nmgr_taskprof_read, nmgr_taskprof_reset
+    },
+};
+
+#define NMGR_TASKPROF_GROUP_SZ                                          \
+    (sizeof(nmgr_taskprof_group_handlers) /                             \
+     sizeof(nmgr_taskprof_group_handlers[0]))
+
+static struct mgmt_group nmgr_taskprof_group = {
+    .mg_handlers = (struct mgmt_handler *)nmgr_taskprof_group_handlers,
+    .mg_handlers_count = NMGR_TASKPROF_GROUP_SZ,
+    .mg_group_id = MGMT_GROUP_ID_TASKPROF
+};
+#endif
+
 static int
 nmgr_def_echo(struct mgmt_cbuf *cb)
 {
@@ -188,6 +210,111 @@ nmgr_def_taskstat_read(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(OS_TASK_PROF)
+static int
+nmgr_taskprof_read(struct mgmt_cbuf *cb)
+{
+    struct os_task *prev_task;
+    struct os_task_info oti;
+    struct os_task_prof tp;
+    CborError g_err = CborNoError;
+    CborEncoder tasks;
+    CborEncoder task;
+    CborEncoder hist;
+    int i;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "freq");
+    g_err |= cbor_encode_uint(&cb->encoder, MYNEWT_VAL(OS_CPUTIME_FREQ));
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "histshift");
+    g_err |= cbor_encode_uint(&cb->encoder,
+                              MYNEWT_VAL(OS_TASK_PROF_HIST_SHIFT));
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "tasks");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &tasks,
+                                     CborIndefiniteLength);
+
+    prev_task = NULL;
+    while (1) {
+        prev_task = os_task_info_get_next(prev_task, &oti);
+        if (prev_task == NULL) {
+            break;
+        }
+        os_task_prof_get(prev_task, &tp);
+
+        g_err |= cbor_encode_text_stringz(&tasks, oti.oti_name);
+        g_err |= cbor_encoder_create_map(&tasks, &task, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&task, "runtime");
+        g_err |= cbor_encode_uint(&task, tp.tp_run_time);
+        g_err |= cbor_encode_text_stringz(&task, "slicemax");
+        g_err |= cbor_encode_uint(&task, tp.tp_slice_max);
+        g_err |= cbor_encode_text_stringz(&task, "latmax");
+        g_err |= cbor_encode_uint(&task, tp.tp_lat_max);
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+        g_err |= cbor_encode_text_stringz(&task, "critmax");
+        g_err |= cbor_encode_uint(&task, tp.tp_crit_max);
+#endif
+        g_err |= cbor_encode_text_stringz(&task, "lathist");
+        g_err |= cbor_encoder_create_array(&task, &hist,
+                                       MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS));
+        for (i = 0; i < MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS); i++) {
+            g_err |= cbor_encode_uint(&hist, tp.tp_lat_hist[i]);
+        }
+        g_err |= cbor_encoder_close_container(&task, &hist);
+        g_err |= cbor_encoder_close_container(&tasks, &task);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &tasks);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+
+static int
+nmgr_taskprof_reset(struct mgmt_cbuf *cb)
+{
+    os_task_prof_reset();
+
+    return mgmt_cbuf_setoerr(cb, 0);
+}
+#endif
+
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+static CborError
+nmgr_def_mpstat_sites(CborEncoder *pool, const struct os_mempool *mp)
+{
+    struct os_mempool_site sites[MYNEWT_VAL(OS_MEMPOOL_TRACK_MAX_SITES)];
+    CborError g_err = CborNoError;
+    CborEncoder arr;
+    CborEncoder site;
+    os_time_t now;
+    int cnt;
+    int i;
+
+    now = os_time_get();
+    cnt = os_mempool_track_sites(mp, sites,
+                                 MYNEWT_VAL(OS_MEMPOOL_TRACK_MAX_SITES));
+
+    g_err |= cbor_encode_text_stringz(pool, "sites");
+    g_err |= cbor_encoder_create_array(pool, &arr, cnt);
+    for (i = 0; i < cnt; i++) {
+        g_err |= cbor_encoder_create_map(&arr, &site, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&site, "site");
+        g_err |= cbor_encode_uint(&site, sites[i].oms_site);
+        g_err |= cbor_encode_text_stringz(&site, "cnt");
+        g_err |= cbor_encode_uint(&site, sites[i].oms_count);
+        g_err |= cbor_encode_text_stringz(&site, "age");
+        g_err |= cbor_encode_uint(&site,
+                        os_time_ticks_to_ms32(now - sites[i].oms_oldest));
+        g_err |= cbor_encoder_close_container(&arr, &site);
+    }
+    g_err |= cbor_encoder_close_container(pool, &arr);
+
+    return g_err;
+}
+#endif
+
 static int
 nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
 {
@@ -220,6 +347,9 @@ nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
         g_err |= cbor_encode_uint(&pool, omi.omi_num_free);
         g_err |= cbor_encode_text_stringz(&pool, "min");
         g_err |= cbor_encode_uint(&pool, omi.omi_min_free);
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+        g_err |= nmgr_def_mpstat_sites(&pool, prev_mp);
+#endif
         g_err |= cbor_encoder_close_container(&pools, &pool);
     }
 
@@ -342,6 +472,14 @@ nmgr_reset(struct mgmt_cbuf *cb)
 int
 nmgr_os_groups_register(void)
 {
-    return mgmt_group_register(&nmgr_def_group);
+    int rc;
+
+    rc = mgmt_group_register(&nmgr_def_group);
+#if MYNEWT_VAL(OS_TASK_PROF)
+    if (rc == 0) {
+        rc = mgmt_group_register(&nmgr_taskprof_group);
+    }
+#endif
+    return rc;
 }
 
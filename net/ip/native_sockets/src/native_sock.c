@@ -28,6 +28,9 @@
 #include <sys/ioctl.h>
 #include <sys/un.h>
 #include <stdio.h>
+#ifdef MN_LINUX
+#include <sys/epoll.h>
+#endif
 
 #include "os/mynewt.h"
 #include "mn_socket/mn_socket.h"
@@ -36,12 +39,27 @@
 
 #include "native_sock_priv.h"
 
+#ifdef MN_LINUX
+#include "sim/sim.h"
+
+/*
+ * On Linux the sockets are watched with epoll.  The idle task sleeps on the
+ * epoll descriptor along with the tick timer (sim_wake_fd_set()), so the
+ * socket task is woken as soon as a socket becomes ready rather than at the
+ * next poll interval, and only looks at the sockets that are ready.
+ */
+#define NATIVE_SOCK_EPOLL               (1)
+#define NATIVE_SOCK_EPOLL_EVENTS        (16)
+#endif
+
 static struct native_sock {
     struct mn_socket ns_sock;
     int ns_fd;
     unsigned int ns_connect:1;  /* Non-blocking connect in progress. */
     unsigned int ns_poll:1;
     unsigned int ns_listen:1;
+    unsigned int ns_rx_pend:1;  /* Readable reported, not yet read. */
+    uint8_t ns_events;          /* POLLIN / POLLOUT being watched. */
     uint8_t ns_type;
     uint8_t ns_pf;
     struct os_sem ns_sem;
@@ -50,8 +68,15 @@ static struct native_sock {
 } native_socks[MYNEWT_VAL(NATIVE_SOCKETS_MAX)];
 
 static struct native_sock_state {
+#ifdef NATIVE_SOCK_EPOLL
+    int epoll_fd;
+    struct os_eventq evq;
+    struct os_event wake_ev;
+#else
     struct pollfd poll_fds[MYNEWT_VAL(NATIVE_SOCKETS_MAX)];
     int poll_fd_cnt;
+    int poll_dirty;
+#endif
     struct os_mutex mtx;
     struct os_task task;
 } native_sock_state;
@@ -86,14 +111,18 @@ native_get_sock(void)
     for (i = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
         if (native_socks[i].ns_fd < 0) {
             ns = &native_socks[i];
+            ns->ns_connect = 0;
             ns->ns_poll = 0;
             ns->ns_listen = 0;
+            ns->ns_rx_pend = 0;
+            ns->ns_events = 0;
             return ns;
         }
     }
     return NULL;
 }
 
+#ifndef NATIVE_SOCK_EPOLL
 static struct native_sock *
 native_find_sock(int fd)
 {
@@ -106,7 +135,71 @@ native_find_sock(int fd)
     }
     return NULL;
 }
+#endif
+
+/*
+ * A socket is watched for input until it is reported readable, and again
+ * once the user has read from it.  It is watched for output only while a
+ * connect or a stream transmit is pending.  This way a socket that is ready
+ * but has nothing for us to do does not keep waking the socket task.
+ */
+static int
+native_sock_events(struct native_sock *ns)
+{
+    int events;
+
+    events = 0;
+    if (ns->ns_fd >= 0 && ns->ns_poll) {
+        if (!ns->ns_rx_pend) {
+            events |= POLLIN;
+        }
+        if (ns->ns_connect || ns->ns_tx) {
+            events |= POLLOUT;
+        }
+    }
+    return events;
+}
+
+/*
+ * Brings the set of watched sockets in line with native_sock_events().
+ * Must be called with the mutex held.
+ */
+static void
+native_sock_poll_update(struct native_sock_state *nss, struct native_sock *ns)
+{
+    int events;
+#ifdef NATIVE_SOCK_EPOLL
+    struct epoll_event ev;
+    int op;
+    int rc;
+#endif
+
+    events = native_sock_events(ns);
+    if (events == ns->ns_events) {
+        return;
+    }
+
+#ifdef NATIVE_SOCK_EPOLL
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ((events & POLLIN) ? EPOLLIN : 0) |
+                ((events & POLLOUT) ? EPOLLOUT : 0);
+    ev.data.ptr = ns;
+    if (!events) {
+        op = EPOLL_CTL_DEL;
+    } else if (!ns->ns_events) {
+        op = EPOLL_CTL_ADD;
+    } else {
+        op = EPOLL_CTL_MOD;
+    }
+    rc = epoll_ctl(nss->epoll_fd, op, ns->ns_fd, &ev);
+    assert(rc == 0);
+#else
+    nss->poll_dirty = 1;
+#endif
+    ns->ns_events = events;
+}
 
+#ifndef NATIVE_SOCK_EPOLL
 static void
 native_sock_poll_rebuild(struct native_sock_state *nss)
 {
@@ -114,23 +207,20 @@ native_sock_poll_rebuild(struct native_sock_state *nss)
     int i;
     int j;
 
-    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
     for (i = 0, j = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
         ns = &native_socks[i];
-        if (ns->ns_fd < 0) {
-            continue;
-        }
-        if (!ns->ns_poll) {
+        if (!ns->ns_events) {
             continue;
         }
         nss->poll_fds[j].fd = ns->ns_fd;
-        nss->poll_fds[j].events = POLLIN | POLLOUT;
+        nss->poll_fds[j].events = ns->ns_events;
         nss->poll_fds[j].revents = 0;
         j++;
     }
     nss->poll_fd_cnt = j;
-    os_mutex_release(&nss->mtx);
+    nss->poll_dirty = 0;
 }
+#endif
 
 int
 native_sock_err_to_mn_err(int err)
@@ -313,9 +403,13 @@ native_sock_close(struct mn_socket *s)
 {
     struct native_sock_state *nss = &native_sock_state;
     struct native_sock *ns = (struct native_sock *)s;
+    struct native_sock *lns;
     struct os_mbuf_pkthdr *m;
+    int i;
 
     os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+    ns->ns_poll = 0;
+    native_sock_poll_update(nss, ns);
     close(ns->ns_fd);
     ns->ns_fd = -1;
 
@@ -328,7 +422,16 @@ native_sock_close(struct mn_socket *s)
         os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(m));
     }
     os_mbuf_free_chain(ns->ns_tx);
-    native_sock_poll_rebuild(nss);
+    ns->ns_tx = NULL;
+
+    /* Listeners that ran out of sockets can accept again. */
+    for (i = 0; i < MYNEWT_VAL(NATIVE_SOCKETS_MAX); i++) {
+        lns = &native_socks[i];
+        if (lns->ns_fd >= 0 && lns->ns_listen && lns->ns_rx_pend) {
+            lns->ns_rx_pend = 0;
+            native_sock_poll_update(nss, lns);
+        }
+    }
     os_mutex_release(&nss->mtx);
     return 0;
 }
@@ -362,7 +465,7 @@ native_sock_connect(struct mn_socket *s, struct mn_sockaddr *addr)
         }
     }
     ns->ns_poll = 1;
-    native_sock_poll_rebuild(nss);
+    native_sock_poll_update(nss, ns);
     os_mutex_release(&nss->mtx);
 
     /* Indicate writability if connection fully established. */
@@ -406,7 +509,7 @@ native_sock_bind(struct mn_socket *s, struct mn_sockaddr *addr)
     }
     if (ns->ns_type == SOCK_DGRAM) {
         ns->ns_poll = 1;
-        native_sock_poll_rebuild(nss);
+        native_sock_poll_update(nss, ns);
     }
     os_mutex_release(&nss->mtx);
     return 0;
@@ -431,7 +534,7 @@ native_sock_listen(struct mn_socket *s, uint8_t qlen)
     }
     ns->ns_poll = 1;
     ns->ns_listen = 1;
-    native_sock_poll_rebuild(nss);
+    native_sock_poll_update(nss, ns);
     os_mutex_release(&nss->mtx);
     return 0;
 }
@@ -484,6 +587,7 @@ native_sock_stream_tx(struct native_sock *ns, int notify)
             break;
         }
     }
+    native_sock_poll_update(nss, ns);
     os_mutex_release(&nss->mtx);
     if (notify) {
         mn_socket_writable(&ns->ns_sock, rc);
@@ -552,6 +656,20 @@ native_sock_sendto(struct mn_socket *s, struct os_mbuf *m,
     }
 }
 
+/*
+ * The user has read from the socket; tell it again when more data comes.
+ */
+static void
+native_sock_rx_rearm(struct native_sock *ns)
+{
+    struct native_sock_state *nss = &native_sock_state;
+
+    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+    ns->ns_rx_pend = 0;
+    native_sock_poll_update(nss, ns);
+    os_mutex_release(&nss->mtx);
+}
+
 int
 native_sock_recvfrom(struct mn_socket *s, struct os_mbuf **mp,
   struct mn_sockaddr *addr)
@@ -574,14 +692,19 @@ native_sock_recvfrom(struct mn_socket *s, struct os_mbuf **mp,
         }
     }
     if (rc < 0) {
-        return native_sock_err_to_mn_err(errno);
+        rc = native_sock_err_to_mn_err(errno);
+        native_sock_rx_rearm(ns);
+        return rc;
     }
     if (ns->ns_type == SOCK_STREAM && rc == 0) {
         mn_socket_readable(&ns->ns_sock, MN_ECONNABORTED);
+        os_mutex_pend(&native_sock_state.mtx, OS_WAIT_FOREVER);
         ns->ns_poll = 0;
-        native_sock_poll_rebuild(&native_sock_state);
+        native_sock_poll_update(&native_sock_state, ns);
+        os_mutex_release(&native_sock_state.mtx);
         return MN_ECONNABORTED;
     }
+    native_sock_rx_rearm(ns);
 
     m = os_msys_get_pkthdr(rc, 0);
     if (!m) {
@@ -725,32 +848,147 @@ native_sock_getpeername(struct mn_socket *s, struct mn_sockaddr *addr)
 }
 
 /*
- * XXX should do this task with SIGIO as well.
+ * Handles readiness of one socket.  Called with the mutex held.
  */
 static void
-socket_task(void *arg)
+native_sock_event(struct native_sock_state *nss, struct native_sock *ns,
+  int revents)
 {
-    struct native_sock_state *nss = arg;
-    struct native_sock *ns, *new_ns;
+    struct native_sock *new_ns;
     struct sockaddr_storage ss;
     struct sockaddr *sa = (struct sockaddr *)&ss;
-    int revents;
-    int i;
     socklen_t slen;
     int sock_err;
     int rc;
 
+    /* The socket may have been closed while handling an earlier one. */
+    revents &= ns->ns_events;
+
+    if (revents & POLLIN) {
+        if (ns->ns_listen) {
+            new_ns = native_get_sock();
+            if (!new_ns) {
+                /* Try again once a socket is closed. */
+                ns->ns_rx_pend = 1;
+                native_sock_poll_update(nss, ns);
+                return;
+            }
+            slen = sizeof(ss);
+            new_ns->ns_fd = accept(ns->ns_fd, sa, &slen);
+            if (new_ns->ns_fd < 0) {
+                /*
+                 * Connection aborted or interrupted; the slot stays free
+                 * and the listener stays armed for the next one.
+                 */
+                new_ns->ns_fd = -1;
+                return;
+            }
+            new_ns->ns_type = ns->ns_type;
+            new_ns->ns_sock.ms_ops = &native_sock_ops;
+            os_mutex_release(&nss->mtx);
+            if (mn_socket_newconn(&ns->ns_sock, &new_ns->ns_sock)) {
+                /*
+                 * should close
+                 */
+            }
+            os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+            new_ns->ns_poll = 1;
+            native_sock_poll_update(nss, new_ns);
+        } else {
+            ns->ns_rx_pend = 1;
+            native_sock_poll_update(nss, ns);
+            mn_socket_readable(&ns->ns_sock, 0);
+        }
+    }
+
+    if (revents & POLLOUT) {
+        if (ns->ns_connect) {
+            /*
+             * The connection attempt has completed.  Report whether it
+             * succeeded.
+             */
+            ns->ns_connect = 0;
+            native_sock_poll_update(nss, ns);
+
+            slen = sizeof(sock_err);
+            rc = getsockopt(ns->ns_fd, SOL_SOCKET, SO_ERROR,
+                            &sock_err, &slen);
+            if (rc != 0) {
+                rc = native_sock_err_to_mn_err(errno);
+            } else if (sock_err != 0) {
+                rc = native_sock_err_to_mn_err(sock_err);
+            }
+            mn_socket_writable(&ns->ns_sock, rc);
+        } else if (ns->ns_type == SOCK_STREAM && ns->ns_tx) {
+            native_sock_stream_tx(ns, 1);
+        }
+    }
+}
+
+#ifdef NATIVE_SOCK_EPOLL
+/*
+ * Called by the idle task or the tick handler while there are ready sockets.
+ */
+static void
+native_sock_wake(void *arg)
+{
+    struct native_sock_state *nss = arg;
+
+    os_eventq_put(&nss->evq, &nss->wake_ev);
+}
+
+static void
+socket_task(void *arg)
+{
+    struct native_sock_state *nss = arg;
+    struct epoll_event evs[NATIVE_SOCK_EPOLL_EVENTS];
+    int revents;
+    int cnt;
+    int i;
+
+    while (1) {
+        os_eventq_get(&nss->evq);
+        os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+        do {
+            cnt = epoll_wait(nss->epoll_fd, evs, NATIVE_SOCK_EPOLL_EVENTS, 0);
+            for (i = 0; i < cnt; i++) {
+                revents = 0;
+                if (evs[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    revents |= POLLIN;
+                }
+                if (evs[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    revents |= POLLOUT;
+                }
+                native_sock_event(nss, evs[i].data.ptr, revents);
+            }
+        } while (cnt == NATIVE_SOCK_EPOLL_EVENTS);
+        os_mutex_release(&nss->mtx);
+    }
+}
+#else
+static void
+socket_task(void *arg)
+{
+    struct native_sock_state *nss = arg;
+    struct native_sock *ns;
+    int revents;
+    int i;
+    int rc;
+
     os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
     while (1) {
         os_mutex_release(&nss->mtx);
         os_time_delay(MYNEWT_VAL(NATIVE_SOCKETS_POLL_ITVL));
         os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
+        if (nss->poll_dirty) {
+            native_sock_poll_rebuild(nss);
+        }
         if (nss->poll_fd_cnt) {
             rc = poll(nss->poll_fds, nss->poll_fd_cnt, 0);
         } else {
             rc = 0;
         }
-        if (rc == 0) {
+        if (rc <= 0) {
             continue;
         }
         for (i = 0; i < nss->poll_fd_cnt; i++) {
@@ -760,61 +998,18 @@ socket_task(void *arg)
 
             revents = nss->poll_fds[i].revents;
             nss->poll_fds[i].revents = 0;
-
-            ns = native_find_sock(nss->poll_fds[i].fd);
-            assert(ns);
-
-            if (revents & POLLIN) {
-                if (ns->ns_listen) {
-                    new_ns = native_get_sock();
-                    if (!new_ns) {
-                        continue;
-                    }
-                    slen = sizeof(ss);
-                    new_ns->ns_fd = accept(ns->ns_fd, sa, &slen);
-                    if (new_ns->ns_fd < 0) {
-                        continue;
-                    }
-                    new_ns->ns_type = ns->ns_type;
-                    new_ns->ns_sock.ms_ops = &native_sock_ops;
-                    os_mutex_release(&nss->mtx);
-                    if (mn_socket_newconn(&ns->ns_sock, &new_ns->ns_sock)) {
-                        /*
-                         * should close
-                         */
-                    }
-                    os_mutex_pend(&nss->mtx, OS_WAIT_FOREVER);
-                    new_ns->ns_poll = 1;
-                    native_sock_poll_rebuild(nss);
-                } else {
-                    mn_socket_readable(&ns->ns_sock, 0);
-                }
+            if (revents & (POLLERR | POLLHUP)) {
+                revents |= POLLIN | POLLOUT;
             }
 
-            if (revents & POLLOUT) {
-                if (ns->ns_connect) {
-                    /*
-                     * The connection attempt has completed.  Report whether it
-                     * succeeded.
-                     */
-                    ns->ns_connect = 0;
-
-                    slen = sizeof(sock_err);
-                    rc = getsockopt(ns->ns_fd, SOL_SOCKET, SO_ERROR,
-                                    &sock_err, &slen);
-                    if (rc != 0) {
-                        rc = native_sock_err_to_mn_err(errno);
-                    } else if (sock_err != 0) {
-                        rc = native_sock_err_to_mn_err(sock_err);
-                    }
-                    mn_socket_writable(&ns->ns_sock, rc);
-                } else if (ns->ns_type == SOCK_STREAM && ns->ns_tx) {
-                    native_sock_stream_tx(ns, 1);
-                }
+            ns = native_find_sock(nss->poll_fds[i].fd);
+            if (ns) {
+                native_sock_event(nss, ns, revents);
             }
         }
     }
 }
+#endif
 
 int
 native_sock_init(void)
@@ -835,6 +1030,15 @@ native_sock_init(void)
         return -1;
     }
     os_mutex_init(&nss->mtx);
+#ifdef NATIVE_SOCK_EPOLL
+    nss->epoll_fd = epoll_create1(0);
+    if (nss->epoll_fd < 0) {
+        return -1;
+    }
+    os_eventq_init(&nss->evq);
+    nss->wake_ev.ev_arg = nss;
+    sim_wake_fd_set(nss->epoll_fd, native_sock_wake, nss);
+#endif
     i = os_task_init(&nss->task, "socket", socket_task, &native_sock_state,
       MYNEWT_VAL(NATIVE_SOCKETS_PRIO), OS_WAIT_FOREVER, sp,
       MYNEWT_VAL(NATIVE_SOCKETS_STACK_SZ));
@@ -230,6 +230,38 @@ int conf_save_tree(char *name);
  */
 int conf_save_one(const char *name, char *var);
 
+/**
+ * Start a transaction. Until conf_txn_commit() or conf_txn_abort(), values
+ * saved by this task are kept in RAM; saving the same name again replaces
+ * the earlier value. Other tasks accessing config block until the
+ * transaction ends. Needs syscfg CONFIG_TXN.
+ *
+ * @return 0 on success, OS_EBUSY if this task has a transaction open
+ *         already.
+ */
+int conf_txn_begin(void);
+
+/**
+ * Persist the values saved since conf_txn_begin() as one group. Must be
+ * called by the task which started the transaction. With the FCB and file
+ * stores, if the system resets during commit, either all of the changed
+ * values or none of them are loaded at next boot. Stores which do not
+ * implement csi_save_txn get the values one at a time with csi_save(), and
+ * a reset during commit can leave only some of them stored.
+ *
+ * @return 0 on success, OS_ENOMEM if the transaction did not fit in
+ *         RAM or in storage, other non-zero on failure. The transaction is
+ *         closed in all cases.
+ */
+int conf_txn_commit(void);
+
+/**
+ * Discard the values saved since conf_txn_begin().
+ *
+ * @return 0 on success, OS_EINVAL if there is no open transaction.
+ */
+int conf_txn_abort(void);
+
 /**
  * Set configuration item identified by @p name to be value @p val_str.
  * This finds the configuration handler for this subtree and calls it's
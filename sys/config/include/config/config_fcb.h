@@ -19,6 +19,7 @@
 #ifndef __SYS_CONFIG_FCB_H_
 #define __SYS_CONFIG_FCB_H_
 
+#include "os/mynewt.h"
 #include "config/config.h"
 #include "config/config_store.h"
 
@@ -26,9 +27,25 @@
 extern "C" {
 #endif
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) > 0
+/*
+ * Location of the latest record of a config name; internal to config_fcb.
+ */
+struct conf_fcb_index_entry {
+    uint32_t cie_loc;           /* Sector index << 24 | data offset */
+    uint16_t cie_len;           /* Record length, 0 if the slot is free */
+    uint16_t cie_hash;          /* CRC16 of the name */
+};
+#endif
+
 struct conf_fcb {
     struct conf_store cf_store;
     struct fcb cf_fcb;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) > 0
+    /* Internal - RAM index of the latest record of every name */
+    uint8_t cf_index_state;
+    struct conf_fcb_index_entry cf_index[MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE)];
+#endif
 };
 
 /**
@@ -19,6 +19,7 @@
 #ifndef __SYS_CONFIG_FILE_H_
 #define __SYS_CONFIG_FILE_H_
 
+#include "os/mynewt.h"
 #include "config/config.h"
 #include "config/config_store.h"
 
@@ -34,6 +35,9 @@ struct conf_file {
     const char *cf_name;                /* filename */
     int cf_maxlines;                    /* max # of lines before compressing */
     int cf_lines;                       /* private */
+#if MYNEWT_VAL(CONFIG_TXN)
+    int cf_txn_checked;                 /* private */
+#endif
 };
 
 int conf_file_src(struct conf_file *);  /* register file to be source of cfg */
@@ -42,6 +42,22 @@ struct conf_store_itf {
     int (*csi_save_start)(struct conf_store *cs);
     int (*csi_save)(struct conf_store *cs, const char *name, const char *value);
     int (*csi_save_end)(struct conf_store *cs);
+    /*
+     * Optional. Calls cb with the latest stored value of name, if there is
+     * one, without going through the rest of the store. Returns non-zero
+     * without calling cb if the store cannot do this; csi_load() is used
+     * instead.
+     */
+    int (*csi_lookup)(struct conf_store *cs, const char *name,
+                      conf_store_load_cb cb, void *cb_arg);
+    /*
+     * Optional. Stores cnt "name=value" lines, each ending in '\n' and len
+     * bytes in total, so that after a reset either all or none of them are
+     * loaded. Without it, transactions are saved with csi_save() one value
+     * at a time.
+     */
+    int (*csi_save_txn)(struct conf_store *cs, const char *lines, int len,
+                        int cnt);
 };
 
 struct conf_store {
@@ -22,6 +22,7 @@
 #if MYNEWT_VAL(CONFIG_FCB)
 
 #include <fcb/fcb.h>
+#include <crc/crc16.h>
 #include <string.h>
 
 #include "config/config.h"
@@ -35,6 +36,7 @@
 struct conf_fcb_load_cb_arg {
     conf_store_load_cb cb;
     void *cb_arg;
+    struct conf_fcb *cf;
 };
 
 struct conf_kv_load_cb_arg {
@@ -48,11 +50,329 @@ static int conf_fcb_load(struct conf_store *, conf_store_load_cb cb,
 static int conf_fcb_save(struct conf_store *, const char *name,
                          const char *value);
 
+static int conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name,
+                             char **val);
+static int conf_fcb_append(struct fcb *fcb, struct conf_fcb *cf,
+                           const char *buf, int len, struct fcb_entry *loc);
+#if MYNEWT_VAL(CONFIG_TXN)
+static int conf_fcb_save_txn(struct conf_store *cs, const char *lines,
+                             int len, int cnt);
+#endif
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) > 0
+
+#define CONF_FCB_INDEX_CNT      MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE)
+
+#define CONF_FCB_INDEX_NONE     0   /* Not built yet */
+#define CONF_FCB_INDEX_OK       1
+#define CONF_FCB_INDEX_FULL     2   /* More names than slots */
+
+static int conf_fcb_lookup(struct conf_store *cs, const char *name,
+                           conf_store_load_cb cb, void *cb_arg);
+
 static struct conf_store_itf conf_fcb_itf = {
     .csi_load = conf_fcb_load,
     .csi_save = conf_fcb_save,
+    .csi_lookup = conf_fcb_lookup,
+#if MYNEWT_VAL(CONFIG_TXN)
+    .csi_save_txn = conf_fcb_save_txn,
+#endif
 };
 
+static uint16_t
+conf_fcb_index_hash(const char *name)
+{
+    return crc16_ccitt(0, name, strlen(name));
+}
+
+static uint32_t
+conf_fcb_index_loc(struct conf_fcb *cf, struct fcb_entry *loc)
+{
+    return ((uint32_t)(loc->fe_area - cf->cf_fcb.f_sectors) << 24) |
+      loc->fe_data_off;
+}
+
+/*
+ * Find the slot of name, or the free slot where it should go.  Returns
+ * NULL if name is not indexed and there is no room for it.  If name is
+ * found, its record is left parsed in buf.
+ */
+static struct conf_fcb_index_entry *
+conf_fcb_index_find(struct conf_fcb *cf, const char *name, uint16_t hash,
+                    char *buf, char **namep, char **valp)
+{
+    struct conf_fcb_index_entry *cie;
+    struct fcb_entry loc;
+    int idx;
+    int i;
+
+    idx = hash % CONF_FCB_INDEX_CNT;
+    for (i = 0; i < CONF_FCB_INDEX_CNT; i++) {
+        cie = &cf->cf_index[idx];
+        if (cie->cie_len == 0) {
+            return cie;
+        }
+        if (cie->cie_hash == hash) {
+            loc.fe_area = &cf->cf_fcb.f_sectors[cie->cie_loc >> 24];
+            loc.fe_data_off = cie->cie_loc & 0xffffff;
+            loc.fe_data_len = cie->cie_len;
+            if (!conf_fcb_var_read(&loc, buf, namep, valp) &&
+                !strcmp(name, *namep)) {
+                return cie;
+            }
+        }
+        if (++idx == CONF_FCB_INDEX_CNT) {
+            idx = 0;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Record loc as the latest record of name.
+ */
+static void
+conf_fcb_index_set(struct conf_fcb *cf, const char *name,
+                   struct fcb_entry *loc)
+{
+    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    struct conf_fcb_index_entry *cie;
+    uint16_t hash;
+    char *name2;
+    char *val;
+
+    if (cf->cf_index_state != CONF_FCB_INDEX_OK) {
+        return;
+    }
+    hash = conf_fcb_index_hash(name);
+    cie = conf_fcb_index_find(cf, name, hash, buf, &name2, &val);
+    if (!cie || loc->fe_data_off > 0xffffff) {
+        cf->cf_index_state = CONF_FCB_INDEX_FULL;
+        return;
+    }
+    cie->cie_loc = conf_fcb_index_loc(cf, loc);
+    cie->cie_len = loc->fe_data_len;
+    cie->cie_hash = hash;
+}
+
+/*
+ * Build the index if it is not there yet.  Returns 0 if it can be used.
+ */
+static int
+conf_fcb_index_ready(struct conf_fcb *cf)
+{
+    if (cf->cf_index_state == CONF_FCB_INDEX_NONE) {
+        conf_fcb_load(&cf->cf_store, NULL, NULL);
+    }
+    if (cf->cf_index_state != CONF_FCB_INDEX_OK) {
+        return OS_ENOENT;
+    }
+    return 0;
+}
+
+/*
+ * Returns 1 if loc holds the latest record of name, 0 if it does not and
+ * -1 if the index cannot tell.
+ */
+static int
+conf_fcb_index_is_latest(struct conf_fcb *cf, const char *name,
+                         struct fcb_entry *loc)
+{
+    struct conf_fcb_index_entry *cie;
+    uint32_t loc_val;
+    uint16_t hash;
+    int idx;
+    int i;
+
+    if (!cf || conf_fcb_index_ready(cf)) {
+        return -1;
+    }
+
+    /*
+     * Records are only indexed under their own name, so the slot pointing
+     * at loc, if any, is the one of name.  No need to read flash.
+     */
+    hash = conf_fcb_index_hash(name);
+    loc_val = conf_fcb_index_loc(cf, loc);
+    idx = hash % CONF_FCB_INDEX_CNT;
+    for (i = 0; i < CONF_FCB_INDEX_CNT; i++) {
+        cie = &cf->cf_index[idx];
+        if (cie->cie_len == 0) {
+            break;
+        }
+        if (cie->cie_hash == hash && cie->cie_loc == loc_val) {
+            return 1;
+        }
+        if (++idx == CONF_FCB_INDEX_CNT) {
+            idx = 0;
+        }
+    }
+    return 0;
+}
+
+static void
+conf_fcb_index_reset(struct conf_fcb *cf)
+{
+    if (cf) {
+        cf->cf_index_state = CONF_FCB_INDEX_NONE;
+    }
+}
+
+static int
+conf_fcb_lookup(struct conf_store *cs, const char *name,
+                conf_store_load_cb cb, void *cb_arg)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    struct conf_fcb_index_entry *cie;
+    char *name2;
+    char *val;
+
+    if (conf_fcb_index_ready(cf)) {
+        return OS_ENOENT;
+    }
+    cie = conf_fcb_index_find(cf, name, conf_fcb_index_hash(name), buf,
+      &name2, &val);
+    if (cie && cie->cie_len) {
+        cb(name2, val, cb_arg);
+    }
+    return 0;
+}
+
+#else
+
+static struct conf_store_itf conf_fcb_itf = {
+    .csi_load = conf_fcb_load,
+    .csi_save = conf_fcb_save,
+#if MYNEWT_VAL(CONFIG_TXN)
+    .csi_save_txn = conf_fcb_save_txn,
+#endif
+};
+
+static inline void
+conf_fcb_index_set(struct conf_fcb *cf, const char *name,
+                   struct fcb_entry *loc)
+{
+}
+
+static inline int
+conf_fcb_index_is_latest(struct conf_fcb *cf, const char *name,
+                         struct fcb_entry *loc)
+{
+    return -1;
+}
+
+static inline void
+conf_fcb_index_reset(struct conf_fcb *cf)
+{
+}
+
+#endif
+
+#if MYNEWT_VAL(CONFIG_TXN)
+/*
+ * Returns which transaction marker the record at loc is, or 0.
+ */
+static int
+conf_fcb_txn_mark(struct fcb_entry *loc)
+{
+    char buf[CONF_TXN_MARK_MAXLEN];
+
+    if (loc->fe_data_len > sizeof(buf) ||
+        flash_area_read(loc->fe_area, loc->fe_data_off, buf,
+          loc->fe_data_len)) {
+        return 0;
+    }
+    return conf_line_txn_mark(buf, loc->fe_data_len);
+}
+
+/*
+ * fcb_getnext() which steps over transactions without a commit marker.
+ * Markers themselves are returned, and should be skipped by the caller.
+ */
+static int
+conf_fcb_getnext(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct fcb_entry loc2;
+    int mark;
+    int rc;
+
+    rc = fcb_getnext(fcb, loc);
+    while (rc == 0 && conf_fcb_txn_mark(loc) == CONF_TXN_MARK_BEGIN) {
+        loc2 = *loc;
+        mark = 0;
+        while ((rc = fcb_getnext(fcb, &loc2)) == 0) {
+            mark = conf_fcb_txn_mark(&loc2);
+            if (mark) {
+                break;
+            }
+        }
+        if (rc || mark == CONF_TXN_MARK_COMMIT) {
+            return rc;
+        }
+        *loc = loc2;
+        if (mark == CONF_TXN_MARK_ABORT) {
+            return 0;
+        }
+        /*
+         * Another transaction begins before this one was finished.
+         */
+    }
+    return rc;
+}
+
+static int
+conf_fcb_txn_recover_cb(struct fcb_entry *loc, void *arg)
+{
+    int *markp = (int *)arg;
+    int mark;
+
+    mark = conf_fcb_txn_mark(loc);
+    if (mark) {
+        *markp = mark;
+    }
+    return 0;
+}
+
+/*
+ * If the system went down while writing a transaction, it has no commit
+ * marker. Close it with an abort marker, so that records written after
+ * it are not taken to be part of it.
+ */
+static void
+conf_fcb_txn_recover(struct conf_fcb *cf)
+{
+    const char *abort_str;
+    struct fcb_entry loc;
+    int mark;
+
+    /*
+     * A transaction is written within one sector, the active one.
+     */
+    mark = 0;
+    fcb_walk(&cf->cf_fcb, cf->cf_fcb.f_active.fe_area,
+      conf_fcb_txn_recover_cb, &mark);
+    if (mark == CONF_TXN_MARK_BEGIN) {
+        abort_str = conf_txn_marks[CONF_TXN_MARK_ABORT];
+        conf_fcb_append(&cf->cf_fcb, cf, abort_str, strlen(abort_str), &loc);
+    }
+}
+
+#else
+
+static inline int
+conf_fcb_getnext(struct fcb *fcb, struct fcb_entry *loc)
+{
+    return fcb_getnext(fcb, loc);
+}
+
+static inline void
+conf_fcb_txn_recover(struct conf_fcb *cf)
+{
+}
+
+#endif
+
 int
 conf_fcb_src(struct conf_fcb *cf)
 {
@@ -83,6 +403,8 @@ conf_fcb_src(struct conf_fcb *cf)
         }
     }
 
+    conf_fcb_index_reset(cf);
+    conf_fcb_txn_recover(cf);
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_src_register(&cf->cf_store);
 
@@ -125,7 +447,12 @@ conf_fcb_load_cb(struct fcb_entry *loc, void *arg)
     if (rc) {
         return 0;
     }
-    argp->cb(name_str, val_str, argp->cb_arg);
+    if (argp->cf) {
+        conf_fcb_index_set(argp->cf, name_str, loc);
+    }
+    if (argp->cb) {
+        argp->cb(name_str, val_str, argp->cb_arg);
+    }
     return 0;
 }
 
@@ -134,12 +461,29 @@ conf_fcb_load(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg)
 {
     struct conf_fcb *cf = (struct conf_fcb *)cs;
     struct conf_fcb_load_cb_arg arg;
+    struct fcb_entry loc;
     int rc;
 
     arg.cb = cb;
     arg.cb_arg = cb_arg;
-    rc = fcb_walk(&cf->cf_fcb, 0, conf_fcb_load_cb, &arg);
-    if (rc) {
+    arg.cf = NULL;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) > 0
+    /*
+     * Build the index while going through the records anyway.
+     */
+    if (cf->cf_index_state == CONF_FCB_INDEX_NONE) {
+        memset(cf->cf_index, 0, sizeof(cf->cf_index));
+        cf->cf_index_state = CONF_FCB_INDEX_OK;
+        arg.cf = cf;
+    }
+#endif
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while ((rc = conf_fcb_getnext(&cf->cf_fcb, &loc)) == 0) {
+        conf_fcb_load_cb(&loc, &arg);
+    }
+    if (rc != FCB_ERR_NOVAR) {
+        conf_fcb_index_reset(arg.cf);
         return OS_EINVAL;
     }
     return OS_OK;
@@ -159,8 +503,11 @@ conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
     return rc;
 }
 
+/*
+ * cf is NULL if fcb does not belong to a config store.
+ */
 static void
-conf_fcb_compress_internal(struct fcb *fcb,
+conf_fcb_compress_internal(struct fcb *fcb, struct conf_fcb *cf,
                            int (*copy_or_not)(const char *name, const char *val,
                                               void *cn_arg),
                            void *cn_arg)
@@ -181,7 +528,7 @@ conf_fcb_compress_internal(struct fcb *fcb,
 
     loc1.fe_area = NULL;
     loc1.fe_elem_off = 0;
-    while (fcb_getnext(fcb, &loc1) == 0) {
+    while (conf_fcb_getnext(fcb, &loc1) == 0) {
         if (loc1.fe_area != fcb->f_oldest) {
             break;
         }
@@ -192,16 +539,19 @@ conf_fcb_compress_internal(struct fcb *fcb,
         if (!val1) {
             continue;
         }
-        loc2 = loc1;
-        copy = 1;
-        while (fcb_getnext(fcb, &loc2) == 0) {
-            rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
-            if (rc) {
-                continue;
-            }
-            if (!strcmp(name1, name2)) {
-                copy = 0;
-                break;
+        copy = conf_fcb_index_is_latest(cf, name1, &loc1);
+        if (copy < 0) {
+            loc2 = loc1;
+            copy = 1;
+            while (conf_fcb_getnext(fcb, &loc2) == 0) {
+                rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
+                if (rc) {
+                    continue;
+                }
+                if (!strcmp(name1, name2)) {
+                    copy = 0;
+                    break;
+                }
             }
         }
         if (!copy) {
@@ -238,43 +588,148 @@ conf_fcb_compress_internal(struct fcb *fcb,
         /* XXXX */
         ;
     }
+
+    /*
+     * Records left in the erased sector are gone; rebuild when needed.
+     */
+    conf_fcb_index_reset(cf);
 }
 
 static int
-conf_fcb_append(struct fcb *fcb, char *buf, int len)
+conf_fcb_append(struct fcb *fcb, struct conf_fcb *cf, const char *buf,
+                int len, struct fcb_entry *loc)
 {
     int rc;
     int i;
-    struct fcb_entry loc;
 
     for (i = 0; i < 10; i++) {
-        rc = fcb_append(fcb, len, &loc);
+        rc = fcb_append(fcb, len, loc);
         if (rc != FCB_ERR_NOSPACE) {
             break;
         }
         if (fcb->f_scratch_cnt == 0) {
             return OS_ENOMEM;
         }
-        conf_fcb_compress_internal(fcb, NULL, NULL);
+        conf_fcb_compress_internal(fcb, cf, NULL, NULL);
     }
     if (rc) {
         return OS_EINVAL;
     }
-    rc = flash_area_write(loc.fe_area, loc.fe_data_off, buf, len);
+    rc = flash_area_write(loc->fe_area, loc->fe_data_off, buf, len);
     if (rc) {
         return OS_EINVAL;
     }
-    fcb_append_finish(fcb, &loc);
+    fcb_append_finish(fcb, loc);
+    loc->fe_data_len = len;
     return OS_OK;
 }
 
+static int
+conf_fcb_save_internal(struct fcb *fcb, struct conf_fcb *cf, const char *name,
+                       const char *value)
+{
+    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    struct fcb_entry loc;
+    int len;
+    int rc;
+
+    if (!name) {
+        return OS_INVALID_PARM;
+    }
+
+    len = conf_line_make(buf, sizeof(buf), name, value);
+    if (len < 0 || len + 2 > sizeof(buf)) {
+        return OS_INVALID_PARM;
+    }
+    rc = conf_fcb_append(fcb, cf, buf, len, &loc);
+    if (rc == 0 && cf) {
+        conf_fcb_index_set(cf, name, &loc);
+    }
+    return rc;
+}
+
 static int
 conf_fcb_save(struct conf_store *cs, const char *name, const char *value)
 {
     struct conf_fcb *cf = (struct conf_fcb *)cs;
 
-    return conf_fcb_kv_save(&cf->cf_fcb, name, value);
+    return conf_fcb_save_internal(&cf->cf_fcb, cf, name, value);
+}
+
+#if MYNEWT_VAL(CONFIG_TXN)
+/*
+ * Transaction is written as begin marker, values and commit marker, with a
+ * single fcb_append_batch(). If it gets interrupted, there is no commit
+ * marker and the values are ignored.
+ */
+static int
+conf_fcb_save_txn(struct conf_store *cs, const char *lines, int len,
+                  int cnt)
+{
+    static struct fcb_batch_elem elems[MYNEWT_VAL(CONFIG_TXN_MAX_CNT) + 2];
+    static struct fcb_entry locs[MYNEWT_VAL(CONFIG_TXN_MAX_CNT) + 2];
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+    struct fcb *fcb = &cf->cf_fcb;
+    char name[CONF_MAX_NAME_LEN + 1];
+    const char *mark_str;
+    const char *eol;
+    int rc;
+    int i;
+
+    if (cnt > MYNEWT_VAL(CONFIG_TXN_MAX_CNT)) {
+        return OS_ENOMEM;
+    }
+    elems[0].fbe_data = conf_txn_marks[CONF_TXN_MARK_BEGIN];
+    elems[0].fbe_len = strlen(elems[0].fbe_data);
+    for (i = 1; i <= cnt; i++) {
+        eol = memchr(lines, '\n', len);
+        if (!eol) {
+            return OS_INVALID_PARM;
+        }
+        elems[i].fbe_data = lines;
+        elems[i].fbe_len = eol - lines;
+        len -= elems[i].fbe_len + 1;
+        lines = eol + 1;
+    }
+    elems[i].fbe_data = conf_txn_marks[CONF_TXN_MARK_COMMIT];
+    elems[i].fbe_len = strlen(elems[i].fbe_data);
+
+    for (i = 0; i < 10; i++) {
+        rc = fcb_append_batch(fcb, elems, cnt + 2, locs);
+        if (rc != FCB_ERR_NOSPACE) {
+            break;
+        }
+        if (fcb->f_scratch_cnt == 0) {
+            return OS_ENOMEM;
+        }
+        conf_fcb_compress_internal(fcb, cf, NULL, NULL);
+    }
+    if (rc == FCB_ERR_NOSPACE) {
+        return OS_ENOMEM;
+    }
+    if (rc) {
+        /*
+         * Part of the transaction might have made it to flash.
+         */
+        mark_str = conf_txn_marks[CONF_TXN_MARK_ABORT];
+        conf_fcb_append(fcb, cf, mark_str, strlen(mark_str), &locs[0]);
+        return OS_EINVAL;
+    }
+
+    for (i = 1; i <= cnt; i++) {
+        eol = memchr(elems[i].fbe_data, '=', elems[i].fbe_len);
+        len = eol ? eol - (const char *)elems[i].fbe_data : -1;
+        if (len < 0 || len >= sizeof(name)) {
+            conf_fcb_index_reset(cf);
+            break;
+        }
+        memcpy(name, elems[i].fbe_data, len);
+        name[len] = '\0';
+        conf_fcb_index_set(cf, name, &locs[i]);
+    }
+    return OS_OK;
 }
+#endif
 
 void
 conf_fcb_compress(struct conf_fcb *cf,
@@ -282,7 +737,7 @@ conf_fcb_compress(struct conf_fcb *cf,
                                      void *cn_arg),
                   void *cn_arg)
 {
-    conf_fcb_compress_internal(&cf->cf_fcb, copy_or_not, cn_arg);
+    conf_fcb_compress_internal(&cf->cf_fcb, cf, copy_or_not, cn_arg);
 }
 
 static int
@@ -315,6 +770,10 @@ conf_kv_load_cb(struct fcb_entry *loc, void *arg)
         return 0;
     }
 
+    if (!val_str) {
+        cb_arg->value[0] = '\0';
+        return 0;
+    }
     strncpy(cb_arg->value, val_str, cb_arg->len);
     cb_arg->value[cb_arg->len - 1] = '\0';
 
@@ -342,18 +801,7 @@ conf_fcb_kv_load(struct fcb *fcb, const char *name, char *value, size_t len)
 int
 conf_fcb_kv_save(struct fcb *fcb, const char *name, const char *value)
 {
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    int len;
-
-    if (!name) {
-        return OS_INVALID_PARM;
-    }
-
-    len = conf_line_make(buf, sizeof(buf), name, value);
-    if (len < 0 || len + 2 > sizeof(buf)) {
-        return OS_INVALID_PARM;
-    }
-    return conf_fcb_append(fcb, buf, len);
+    return conf_fcb_save_internal(fcb, NULL, name, value);
 }
 
 #endif
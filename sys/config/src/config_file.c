@@ -34,10 +34,17 @@ static int conf_file_load(struct conf_store *, conf_store_load_cb cb,
                           void *cb_arg);
 static int conf_file_save(struct conf_store *, const char *name,
   const char *value);
+#if MYNEWT_VAL(CONFIG_TXN)
+static int conf_file_save_txn(struct conf_store *, const char *lines,
+  int len, int cnt);
+#endif
 
 static struct conf_store_itf conf_file_itf = {
     .csi_load = conf_file_load,
     .csi_save = conf_file_save,
+#if MYNEWT_VAL(CONFIG_TXN)
+    .csi_save_txn = conf_file_save_txn,
+#endif
 };
 
 /*
@@ -100,6 +107,146 @@ conf_getnext_line(struct fs_file *file, char *buf, int blen, uint32_t *loc)
     return blen;
 }
 
+#if MYNEWT_VAL(CONFIG_TXN)
+/*
+ * conf_getnext_line() which steps over transactions without a commit
+ * marker. Markers themselves are returned, and should be skipped by the
+ * caller.
+ */
+static int
+conf_file_getnext(struct fs_file *file, char *buf, int blen, uint32_t *loc)
+{
+    uint32_t start;
+    uint32_t prev;
+    uint32_t loc2;
+    int mark;
+    int rc;
+
+    while (1) {
+        rc = conf_getnext_line(file, buf, blen, loc);
+        if (*loc == 0 || conf_line_txn_mark(buf, rc) != CONF_TXN_MARK_BEGIN) {
+            return rc;
+        }
+        start = *loc;
+        loc2 = *loc;
+        do {
+            prev = loc2;
+            rc = conf_getnext_line(file, buf, blen, &loc2);
+            if (loc2 == 0) {
+                *loc = 0;
+                return rc;
+            }
+            mark = conf_line_txn_mark(buf, rc);
+        } while (!mark);
+        if (mark == CONF_TXN_MARK_COMMIT) {
+            *loc = start;
+            return rc;
+        }
+        if (mark == CONF_TXN_MARK_ABORT) {
+            *loc = loc2;
+            return rc;
+        }
+        /*
+         * Another transaction begins before this one was finished.
+         */
+        *loc = prev;
+    }
+}
+
+static int
+conf_file_write_mark(struct fs_file *file, int mark)
+{
+    char buf[CONF_TXN_MARK_MAXLEN + 1];
+    int len;
+
+    len = strlen(conf_txn_marks[mark]);
+    memcpy(buf, conf_txn_marks[mark], len);
+    buf[len++] = '\n';
+    return fs_write(file, buf, len);
+}
+
+/*
+ * If the system went down while writing a transaction, it has no commit
+ * marker. Close it with an abort marker before anything else is appended,
+ * so that later lines are not taken to be part of it.
+ */
+static void
+conf_file_txn_recover(struct conf_file *cf)
+{
+    struct fs_file *file;
+    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    uint32_t flen;
+    uint32_t loc;
+    uint32_t end;
+    int mark;
+    int rc;
+
+    if (cf->cf_txn_checked) {
+        return;
+    }
+    if (fs_open(cf->cf_name, FS_ACCESS_READ, &file)) {
+        /*
+         * Nothing to recover.
+         */
+        cf->cf_txn_checked = 1;
+        return;
+    }
+    loc = 0;
+    mark = 0;
+    while (1) {
+        end = loc;
+        rc = conf_getnext_line(file, buf, sizeof(buf), &loc);
+        if (loc == 0) {
+            break;
+        }
+        rc = conf_line_txn_mark(buf, rc);
+        if (rc) {
+            mark = rc;
+        }
+    }
+    if (fs_filelen(file, &flen)) {
+        flen = end;
+    }
+    fs_close(file);
+    if (mark != CONF_TXN_MARK_BEGIN) {
+        cf->cf_txn_checked = 1;
+        return;
+    }
+
+    if (fs_open(cf->cf_name, FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file)) {
+        return;
+    }
+    rc = 0;
+    if (end > flen) {
+        /*
+         * Last line was cut short.
+         */
+        rc = fs_write(file, "\n", 1);
+    }
+    if (!rc) {
+        rc = conf_file_write_mark(file, CONF_TXN_MARK_ABORT);
+    }
+    if (!rc) {
+        cf->cf_txn_checked = 1;
+    }
+    fs_close(file);
+}
+
+#else
+
+static inline int
+conf_file_getnext(struct fs_file *file, char *buf, int blen, uint32_t *loc)
+{
+    return conf_getnext_line(file, buf, blen, loc);
+}
+
+static inline void
+conf_file_txn_recover(struct conf_file *cf)
+{
+}
+
+#endif
+
 /*
  * Called to load configuration items. cb must be called for every configuration
  * item found.
@@ -124,7 +271,7 @@ conf_file_load(struct conf_store *cs, conf_store_load_cb cb, void *cb_arg)
     loc = 0;
     lines = 0;
     while (1) {
-        rc = conf_getnext_line(file, tmpbuf, sizeof(tmpbuf), &loc);
+        rc = conf_file_getnext(file, tmpbuf, sizeof(tmpbuf), &loc);
         if (loc == 0) {
             break;
         }
@@ -190,7 +337,7 @@ conf_file_compress(struct conf_file *cf)
     loc1 = 0;
     lines = 0;
     while (1) {
-        len = conf_getnext_line(rf, buf1, sizeof(buf1), &loc1);
+        len = conf_file_getnext(rf, buf1, sizeof(buf1), &loc1);
         if (loc1 == 0 || len < 0) {
             break;
         }
@@ -203,7 +350,7 @@ conf_file_compress(struct conf_file *cf)
         }
         loc2 = loc1;
         copy = 1;
-        while ((len2 = conf_getnext_line(rf, buf2, sizeof(buf2), &loc2)) > 0) {
+        while ((len2 = conf_file_getnext(rf, buf2, sizeof(buf2), &loc2)) > 0) {
             rc = conf_line_parse(buf2, &name2, &val2);
             if (rc) {
                 continue;
@@ -255,6 +402,7 @@ conf_file_save(struct conf_store *cs, const char *name, const char *value)
         return OS_INVALID_PARM;
     }
 
+    conf_file_txn_recover(cf);
     if (cf->cf_maxlines && (cf->cf_lines + 1 >= cf->cf_maxlines)) {
         /*
          * Compress before config file size exceeds the max number of lines.
@@ -283,4 +431,46 @@ conf_file_save(struct conf_store *cs, const char *name, const char *value)
     return rc;
 }
 
+#if MYNEWT_VAL(CONFIG_TXN)
+/*
+ * Transaction is appended as begin marker, values and commit marker. If it
+ * gets interrupted, there is no commit marker and the values are ignored.
+ */
+static int
+conf_file_save_txn(struct conf_store *cs, const char *lines, int len,
+                   int cnt)
+{
+    struct conf_file *cf = (struct conf_file *)cs;
+    struct fs_file *file;
+    int rc;
+
+    conf_file_txn_recover(cf);
+    if (cf->cf_maxlines && (cf->cf_lines + cnt >= cf->cf_maxlines)) {
+        conf_file_compress(cf);
+    }
+    if (fs_open(cf->cf_name, FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file)) {
+        return OS_EINVAL;
+    }
+    rc = conf_file_write_mark(file, CONF_TXN_MARK_BEGIN);
+    if (!rc) {
+        rc = fs_write(file, lines, len);
+    }
+    if (!rc) {
+        rc = conf_file_write_mark(file, CONF_TXN_MARK_COMMIT);
+    }
+    if (rc) {
+        /*
+         * Part of the transaction might have made it to the file.
+         */
+        fs_write(file, "\n", 1);
+        conf_file_write_mark(file, CONF_TXN_MARK_ABORT);
+        rc = OS_EINVAL;
+    } else {
+        cf->cf_lines += cnt;
+    }
+    fs_close(file);
+    return rc;
+}
+#endif
+
 #endif
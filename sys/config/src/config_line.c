@@ -97,3 +97,30 @@ conf_line_make(char *dst, int dlen, const char *name, const char *value)
 
     return off;
 }
+
+const char * const conf_txn_marks[] = {
+    [CONF_TXN_MARK_BEGIN] = "#txn-begin",
+    [CONF_TXN_MARK_COMMIT] = "#txn-commit",
+    [CONF_TXN_MARK_ABORT] = "#txn-abort",
+};
+
+/*
+ * Returns which transaction marker the len bytes in buf are, or 0 if they
+ * are not one.
+ */
+int
+conf_line_txn_mark(const char *buf, int len)
+{
+    int i;
+
+    if (len > CONF_TXN_MARK_MAXLEN || len <= 0 || buf[0] != '#') {
+        return 0;
+    }
+    for (i = CONF_TXN_MARK_BEGIN; i <= CONF_TXN_MARK_ABORT; i++) {
+        if ((int)strlen(conf_txn_marks[i]) == len &&
+            !memcmp(buf, conf_txn_marks[i], len)) {
+            return i;
+        }
+    }
+    return 0;
+}
@@ -37,6 +37,18 @@ struct mgmt_cbuf;
 int conf_line_parse(char *buf, char **namep, char **valp);
 int conf_line_make(char *dst, int dlen, const char *name, const char *val);
 int conf_line_make2(char *dst, int dlen, const char *name, const char *value);
+
+/*
+ * Records delimiting a transaction in storage. They have no '=', so
+ * conf_line_parse() skips them.
+ */
+#define CONF_TXN_MARK_BEGIN     1
+#define CONF_TXN_MARK_COMMIT    2
+#define CONF_TXN_MARK_ABORT     3
+#define CONF_TXN_MARK_MAXLEN    11
+extern const char * const conf_txn_marks[];
+int conf_line_txn_mark(const char *buf, int len);
+
 struct conf_handler *conf_parse_and_lookup(char *name, int *name_argc,
                                            char *name_argv[]);
 
@@ -42,6 +42,22 @@ struct conf_store *conf_save_dst;
 static bool conf_loading;
 static bool conf_loaded;
 
+#if MYNEWT_VAL(CONFIG_TXN)
+
+#define CONF_TXN_NONE           0
+#define CONF_TXN_OPEN           1
+#define CONF_TXN_OVERFLOW       2   /* Values did not fit; commit fails */
+
+/*
+ * Values of the open transaction, as "name=value" lines each terminated
+ * by '\0'.  Only accessed with the config lock held.
+ */
+static uint8_t conf_txn_state;
+static int conf_txn_cnt;
+static int conf_txn_len;
+static char conf_txn_buf[MYNEWT_VAL(CONFIG_TXN_BUF_SIZE)];
+#endif
+
 void
 conf_src_register(struct conf_store *cs)
 {
@@ -111,6 +127,23 @@ conf_set_from_storage(void)
     return conf_loading;
 }
 
+/*
+ * Report the stored values of name to cb, in the order conf_load() would
+ * apply them.
+ */
+static void
+conf_load_name(const char *name, conf_store_load_cb cb, void *cb_arg)
+{
+    struct conf_store *cs;
+
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        if (!cs->cs_itf->csi_lookup ||
+            cs->cs_itf->csi_lookup(cs, name, cb, cb_arg)) {
+            cs->cs_itf->csi_load(cs, cb, cb_arg);
+        }
+    }
+}
+
 static void
 conf_get_value_cb(char *name, char *val, void *cb_arg)
 {
@@ -130,7 +163,6 @@ conf_get_value_cb(char *name, char *val, void *cb_arg)
 int
 conf_get_stored_value(char *name, char *buf, int buf_len)
 {
-    struct conf_store *cs;
     struct conf_get_val_arg cgva;
     int val_len;
 
@@ -143,9 +175,7 @@ conf_get_stored_value(char *name, char *buf, int buf_len)
      * for every config store
      */
     conf_lock();
-    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_get_value_cb, &cgva);
-    }
+    conf_load_name(name, conf_get_value_cb, &cgva);
     conf_unlock();
 
     if (!cgva.seen) {
@@ -182,6 +212,66 @@ conf_dup_check_cb(char *name, char *val, void *cb_arg)
     }
 }
 
+#if MYNEWT_VAL(CONFIG_TXN)
+/*
+ * Returns the offset of the line of name in the transaction buffer, or -1.
+ */
+static int
+conf_txn_find(const char *name)
+{
+    int nlen;
+    int off;
+
+    nlen = strlen(name);
+    for (off = 0; off < conf_txn_len; off += strlen(&conf_txn_buf[off]) + 1) {
+        if (!strncmp(&conf_txn_buf[off], name, nlen) &&
+            conf_txn_buf[off + nlen] == '=') {
+            return off;
+        }
+    }
+    return -1;
+}
+
+static void
+conf_txn_remove(int off)
+{
+    int len;
+
+    len = strlen(&conf_txn_buf[off]) + 1;
+    memmove(&conf_txn_buf[off], &conf_txn_buf[off + len],
+      conf_txn_len - off - len);
+    conf_txn_len -= len;
+    conf_txn_cnt--;
+}
+
+static int
+conf_txn_add(const char *name, const char *value)
+{
+    int off;
+    int len;
+
+    if (conf_txn_state == CONF_TXN_OVERFLOW) {
+        return OS_ENOMEM;
+    }
+    off = conf_txn_find(name);
+    if (off >= 0) {
+        conf_txn_remove(off);
+    }
+    len = -1;
+    if (conf_txn_cnt < MYNEWT_VAL(CONFIG_TXN_MAX_CNT)) {
+        len = conf_line_make(&conf_txn_buf[conf_txn_len],
+          sizeof(conf_txn_buf) - conf_txn_len, name, value);
+    }
+    if (len < 0) {
+        conf_txn_state = CONF_TXN_OVERFLOW;
+        return OS_ENOMEM;
+    }
+    conf_txn_len += len + 1;
+    conf_txn_cnt++;
+    return 0;
+}
+#endif
+
 /*
  * Append a single value to persisted config. Don't store duplicate value.
  */
@@ -198,15 +288,23 @@ conf_save_one(const char *name, char *value)
         goto out;
     }
 
+#if MYNEWT_VAL(CONFIG_TXN)
+    /*
+     * With the lock held, a transaction can only be open in this task.
+     */
+    if (conf_txn_state != CONF_TXN_NONE) {
+        rc = conf_txn_add(name, value);
+        goto out;
+    }
+#endif
+
     /*
      * Check if we're writing the same value again.
      */
     cdca.name = name;
     cdca.val = value;
     cdca.is_dup = 0;
-    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
-    }
+    conf_load_name(name, conf_dup_check_cb, &cdca);
     if (cdca.is_dup == 1) {
         rc = 0;
         goto out;
@@ -218,6 +316,122 @@ out:
     return rc;
 }
 
+#if MYNEWT_VAL(CONFIG_TXN)
+/*
+ * Close the transaction, and let other tasks in again.
+ */
+static void
+conf_txn_end(void)
+{
+    conf_txn_state = CONF_TXN_NONE;
+    conf_txn_cnt = 0;
+    conf_txn_len = 0;
+    conf_unlock();
+}
+
+int
+conf_txn_begin(void)
+{
+    /*
+     * Config lock is held until the transaction ends.
+     */
+    conf_lock();
+    if (conf_txn_state != CONF_TXN_NONE) {
+        conf_unlock();
+        return OS_EBUSY;
+    }
+    conf_txn_state = CONF_TXN_OPEN;
+    return 0;
+}
+
+int
+conf_txn_commit(void)
+{
+    struct conf_store *cs;
+    struct conf_dup_check_arg cdca;
+    char *eq;
+    int off;
+    int len;
+    int rc;
+    int rc2;
+
+    conf_lock();
+    if (conf_txn_state == CONF_TXN_NONE) {
+        conf_unlock();
+        return OS_EINVAL;
+    }
+    if (conf_txn_state == CONF_TXN_OVERFLOW) {
+        rc = OS_ENOMEM;
+        goto out;
+    }
+    cs = conf_save_dst;
+    if (!cs) {
+        rc = OS_ENOENT;
+        goto out;
+    }
+
+    /*
+     * Leave out values which are stored already.
+     */
+    off = 0;
+    while (off < conf_txn_len) {
+        eq = strchr(&conf_txn_buf[off], '=');
+        *eq = '\0';
+        cdca.name = &conf_txn_buf[off];
+        cdca.val = eq + 1;
+        cdca.is_dup = 0;
+        conf_load_name(cdca.name, conf_dup_check_cb, &cdca);
+        *eq = '=';
+        if (cdca.is_dup == 1) {
+            conf_txn_remove(off);
+        } else {
+            off += strlen(&conf_txn_buf[off]) + 1;
+        }
+    }
+
+    if (conf_txn_cnt == 0) {
+        rc = 0;
+    } else if (cs->cs_itf->csi_save_txn) {
+        for (off = 0; off < conf_txn_len; off++) {
+            if (conf_txn_buf[off] == '\0') {
+                conf_txn_buf[off] = '\n';
+            }
+        }
+        rc = cs->cs_itf->csi_save_txn(cs, conf_txn_buf, conf_txn_len,
+          conf_txn_cnt);
+    } else {
+        rc = 0;
+        for (off = 0; off < conf_txn_len; off += len + 1) {
+            len = strlen(&conf_txn_buf[off]);
+            eq = strchr(&conf_txn_buf[off], '=');
+            *eq = '\0';
+            rc2 = cs->cs_itf->csi_save(cs, &conf_txn_buf[off], eq + 1);
+            *eq = '=';
+            if (!rc) {
+                rc = rc2;
+            }
+        }
+    }
+out:
+    conf_txn_end();
+    conf_unlock();
+    return rc;
+}
+
+int
+conf_txn_abort(void)
+{
+    conf_lock();
+    if (conf_txn_state == CONF_TXN_NONE) {
+        conf_unlock();
+        return OS_EINVAL;
+    }
+    conf_txn_end();
+    conf_unlock();
+    return 0;
+}
+#endif
+
 static void
 conf_store_one(char *name, char *value)
 {
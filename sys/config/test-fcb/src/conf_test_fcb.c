@@ -334,6 +334,8 @@ TEST_CASE_DECL(config_test_compress_reset)
 TEST_CASE_DECL(config_test_save_one_fcb)
 TEST_CASE_DECL(config_test_custom_compress)
 TEST_CASE_DECL(config_test_get_stored_fcb)
+TEST_CASE_DECL(config_test_fcb_index)
+TEST_CASE_DECL(config_test_fcb_txn)
 
 TEST_SUITE(config_test_all)
 {
@@ -367,6 +369,8 @@ TEST_SUITE(config_test_all)
 
     config_test_save_one_fcb();
     config_test_get_stored_fcb();
+    config_test_fcb_index();
+    config_test_fcb_txn();
 }
 
 #if MYNEWT_VAL(SELFTEST)
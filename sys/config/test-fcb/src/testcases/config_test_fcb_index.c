@@ -0,0 +1,199 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <crc/crc16.h>
+#include "conf_test_fcb.h"
+#include "config/config_generic_kv.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) > 0
+#define CONF_TEST_INDEX_CNT     200
+
+static void
+config_test_index_check(struct conf_fcb *cf, const char *name,
+                        const char *val)
+{
+    char buf1[CONF_MAX_VAL_LEN];
+    char buf2[CONF_MAX_VAL_LEN];
+    int rc;
+
+    rc = conf_get_stored_value((char *)name, buf1, sizeof(buf1));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!strcmp(buf1, val));
+    if (val[0] == '\0') {
+        return;
+    }
+
+    /*
+     * Compare the indexed lookup against a plain walk of the FCB.
+     */
+    buf2[0] = '\0';
+    rc = conf_fcb_kv_load(&cf->cf_fcb, name, buf2, sizeof(buf2));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!strcmp(buf2, val));
+}
+
+static void
+config_test_index_save_all(const char *fmt, int cnt, int round)
+{
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    int rc;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        snprintf(name, sizeof(name), fmt, i);
+        snprintf(val, sizeof(val), "%d", i + round);
+        rc = conf_save_one(name, val);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+}
+
+static void
+config_test_index_check_all(struct conf_fcb *cf, const char *fmt, int cnt,
+                            int round)
+{
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        snprintf(name, sizeof(name), fmt, i);
+        snprintf(val, sizeof(val), "%d", i + round);
+        config_test_index_check(cf, name, val);
+    }
+}
+
+static void
+config_test_index_no_write(struct conf_fcb *cf, const char *name,
+                           char *val)
+{
+    struct fcb_entry active;
+    int rc;
+
+    active = cf->cf_fcb.f_active;
+    rc = conf_save_one(name, val);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf->cf_fcb.f_active.fe_area == active.fe_area);
+    TEST_ASSERT(cf->cf_fcb.f_active.fe_elem_off == active.fe_elem_off);
+}
+#endif
+
+TEST_CASE(config_test_fcb_index)
+{
+#if MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) > 0
+    struct conf_fcb cf;
+    struct fcb_entry active;
+    char name[CONF_MAX_NAME_LEN];
+    uint16_t hash;
+    int round;
+    int rc;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    config_test_index_save_all("idx/%d", CONF_TEST_INDEX_CNT, 0);
+    config_test_index_check_all(&cf, "idx/%d", CONF_TEST_INDEX_CNT, 0);
+
+    /*
+     * Saving the same values again does not write anything.
+     */
+    active = cf.cf_fcb.f_active;
+    config_test_index_save_all("idx/%d", CONF_TEST_INDEX_CNT, 0);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_area == active.fe_area);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_elem_off == active.fe_elem_off);
+
+    /*
+     * Deleted values.
+     */
+    rc = conf_save_one("idx/1", NULL);
+    TEST_ASSERT(rc == 0);
+    config_test_index_check(&cf, "idx/1", "");
+    config_test_index_no_write(&cf, "idx/1", NULL);
+    config_test_index_no_write(&cf, "idx/1", "");
+
+    /*
+     * Names with the same hash are told apart.
+     */
+    hash = crc16_ccitt(0, "idx/0", strlen("idx/0"));
+    for (i = 0; ; i++) {
+        snprintf(name, sizeof(name), "hc/%d", i);
+        if (crc16_ccitt(0, name, strlen(name)) == hash) {
+            break;
+        }
+    }
+    rc = conf_save_one(name, "collide");
+    TEST_ASSERT(rc == 0);
+    config_test_index_check(&cf, name, "collide");
+    config_test_index_check(&cf, "idx/0", "0");
+    config_test_index_no_write(&cf, name, "collide");
+    config_test_index_no_write(&cf, "idx/0", "0");
+
+    /*
+     * Keep rewriting every value, so that the FCB gets compressed a few
+     * times.  Only the latest values survive.
+     */
+    for (round = 1; round < 20; round++) {
+        config_test_index_save_all("idx/%d", CONF_TEST_INDEX_CNT, round);
+    }
+    round--;
+    config_test_index_check_all(&cf, "idx/%d", CONF_TEST_INDEX_CNT, round);
+    config_test_index_check(&cf, name, "collide");
+    config_test_index_no_write(&cf, "idx/7", "26");
+
+    /*
+     * Values are found again after a reboot.
+     */
+    config_wipe_srcs();
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+
+    config_test_index_check_all(&cf, "idx/%d", CONF_TEST_INDEX_CNT, round);
+    config_test_index_no_write(&cf, "idx/7", "26");
+
+    /*
+     * More names than the index can hold.
+     */
+    config_test_index_save_all("ovf/%d",
+      MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) + 8, 0);
+    config_test_index_check_all(&cf, "ovf/%d",
+      MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE) + 8, 0);
+    config_test_index_check_all(&cf, "idx/%d", CONF_TEST_INDEX_CNT, round);
+    config_test_index_no_write(&cf, "ovf/3", "3");
+    config_test_index_no_write(&cf, "idx/7", "26");
+#endif
+}
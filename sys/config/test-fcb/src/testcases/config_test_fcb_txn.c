@@ -0,0 +1,276 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+#include "config/config_generic_kv.h"
+
+#if MYNEWT_VAL(CONFIG_TXN)
+struct config_test_txn_walk_arg {
+    int cnt;
+    char last[32];
+};
+
+static void
+config_test_txn_mount(struct conf_fcb *cf)
+{
+    int rc;
+
+    config_wipe_srcs();
+    memset(cf, 0, sizeof(*cf));
+    cf->cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf->cf_fcb.f_sectors = fcb_areas;
+    cf->cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(cf);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_fcb_dst(cf);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+config_test_txn_check(const char *name, const char *val)
+{
+    char buf[CONF_MAX_VAL_LEN];
+    int rc;
+
+    rc = conf_get_stored_value((char *)name, buf, sizeof(buf));
+    if (!val) {
+        TEST_ASSERT(rc == OS_ENOENT);
+        return;
+    }
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!strcmp(buf, val));
+}
+
+/*
+ * Write a raw record, as an interrupted commit would have left it.
+ */
+static void
+config_test_txn_append(struct conf_fcb *cf, const char *str)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    rc = fcb_append(&cf->cf_fcb, strlen(str), &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, str, strlen(str));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fcb_append_finish(&cf->cf_fcb, &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static int
+config_test_txn_walk_cb(struct fcb_entry *loc, void *arg)
+{
+    struct config_test_txn_walk_arg *cta = arg;
+    int len;
+    int rc;
+
+    len = loc->fe_data_len;
+    if (len >= sizeof(cta->last)) {
+        len = sizeof(cta->last) - 1;
+    }
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off, cta->last, len);
+    TEST_ASSERT(rc == 0);
+    cta->last[len] = '\0';
+    cta->cnt++;
+    return 0;
+}
+
+static void
+config_test_txn_walk(struct conf_fcb *cf, struct config_test_txn_walk_arg *cta)
+{
+    int rc;
+
+    memset(cta, 0, sizeof(*cta));
+    rc = fcb_walk(&cf->cf_fcb, NULL, config_test_txn_walk_cb, cta);
+    TEST_ASSERT(rc == 0);
+}
+#endif
+
+TEST_CASE(config_test_fcb_txn)
+{
+#if MYNEWT_VAL(CONFIG_TXN)
+    struct config_test_txn_walk_arg cta;
+    struct conf_fcb cf;
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    uint16_t active_id;
+    int round;
+    int rc;
+    int i;
+
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+    config_test_txn_mount(&cf);
+
+    /*
+     * Nothing is written before commit, and only the last value of a name
+     * is written then.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_txn_begin();
+    TEST_ASSERT(rc == OS_EBUSY);
+    rc = conf_save_one("txn/a", "1");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/b", "2");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/a", "3");
+    TEST_ASSERT(rc == 0);
+    config_test_txn_walk(&cf, &cta);
+    TEST_ASSERT(cta.cnt == 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == 0);
+
+    config_test_txn_walk(&cf, &cta);
+    TEST_ASSERT(cta.cnt == 4);
+    TEST_ASSERT(!strcmp(cta.last, "#txn-commit"));
+    config_test_txn_check("txn/a", "3");
+    config_test_txn_check("txn/b", "2");
+
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    /*
+     * Values which are stored already are left out.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_save_one("txn/a", "3");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/b", "4");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/b", "2");
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == 0);
+    config_test_txn_walk(&cf, &cta);
+    TEST_ASSERT(cta.cnt == 4);
+
+    /*
+     * Aborted transaction.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_save_one("txn/a", "5");
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_abort();
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_abort();
+    TEST_ASSERT(rc == OS_EINVAL);
+    config_test_txn_check("txn/a", "3");
+
+    /*
+     * Transaction which does not fit is not written at all.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i <= MYNEWT_VAL(CONFIG_TXN_MAX_CNT); i++) {
+        snprintf(name, sizeof(name), "ovf/%d", i);
+        rc = conf_save_one(name, "1");
+        if (i < MYNEWT_VAL(CONFIG_TXN_MAX_CNT)) {
+            TEST_ASSERT(rc == 0);
+        } else {
+            TEST_ASSERT(rc == OS_ENOMEM);
+        }
+    }
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == OS_ENOMEM);
+    config_test_txn_walk(&cf, &cta);
+    TEST_ASSERT(cta.cnt == 4);
+    config_test_txn_check("ovf/0", NULL);
+
+    /*
+     * Commit which got interrupted; none of its values are loaded, and
+     * it is closed at mount.
+     */
+    config_test_txn_append(&cf, "#txn-begin");
+    config_test_txn_append(&cf, "txn/a=9");
+    config_test_txn_append(&cf, "txn/c=9");
+    config_test_txn_mount(&cf);
+    config_test_txn_walk(&cf, &cta);
+    TEST_ASSERT(cta.cnt == 8);
+    TEST_ASSERT(!strcmp(cta.last, "#txn-abort"));
+    config_test_txn_check("txn/a", "3");
+    config_test_txn_check("txn/c", NULL);
+
+    /*
+     * Values saved after it are loaded.
+     */
+    rc = conf_save_one("txn/d", "1");
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_save_one("txn/e", "1");
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == 0);
+    config_test_txn_mount(&cf);
+    config_test_txn_check("txn/a", "3");
+    config_test_txn_check("txn/c", NULL);
+    config_test_txn_check("txn/d", "1");
+    config_test_txn_check("txn/e", "1");
+
+    /*
+     * Interrupted commit followed by another transaction without a mount
+     * in between.
+     */
+    config_test_txn_append(&cf, "#txn-begin");
+    config_test_txn_append(&cf, "txn/b=9");
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_save_one("txn/e", "2");
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == 0);
+    config_test_txn_mount(&cf);
+    config_test_txn_check("txn/b", "2");
+    config_test_txn_check("txn/e", "2");
+
+    /*
+     * Keep committing until the FCB has been compressed a few times.
+     */
+    active_id = cf.cf_fcb.f_active_id;
+    for (round = 0; round < 500; round++) {
+        rc = conf_txn_begin();
+        TEST_ASSERT_FATAL(rc == 0);
+        for (i = 0; i < MYNEWT_VAL(CONFIG_TXN_MAX_CNT); i++) {
+            snprintf(name, sizeof(name), "cmp/%d", i);
+            snprintf(val, sizeof(val), "%d", round + i);
+            rc = conf_save_one(name, val);
+            TEST_ASSERT(rc == 0);
+        }
+        rc = conf_txn_commit();
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(cf.cf_fcb.f_active_id > active_id + cf.cf_fcb.f_sector_cnt);
+
+    config_test_txn_mount(&cf);
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < MYNEWT_VAL(CONFIG_TXN_MAX_CNT); i++) {
+        snprintf(name, sizeof(name), "cmp/%d", i);
+        snprintf(val, sizeof(val), "%d", round - 1 + i);
+        config_test_txn_check(name, val);
+    }
+    config_test_txn_check("txn/a", "3");
+    config_test_txn_check("txn/b", "2");
+    config_test_txn_check("txn/c", NULL);
+    config_test_txn_check("txn/e", "2");
+#endif
+}
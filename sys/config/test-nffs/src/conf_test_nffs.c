@@ -340,6 +340,7 @@ TEST_CASE_DECL(config_test_multiple_in_file)
 TEST_CASE_DECL(config_test_save_in_file)
 TEST_CASE_DECL(config_test_save_one_file)
 TEST_CASE_DECL(config_test_get_stored_file)
+TEST_CASE_DECL(config_test_txn_file)
 
 TEST_SUITE(config_test_all)
 {
@@ -367,6 +368,7 @@ TEST_SUITE(config_test_all)
 
     config_test_save_one_file();
     config_test_get_stored_file();
+    config_test_txn_file();
 }
 
 #if MYNEWT_VAL(SELFTEST)
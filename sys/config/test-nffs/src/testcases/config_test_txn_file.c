@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_nffs.h"
+
+#if MYNEWT_VAL(CONFIG_TXN)
+static void
+config_test_txn_file_mount(struct conf_file *cf)
+{
+    int rc;
+
+    config_wipe_srcs();
+    memset(cf, 0, sizeof(*cf));
+    cf->cf_name = "/config/txn";
+    cf->cf_maxlines = 16;
+    rc = conf_file_src(cf);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_file_dst(cf);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+}
+
+static void
+config_test_txn_file_check(const char *name, const char *val)
+{
+    char buf[CONF_MAX_VAL_LEN];
+    int rc;
+
+    rc = conf_get_stored_value((char *)name, buf, sizeof(buf));
+    if (!val) {
+        TEST_ASSERT(rc == OS_ENOENT);
+        return;
+    }
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!strcmp(buf, val));
+}
+#endif
+
+TEST_CASE(config_test_txn_file)
+{
+#if MYNEWT_VAL(CONFIG_TXN)
+    struct conf_file cf;
+    /* Commit which got interrupted in the middle of a line */
+    const char cf_torn[] = "txn/a=1\n#txn-begin\ntxn/a=9\ntxn/c=9\ntxn/b=";
+    char name[CONF_MAX_NAME_LEN];
+    char val[16];
+    int round;
+    int rc;
+    int i;
+
+    rc = fs_mkdir("/config");
+    TEST_ASSERT(rc == 0 || rc == FS_EEXIST);
+    rc = fsutil_write_file("/config/txn", cf_torn, sizeof(cf_torn) - 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    config_test_txn_file_mount(&cf);
+    config_test_txn_file_check("txn/a", "1");
+    config_test_txn_file_check("txn/b", NULL);
+    config_test_txn_file_check("txn/c", NULL);
+
+    /*
+     * Transaction is closed before anything else gets written.
+     */
+    rc = conf_save_one("txn/d", "1");
+    TEST_ASSERT(rc == 0);
+    rc = conf_test_file_strstr(cf.cf_name, "txn/b=\n#txn-abort\ntxn/d=1\n");
+    TEST_ASSERT(rc == 0);
+    config_test_txn_file_mount(&cf);
+    config_test_txn_file_check("txn/a", "1");
+    config_test_txn_file_check("txn/c", NULL);
+    config_test_txn_file_check("txn/d", "1");
+
+    /*
+     * Only the last value of a name is written.
+     */
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_save_one("txn/a", "2");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/b", "2");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/a", "3");
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("txn/d", "1");
+    TEST_ASSERT(rc == 0);
+    rc = conf_test_file_strstr(cf.cf_name, "txn/b=2");
+    TEST_ASSERT(rc != 0);
+    rc = conf_txn_commit();
+    TEST_ASSERT(rc == 0);
+    rc = conf_test_file_strstr(cf.cf_name,
+      "#txn-begin\ntxn/b=2\ntxn/a=3\n#txn-commit\n");
+    TEST_ASSERT(rc == 0);
+    config_test_txn_file_mount(&cf);
+    config_test_txn_file_check("txn/a", "3");
+    config_test_txn_file_check("txn/b", "2");
+
+    rc = conf_txn_begin();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = conf_save_one("txn/a", "5");
+    TEST_ASSERT(rc == 0);
+    rc = conf_txn_abort();
+    TEST_ASSERT(rc == 0);
+    config_test_txn_file_check("txn/a", "3");
+
+    /*
+     * Compressing the file keeps committed values only.
+     */
+    for (round = 0; round < 10; round++) {
+        rc = conf_txn_begin();
+        TEST_ASSERT_FATAL(rc == 0);
+        for (i = 0; i < 4; i++) {
+            snprintf(name, sizeof(name), "cmp/%d", i);
+            snprintf(val, sizeof(val), "%d", round + i);
+            rc = conf_save_one(name, val);
+            TEST_ASSERT(rc == 0);
+        }
+        rc = conf_txn_commit();
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    rc = conf_test_file_strstr(cf.cf_name, "txn/c=9");
+    TEST_ASSERT(rc != 0);
+
+    config_test_txn_file_mount(&cf);
+    for (i = 0; i < 4; i++) {
+        snprintf(name, sizeof(name), "cmp/%d", i);
+        snprintf(val, sizeof(val), "%d", round - 1 + i);
+        config_test_txn_file_check(name, val);
+    }
+    config_test_txn_file_check("txn/a", "3");
+    config_test_txn_file_check("txn/b", "2");
+    config_test_txn_file_check("txn/c", NULL);
+    config_test_txn_file_check("txn/d", "1");
+#endif
+}
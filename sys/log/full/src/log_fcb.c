@@ -214,25 +214,125 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
     return 0;
 }
 
+/**
+ * Staging state for writing a sequence of discontiguous buffers to a flash
+ * entry.  Each buffer is written in place, in whole multiples of the flash
+ * alignment; only the few bytes that straddle two buffers are copied into
+ * the bounce buffer.
+ */
+struct log_fcb_writer {
+    struct fcb_entry *lfw_loc;
+    uint8_t lfw_align;
+    uint8_t lfw_buf_len;
+    uint8_t lfw_buf[LOG_FCB_MAX_ALIGN];
+};
+
 static int
-log_fcb_write_mbuf(struct fcb_entry *loc, const struct os_mbuf *om)
+log_fcb_writer_put(struct log_fcb_writer *w, const uint8_t *data, int len)
 {
+    int chunk_sz;
     int rc;
 
-    while (om) {
-        rc = flash_area_write(loc->fe_area, loc->fe_data_off,
-                              om->om_data, om->om_len);
+    /* Complete a partially filled alignment unit first. */
+    if (w->lfw_buf_len > 0) {
+        chunk_sz = min(w->lfw_align - w->lfw_buf_len, len);
+        memcpy(w->lfw_buf + w->lfw_buf_len, data, chunk_sz);
+        w->lfw_buf_len += chunk_sz;
+        data += chunk_sz;
+        len -= chunk_sz;
+
+        if (w->lfw_buf_len < w->lfw_align) {
+            return 0;
+        }
+
+        rc = flash_area_write(w->lfw_loc->fe_area, w->lfw_loc->fe_data_off,
+                              w->lfw_buf, w->lfw_align);
         if (rc != 0) {
             return SYS_EIO;
         }
+        w->lfw_loc->fe_data_off += w->lfw_align;
+        w->lfw_buf_len = 0;
+    }
 
-        loc->fe_data_off += om->om_len;
-        om = SLIST_NEXT(om, om_next);
+    /* Write the aligned part straight from the source. */
+    chunk_sz = len & ~(w->lfw_align - 1);
+    if (chunk_sz > 0) {
+        rc = flash_area_write(w->lfw_loc->fe_area, w->lfw_loc->fe_data_off,
+                              data, chunk_sz);
+        if (rc != 0) {
+            return SYS_EIO;
+        }
+        w->lfw_loc->fe_data_off += chunk_sz;
+        data += chunk_sz;
+        len -= chunk_sz;
     }
 
+    /* Hold on to the tail until the next buffer completes it. */
+    memcpy(w->lfw_buf, data, len);
+    w->lfw_buf_len = len;
+
     return 0;
 }
 
+static int
+log_fcb_writer_flush(struct log_fcb_writer *w)
+{
+    int rc;
+
+    if (w->lfw_buf_len == 0) {
+        return 0;
+    }
+
+    rc = flash_area_write(w->lfw_loc->fe_area, w->lfw_loc->fe_data_off,
+                          w->lfw_buf, w->lfw_buf_len);
+    if (rc != 0) {
+        return SYS_EIO;
+    }
+    w->lfw_loc->fe_data_off += w->lfw_buf_len;
+    w->lfw_buf_len = 0;
+
+    return 0;
+}
+
+/**
+ * Writes an optional header followed by the contents of an mbuf chain to a
+ * flash entry, honoring the flash write alignment without flattening the
+ * chain.
+ */
+static int
+log_fcb_write_mbuf(struct fcb *fcb, struct fcb_entry *loc,
+                   const struct log_entry_hdr *hdr, const struct os_mbuf *om)
+{
+    struct log_fcb_writer w;
+    struct os_mbuf_iter it;
+    const uint8_t *data;
+    int len;
+    int rc;
+
+    w.lfw_loc = loc;
+    w.lfw_align = fcb->f_align;
+    w.lfw_buf_len = 0;
+
+    if (hdr != NULL) {
+        rc = log_fcb_writer_put(&w, (const uint8_t *)hdr, sizeof *hdr);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    if (os_mbuf_iter_init(&it, om, 0) == 0) {
+        while ((len = os_mbuf_iter_seg(&it, &data)) > 0) {
+            rc = log_fcb_writer_put(&w, data, len);
+            if (rc != 0) {
+                return rc;
+            }
+            os_mbuf_iter_advance(&it, len);
+        }
+    }
+
+    return log_fcb_writer_flush(&w);
+}
+
 static int
 log_fcb_append_mbuf(struct log *log, const struct os_mbuf *om)
 {
@@ -245,11 +345,7 @@ log_fcb_append_mbuf(struct log *log, const struct os_mbuf *om)
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    /* This function expects to be able to write each mbuf without any
-     * buffering.
-     */
-    /* XXX: Fix this; buffer mbuf writes to satisfy flash alignment. */
-    if (fcb->f_align != 1) {
+    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
         return SYS_ENOTSUP;
     }
 
@@ -259,7 +355,7 @@ log_fcb_append_mbuf(struct log *log, const struct os_mbuf *om)
         return rc;
     }
 
-    rc = log_fcb_write_mbuf(&loc, om);
+    rc = log_fcb_write_mbuf(fcb, &loc, NULL, om);
     if (rc != 0) {
         return rc;
     }
@@ -285,10 +381,7 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
     fcb_log = (struct fcb_log *)log->l_arg;
     fcb = &fcb_log->fl_fcb;
 
-    /* This function expects to be able to write each mbuf without any
-     * buffering.
-     */
-    if (fcb->f_align != 1) {
+    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
         return SYS_ENOTSUP;
     }
 
@@ -298,13 +391,7 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
-    rc = flash_area_write(loc.fe_area, loc.fe_data_off, hdr, sizeof *hdr);
-    if (rc != 0) {
-        return rc;
-    }
-    loc.fe_data_off += sizeof *hdr;
-
-    rc = log_fcb_write_mbuf(&loc, om);
+    rc = log_fcb_write_mbuf(fcb, &loc, hdr, om);
     if (rc != 0) {
         return rc;
     }
@@ -81,6 +81,194 @@ shell_os_tasks_display_cmd(int argc, char **argv)
     return 0;
 }
 
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+/**
+ * Lists the stack high-water mark of every task along with a recommended
+ * stack size: the mark plus OS_TASK_STACK_WATERMARK_MARGIN percent.  Sizes
+ * are in os_stack_t units.
+ */
+int
+shell_os_stacks_display_cmd(int argc, char **argv)
+{
+    struct os_task *prev_task;
+    struct os_task_info oti;
+    uint32_t total_sz;
+    uint32_t total_rec;
+    uint32_t rec;
+
+    total_sz = 0;
+    total_rec = 0;
+
+    console_printf("%8s %8s %8s %8s %8s\n",
+      "task", "stksz", "stkhwm", "stkrec", "spare");
+    prev_task = NULL;
+    while (1) {
+        prev_task = os_task_info_get_next(prev_task, &oti);
+        if (prev_task == NULL) {
+            break;
+        }
+
+        rec = oti.oti_stkhwm *
+              (100 + MYNEWT_VAL(OS_TASK_STACK_WATERMARK_MARGIN)) / 100;
+        rec = OS_STACK_ALIGN(rec);
+        total_sz += oti.oti_stksize;
+        total_rec += rec;
+
+        console_printf("%8s %8u %8u %8lu %8ld%s\n",
+                oti.oti_name, oti.oti_stksize, oti.oti_stkhwm,
+                (unsigned long)rec, (long)oti.oti_stksize - (long)rec,
+                rec > oti.oti_stksize ? " grow" : "");
+    }
+
+    console_printf("%8s %8lu %8s %8lu %8ld\n", "total",
+            (unsigned long)total_sz, "", (unsigned long)total_rec,
+            (long)total_sz - (long)total_rec);
+    console_printf("spare bytes: %ld\n",
+            ((long)total_sz - (long)total_rec) * (long)sizeof(os_stack_t));
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_TASK_PROF)
+int
+shell_os_taskprof_display_cmd(int argc, char **argv)
+{
+    struct os_task_prof tp;
+    struct os_task *prev_task;
+    struct os_task_info oti;
+    char *name;
+    int found;
+    int i;
+
+    name = NULL;
+    found = 0;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        os_task_prof_reset();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "")) {
+        name = argv[1];
+    }
+
+    console_printf("Latency buckets (usecs):");
+    for (i = 0; i < MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS) - 1; i++) {
+        console_printf(" <%lu", (unsigned long)os_cputime_ticks_to_usecs(
+                    1UL << (MYNEWT_VAL(OS_TASK_PROF_HIST_SHIFT) + i)));
+    }
+    console_printf(" more\n");
+
+    console_printf("%8s %10s %8s %8s ",
+      "task", "run_ms", "slice_us", "lat_us");
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+    console_printf("%8s ", "crit_us");
+#endif
+    console_printf("lathist\n");
+    prev_task = NULL;
+    while (1) {
+        prev_task = os_task_info_get_next(prev_task, &oti);
+        if (prev_task == NULL) {
+            break;
+        }
+
+        if (name) {
+            if (strcmp(name, oti.oti_name)) {
+                continue;
+            } else {
+                found = 1;
+            }
+        }
+
+        os_task_prof_get(prev_task, &tp);
+        console_printf("%8s %10lu %8lu %8lu",
+                oti.oti_name,
+                (unsigned long)(tp.tp_run_time * 1000 /
+                                MYNEWT_VAL(OS_CPUTIME_FREQ)),
+                (unsigned long)os_cputime_ticks_to_usecs(tp.tp_slice_max),
+                (unsigned long)os_cputime_ticks_to_usecs(tp.tp_lat_max));
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+        console_printf(" %8lu",
+                (unsigned long)os_cputime_ticks_to_usecs(tp.tp_crit_max));
+#endif
+        for (i = 0; i < MYNEWT_VAL(OS_TASK_PROF_HIST_BUCKETS); i++) {
+            console_printf(" %lu", (unsigned long)tp.tp_lat_hist[i]);
+        }
+        console_printf("\n");
+    }
+
+    if (name && !found) {
+        console_printf("Couldn't find task with name %s\n", name);
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+int
+shell_os_crit_display_cmd(int argc, char **argv)
+{
+    struct os_crit_info oci[MYNEWT_VAL(OS_CRIT_TRACE_TOP_N)];
+    int cnt;
+    int i;
+
+    if (argc > 1 && !strcmp(argv[1], "reset")) {
+        os_crit_trace_reset();
+        return 0;
+    }
+
+    cnt = os_crit_trace_get(oci, MYNEWT_VAL(OS_CRIT_TRACE_TOP_N));
+
+    console_printf("Critical sections: \n");
+    console_printf("%10s %8s\n", "caller", "usecs");
+    for (i = 0; i < cnt; i++) {
+        console_printf("0x%08lx %8lu\n", (unsigned long)oci[i].oci_ra,
+                (unsigned long)os_cputime_ticks_to_usecs(oci[i].oci_ticks));
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+static int
+shell_os_mpool_sites_cmd(int argc, char **argv)
+{
+    struct os_mempool_site sites[MYNEWT_VAL(OS_MEMPOOL_TRACK_MAX_SITES)];
+    struct os_mempool_info omi;
+    struct os_mempool *mp;
+    os_time_t now;
+    int cnt;
+    int i;
+
+    now = os_time_get();
+    console_printf("%32s %10s %5s %8s\n", "name", "site", "cnt", "age_ms");
+    mp = NULL;
+    while (1) {
+        mp = os_mempool_info_get_next(mp, &omi);
+        if (mp == NULL) {
+            break;
+        }
+        if (argc > 2 && strcmp(argv[2], omi.omi_name)) {
+            continue;
+        }
+
+        cnt = os_mempool_track_sites(mp, sites,
+                                     MYNEWT_VAL(OS_MEMPOOL_TRACK_MAX_SITES));
+        for (i = 0; i < cnt; i++) {
+            console_printf("%32s 0x%08lx %5u %8lu\n", omi.omi_name,
+                           (unsigned long)sites[i].oms_site,
+                           sites[i].oms_count,
+                           (unsigned long)os_time_ticks_to_ms32(
+                               now - sites[i].oms_oldest));
+        }
+    }
+
+    return 0;
+}
+#endif
+
 int
 shell_os_mpool_display_cmd(int argc, char **argv)
 {
@@ -92,6 +280,12 @@ shell_os_mpool_display_cmd(int argc, char **argv)
     name = NULL;
     found = 0;
 
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+    if (argc > 1 && !strcmp(argv[1], "sites")) {
+        return shell_os_mpool_sites_cmd(argc, argv);
+    }
+#endif
+
     if (argc > 1 && strcmp(argv[1], "")) {
         name = argv[1];
     }
@@ -202,8 +396,44 @@ static const struct shell_cmd_help tasks_help = {
     .params = tasks_params,
 };
 
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+static const struct shell_cmd_help stacks_help = {
+    .summary = "show task stack high-water marks and recommended sizes"
+};
+#endif
+
+#if MYNEWT_VAL(OS_TASK_PROF)
+static const struct shell_param taskprof_params[] = {
+    {"", "task name"},
+    {"reset", "clear all task profiles"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help taskprof_help = {
+    .summary = "show task run time and scheduling latency profile",
+    .usage = NULL,
+    .params = taskprof_params,
+};
+#endif
+
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+static const struct shell_param crit_params[] = {
+    {"reset", "clear the table"},
+    {NULL, NULL}
+};
+
+static const struct shell_cmd_help crit_help = {
+    .summary = "show longest critical sections",
+    .usage = NULL,
+    .params = crit_params,
+};
+#endif
+
 static const struct shell_param mpool_params[] = {
     {"", "mpool name"},
+#if MYNEWT_VAL(OS_MEMPOOL_TRACK)
+    {"sites", "list allocated blocks by allocation site [mpool name]"},
+#endif
     {NULL, NULL}
 };
 
@@ -250,6 +480,33 @@ static const struct shell_cmd os_commands[] = {
         .help = &tasks_help,
 #endif
     },
+#if MYNEWT_VAL(OS_TASK_STACK_WATERMARK)
+    {
+        .sc_cmd = "stacks",
+        .sc_cmd_func = shell_os_stacks_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &stacks_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(OS_TASK_PROF)
+    {
+        .sc_cmd = "taskprof",
+        .sc_cmd_func = shell_os_taskprof_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &taskprof_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(OS_CRIT_TRACE)
+    {
+        .sc_cmd = "crit",
+        .sc_cmd_func = shell_os_crit_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &crit_help,
+#endif
+    },
+#endif
     {
         .sc_cmd = "mpool",
         .sc_cmd_func = shell_os_mpool_display_cmd,
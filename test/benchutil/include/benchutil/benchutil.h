@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BENCHUTIL_
+#define H_BENCHUTIL_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @addtogroup OSSystem
+  * @{
+  *   @defgroup OSBenchutil Benchmark Utilities
+  *   @{
+  */
+
+/*
+ * A benchmark suite is a sequence of cases run between bench_suite_start()
+ * and bench_suite_end().  Each case is a function which performs the
+ * measured operation 'iters' times.  bench_run() calls it with a growing
+ * iteration count until a single call takes at least BENCHUTIL_MIN_TIME_MS,
+ * then prints the result of that last call on the console as one line:
+ *
+ *     bench suite=<suite> case=<case> iters=<n> usecs=<n> ns_per_op=<n>
+ *
+ * The suite is framed by "bench suite=<suite> start" and
+ * "bench suite=<suite> end cases=<n>" lines.  All values are decimal
+ * integers, so the output can be collected and compared between releases.
+ */
+
+/**
+ * Function implementing a benchmark case.
+ *
+ * @param iters                 The number of times to perform the measured
+ *                                  operation.
+ * @param arg                   The argument passed to bench_run().
+ */
+typedef void bench_case_fn_t(uint32_t iters, void *arg);
+
+struct bench_result {
+    /** Number of iterations of the reported run. */
+    uint32_t br_iters;
+
+    /** Duration of the reported run, in microseconds. */
+    uint32_t br_usecs;
+
+    /** Average duration of one iteration, in nanoseconds. */
+    uint32_t br_ns_per_op;
+};
+
+/**
+ * Starts a benchmark suite.
+ *
+ * @param name                  The name of the suite.
+ */
+void bench_suite_start(const char *name);
+
+/**
+ * Ends the current benchmark suite.
+ *
+ * @return                      The number of cases run in the suite.
+ */
+int bench_suite_end(void);
+
+/**
+ * Runs and reports a benchmark case as part of the current suite.
+ *
+ * @param name                  The name of the case.
+ * @param fn                    The function implementing the case.
+ * @param arg                   Argument passed to the function.
+ * @param out_result            On success, the result gets written here.
+ *                                  Pass NULL if you do not require it.
+ *
+ * @return                      0 on success;
+ *                              OS_TIMEOUT if the case did not reach
+ *                                  BENCHUTIL_MIN_TIME_MS within
+ *                                  BENCHUTIL_MAX_ITERS iterations.  The
+ *                                  result of the last run is still
+ *                                  reported.
+ */
+int bench_run(const char *name, bench_case_fn_t *fn, void *arg,
+              struct bench_result *out_result);
+
+/**
+ * Runs and reports a benchmark case named after its function.
+ */
+#define BENCH_RUN(fn, arg) bench_run(#fn, (fn), (arg), NULL)
+
+/**
+ *   @} OSBenchutil
+ * @} OSSystem
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
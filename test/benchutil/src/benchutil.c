@@ -0,0 +1,158 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "console/console.h"
+#include "benchutil/benchutil.h"
+
+#if MYNEWT_VAL(BSP_SIMULATED)
+#include <time.h>
+#endif
+
+#define BENCH_MIN_USECS     (MYNEWT_VAL(BENCHUTIL_MIN_TIME_MS) * 1000)
+
+/* Largest factor by which the iteration count grows between two runs. */
+#define BENCH_MAX_GROWTH    (100)
+
+static const char *bench_suite_name;
+static int bench_suite_cases;
+
+#if MYNEWT_VAL(BSP_SIMULATED)
+
+/*
+ * On sim, os_cputime is derived from the OS tick, which is too coarse (and,
+ * without signals, does not advance while a task is busy).  Use the host's
+ * monotonic clock instead; its unit is the microsecond.
+ */
+static uint32_t
+bench_clock_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t
+bench_clock_to_usecs(uint32_t delta)
+{
+    return delta;
+}
+
+#else
+
+static uint32_t
+bench_clock_get(void)
+{
+    return os_cputime_get32();
+}
+
+static uint32_t
+bench_clock_to_usecs(uint32_t delta)
+{
+    return os_cputime_ticks_to_usecs(delta);
+}
+
+#endif
+
+void
+bench_suite_start(const char *name)
+{
+    bench_suite_name = name;
+    bench_suite_cases = 0;
+
+    console_printf("bench suite=%s start\n", name);
+}
+
+int
+bench_suite_end(void)
+{
+    console_printf("bench suite=%s end cases=%d\n", bench_suite_name,
+                   bench_suite_cases);
+
+    return bench_suite_cases;
+}
+
+/**
+ * Calculates the iteration count of the next run of a case from the
+ * duration of the previous one, aiming 20% past the minimum duration.
+ */
+static uint32_t
+bench_next_iters(uint32_t iters, uint32_t usecs)
+{
+    uint64_t next;
+
+    if (usecs == 0) {
+        next = (uint64_t)iters * BENCH_MAX_GROWTH;
+    } else {
+        next = (uint64_t)iters * BENCH_MIN_USECS * 6 / 5 / usecs;
+        if (next > (uint64_t)iters * BENCH_MAX_GROWTH) {
+            next = (uint64_t)iters * BENCH_MAX_GROWTH;
+        }
+    }
+    if (next <= iters) {
+        next = iters + 1;
+    }
+    if (next > MYNEWT_VAL(BENCHUTIL_MAX_ITERS)) {
+        next = MYNEWT_VAL(BENCHUTIL_MAX_ITERS);
+    }
+
+    return next;
+}
+
+int
+bench_run(const char *name, bench_case_fn_t *fn, void *arg,
+          struct bench_result *out_result)
+{
+    struct bench_result res;
+    uint32_t start;
+    int rc;
+
+    res.br_iters = 1;
+    while (1) {
+        start = bench_clock_get();
+        fn(res.br_iters, arg);
+        res.br_usecs = bench_clock_to_usecs(bench_clock_get() - start);
+
+        if (res.br_usecs >= BENCH_MIN_USECS) {
+            rc = 0;
+            break;
+        }
+        if (res.br_iters >= MYNEWT_VAL(BENCHUTIL_MAX_ITERS)) {
+            rc = OS_TIMEOUT;
+            break;
+        }
+        res.br_iters = bench_next_iters(res.br_iters, res.br_usecs);
+    }
+
+    res.br_ns_per_op = (uint64_t)res.br_usecs * 1000 / res.br_iters;
+    bench_suite_cases++;
+
+    console_printf("bench suite=%s case=%s iters=%lu usecs=%lu "
+                   "ns_per_op=%lu\n",
+                   bench_suite_name, name, (unsigned long)res.br_iters,
+                   (unsigned long)res.br_usecs,
+                   (unsigned long)res.br_ns_per_op);
+
+    if (out_result != NULL) {
+        *out_result = res;
+    }
+
+    return rc;
+}